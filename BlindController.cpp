@@ -3,6 +3,7 @@
 // 
 
 #include "BlindController.h"
+#include "RecordFile.h"
 #include "debug.h"
 #include <functional>
 
@@ -17,594 +18,2005 @@ constexpr auto DOWN_BUTTON_PIN = 4;
 constexpr auto ROLLING_TIME = 30000;
 constexpr auto NOTIF_PERIOD_RATIO = 5;
 constexpr auto KEEP_ALIVE_PERIOD_RATIO = 4;
+constexpr auto REPORT_JITTER_RATIO = 8; ///< @brief Keep alive and periodic notifications come up to this fraction of their period early
 constexpr auto ON_STATE_DEFAULT = HIGH;
-
-constexpr auto CONFIG_FILE = "/blindconf.json"; ///< @brief blind controller configuration file name
+constexpr auto CURVE_PROFILE_DEFAULT = CURVE_AWNING;
+constexpr auto REPORT_STEP_DEFAULT = 20; ///< @brief Position change that triggers a notification while moving, in %
+constexpr auto REPORT_MIN_INTERVAL_DEFAULT = 2000; ///< @brief Minimum time between position notifications while moving, in ms
+constexpr auto REPORT_MAX_INTERVAL_DEFAULT = 600000; ///< @brief Maximum time without notifications, in ms
+constexpr auto RELAY_DEAD_TIME_DEFAULT = 500; ///< @brief Time with both relays off before reversing direction, in ms
+
+// CayenneLPP telemetry layout. Every value is sent as digital input type
+constexpr auto LPP_STATE_CHANNEL = 1; ///< @brief Blind state (blindState_t)
+constexpr auto LPP_POSITION_CHANNEL = 2; ///< @brief Blind position 0-100. 255 means unknown
+constexpr auto LPP_UP_BUTTON_CHANNEL = 3; ///< @brief Number of up button presses
+constexpr auto LPP_DOWN_BUTTON_CHANNEL = 4; ///< @brief Number of down button presses
+constexpr auto LPP_CHANNELS_PER_BLIND = 4; ///< @brief Every blind uses the next set of channels
+constexpr auto LPP_FRAME_SIZE = 6; ///< @brief Size of largest frame (state + position)
+
+constexpr auto CONFIG_FILE = "/blindconf.bin"; ///< @brief blind controller configuration file name
+constexpr auto CONFIG_JSON_FILE = "/blindconf.json"; ///< @brief Configuration file used by older versions. Imported if present
+constexpr auto CONFIG_MAGIC = 0x46434C42; ///< @brief "BLCF"
+constexpr auto CONFIG_VERSION = 9; ///< @brief `blindConfigRecord_t` layout version
+
+#define RECORD_END(field) (offsetof (blindConfigRecord_t, field) + sizeof (blindConfigRecord_t::field))
+/**
+  * @brief Length of every `blindConfigRecord_t` version up to its last field. Older firmware stored `sizeof` of its
+  * record, so padding after last field has to be left out when reading
+  */
+static const uint16_t configRecordLength[CONFIG_VERSION] = {
+	RECORD_END (curvePoints), // 1
+	RECORD_END (channelTravellingTime), // 2
+	RECORD_END (runOnTime), // 3
+	RECORD_END (groups), // 4
+	RECORD_END (clockSync), // 5
+	RECORD_END (relayDeadTime), // 6
+	RECORD_END (downPressPreset), // 7
+	RECORD_END (utcOffset), // 8
+	RECORD_END (mergedResponse), // 9
+};
+#undef RECORD_END
 
 constexpr auto BUTTON_DELAY = 50;
 constexpr auto BUTTON_REPEAT = 200;
-
-const char* commandKey = "cmd";
-const char* positionCommandValue = "pos";
-const char* stateCommandValue = "state";
-const char* fullUpCommandValue = "uu";
-const char* fullDownCommandValue = "dd";
-const char* gotoCommandValue = "go";
-const char* stopCommandValue = "stop";
-//const char* startCommandValue = "start";
-const char* travelTimeValue = "time";
-const char* resultKey = "res";
-const char* positionKey = "pos";
-const char* memKey = "mem";
-const char* eventValue = "event";
-const char* buttonKey = "but";
-const char* upButtonValue = "up";
-const char* downButtonValue = "down";
-const char* countNumberKey = "num";
-
-const uint8_t pos_len_lut[] = { 0,  0,  0,  0,  0,  0,  0,  1,  1,  1, // 0  -  9
-								 1,  2,  2,  2,  2,  3,  3,  4,  4,  4, // 10 - 19
-								 5,  5,  6,  6,  7,  8,  8,  9,  9, 10, // 20 - 29
-								11, 12, 13, 13, 14, 15, 16, 17, 17, 18, // 30 - 39
-								19, 20, 21, 22, 23, 24, 25, 26, 27, 28, // 40 - 49
-								29, 30, 32, 33, 34, 35, 36, 38, 39, 40, // 50 - 59
-								41, 43, 44, 45, 46, 48, 49, 51, 52, 53, // 60 - 69
-								55, 56, 58, 59, 60, 62, 63, 65, 66, 67, // 70 - 79
-								69, 71, 72, 73, 75, 77, 78, 80, 81, 83, // 80 - 89
-								84, 86, 87, 89, 90, 92, 94, 95, 97, 98, // 90 - 99
-								100 };									// 100
-
-bool CONTROLLER_CLASS_NAME::processRxCommand (const uint8_t* mac, const uint8_t* buffer, uint8_t length, nodeMessageType_t command, nodePayloadEncoding_t payloadEncoding) {
-	// TODO
+constexpr auto IDLE_POLL_PERIOD = 20; ///< @brief Maximum time between button polls when idle, in ms
+constexpr auto MAX_SCHEDULE_DELAY = 3600000; ///< @brief Maximum time in advance a movement may be scheduled, in ms
+constexpr auto PRESET_BYTE_MAX = 0x7F; ///< @brief One byte payloads up to this value are preset recalls. It is a positive integer on MsgPack
+constexpr auto SCHEDULE_MIN_TIME = 1577836800000LL; ///< @brief 2020-01-01. Earlier network time means that clock is not synchronized yet
+constexpr auto SCHEDULE_RETRY_PERIOD = 1000; ///< @brief Time between clock checks while it is not synchronized, in ms
+constexpr auto SCHEDULE_MAX_CATCH_UP = 5; ///< @brief Entries up to this many minutes late, after a slow loop or a small clock step, are still run
+constexpr auto SCHEDULE_EVERY_DAY = 0x7F; ///< @brief Weekday mask of entries without `days` key
+constexpr auto MINUTES_PER_DAY = 1440;
+constexpr auto MAX_UTC_OFFSET = 14 * 60; ///< @brief Largest local time offset, in minutes
+
+constexpr auto commandKey = "cmd";
+constexpr auto positionCommandValue = "pos";
+constexpr auto stateCommandValue = "state";
+constexpr auto fullUpCommandValue = "uu";
+constexpr auto fullDownCommandValue = "dd";
+constexpr auto gotoCommandValue = "go";
+constexpr auto stopCommandValue = "stop";
+//constexpr auto startCommandValue = "start";
+constexpr auto travelTimeValue = "time";
+constexpr auto resultKey = "res";
+constexpr auto positionKey = "pos";
+constexpr auto memKey = "mem";
+constexpr auto eventValue = "event";
+constexpr auto buttonKey = "but";
+constexpr auto upButtonValue = "up";
+constexpr auto downButtonValue = "down";
+constexpr auto countNumberKey = "num";
+constexpr auto channelKey = "ch";
+constexpr auto groupKey = "grp";
+constexpr auto groupsValue = "groups";
+constexpr auto atKey = "at";
+constexpr auto priorityKey = "prio";
+constexpr auto sequenceCommandValue = "seq";
+constexpr auto stepsKey = "steps";
+constexpr auto waitKey = "wait";
+constexpr auto statsCommandValue = "stats";
+constexpr auto loopStatsKey = "loop";
+constexpr auto relayStatsKey = "relay";
+constexpr auto sendStatsKey = "send";
+constexpr auto sendFailuresKey = "fail";
+constexpr auto droppedKey = "drop";
+constexpr auto freeHeapKey = "heap";
+constexpr auto minFreeHeapKey = "minHeap";
+constexpr auto maxBlockKey = "block";
+constexpr auto minMaxBlockKey = "minBlock";
+constexpr auto presetCommandValue = "preset";
+constexpr auto savePresetCommandValue = "save";
+constexpr auto bindPresetCommandValue = "bind";
+constexpr auto idKey = "id";
+constexpr auto presetsKey = "presets";
+constexpr auto scheduleCommandValue = "sched";
+constexpr auto hhmmKey = "hhmm";
+constexpr auto daysKey = "days";
+constexpr auto actionKey = "do";
+constexpr auto jitterKey = "jit";
+constexpr auto utcOffsetKey = "tz";
+constexpr auto getCommandValue = "get";
+constexpr auto keysKey = "keys";
+constexpr auto targetKey = "to";
+constexpr auto timeLeftKey = "eta";
+
+/**
+  * @brief Key of every `responseField_t` value, as sent on responses and asked on `keys` list of `get` command
+  */
+static const struct {
+	const char* key;
+	uint8_t field;
+} responseFields[] = {
+	{ stateCommandValue, FIELD_STATE },
+	{ positionKey, FIELD_POSITION },
+	{ targetKey, FIELD_TARGET },
+	{ timeLeftKey, FIELD_TIME_LEFT },
+	{ travelTimeValue, FIELD_TRAVEL_TIME },
+	{ groupsValue, FIELD_GROUPS },
+};
+
+template <uint8_t CHANNELS>
+const typename MultiBlindController<CHANNELS>::commandEntry_t MultiBlindController<CHANNELS>::commandTable[] = {
+	{ positionCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetPositionCommand },
+	{ stateCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetStateCommand },
+	{ travelTimeValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetTravelTimeCommand },
+	{ fullUpCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processFullUpCommand },
+	{ fullDownCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processFullDownCommand },
+	{ gotoCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processGotoCommand },
+	{ sequenceCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processSequenceCommand },
+	{ stopCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processStopCommand },
+	{ travelTimeValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processSetTravelTimeCommand },
+	{ groupsValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetGroupsCommand },
+	{ groupsValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processSetGroupsCommand },
+	{ statsCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetStatsCommand },
+	{ presetCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetPresetsCommand },
+	{ presetCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processRecallPresetCommand },
+	{ savePresetCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processSavePresetCommand },
+	{ bindPresetCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processBindPresetCommand },
+	{ scheduleCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetScheduleCommand },
+	{ scheduleCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_SET, &MultiBlindController::processSetScheduleCommand },
+	{ getCommandValue, nodeMessageType_t::DOWNSTREAM_DATA_GET, &MultiBlindController::processGetFieldsCommand },
+};
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processRxCommand (const uint8_t*, const uint8_t* buffer, uint8_t length, nodeMessageType_t command, nodePayloadEncoding_t payloadEncoding) {
+	rxStarted = LatencyHistogram::start ();
 	if (command != nodeMessageType_t::DOWNSTREAM_DATA_GET && command != nodeMessageType_t::DOWNSTREAM_DATA_SET) {
 		DEBUG_WARN ("Wrong message type");
 		return false;
 	}
-	if (payloadEncoding != MSG_PACK) {
+
+	blindCommand_t rxCommand;
+	if (length == 1 && buffer[0] <= PRESET_BYTE_MAX && command == nodeMessageType_t::DOWNSTREAM_DATA_SET && (payloadEncoding == MSG_PACK || payloadEncoding == RAW)) {
+		decodePresetByte (buffer[0], rxCommand);
+	} else if (payloadEncoding != MSG_PACK) {
 		DEBUG_WARN ("Wrong payload encoding");
 		return false;
+	} else if (!decodeCommand (buffer, length, rxCommand)) {
+		DEBUG_WARN ("Error decoding command");
+		return false;
+	}
+	DEBUG_INFO ("Command: %d = %s", command, command == nodeMessageType_t::DOWNSTREAM_DATA_GET ? "GET" : "SET");
+	DEBUG_VERBOSE ("Data: cmd = %.*s ch = %d pos = %d time = %d", (int)rxCommand.cmdLen, rxCommand.cmd, rxCommand.channel, rxCommand.pos, rxCommand.time);
+	if (rxCommand.hasGroup) {
+		return processGroupCommand (command, rxCommand);
+	}
+	if (rxCommand.channel < 0 || rxCommand.channel >= CHANNELS || !channelEnabled (rxCommand.channel)) {
+		DEBUG_WARN ("Wrong channel %d", rxCommand.channel);
+		return false;
 	}
 
-	DynamicJsonDocument doc (1000);
-	uint8_t tempBuffer[MAX_MESSAGE_LENGTH];
+	for (const commandEntry_t& entry : commandTable) {
+		if (entry.type == command && MsgPackReader::equals (rxCommand.cmd, rxCommand.cmdLen, entry.name)) {
+			return (this->*entry.handler) (rxCommand);
+		}
+	}
+	DEBUG_WARN ("Unknown command %.*s", (int)rxCommand.cmdLen, rxCommand.cmd);
+	return false;
+}
 
-	memcpy (tempBuffer, buffer, length);
-	DeserializationError error = deserializeMsgPack (doc, tempBuffer, length);
-	if (error != DeserializationError::Ok) {
-		DEBUG_WARN ("Error decoding command: %s", error.c_str ());
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::decodeCommand (const uint8_t* buffer, uint8_t length, blindCommand_t& rxCommand) {
+	MsgPackReader reader (buffer, length);
+	size_t fields;
+	const char* key;
+	size_t keyLen;
+
+	memset (&rxCommand, 0, sizeof (rxCommand));
+	if (!reader.readMapSize (fields)) {
 		return false;
 	}
-	DEBUG_INFO ("Command: %d = %s", command, command == nodeMessageType_t::DOWNSTREAM_DATA_GET ? "GET" : "SET");
-	size_t strLen = measureJson (doc) + 1;
-	char* strBuffer = (char*)malloc (strLen);
-	serializeJson (doc, strBuffer, strLen);
-	DEBUG_VERBOSE ("Data: %s", strBuffer);
-	free (strBuffer);
-
-	if (command == nodeMessageType_t::DOWNSTREAM_DATA_GET) {
-		if (!strcmp (doc[commandKey], positionCommandValue)) {
-			DEBUG_INFO ("Position = %d", getPosition ());
-			if (!sendGetPosition ()) {
-				DEBUG_WARN ("Error sending get position command response");
+	for (size_t i = 0; i < fields; i++) {
+		if (!reader.readString (key, keyLen)) {
+			return false;
+		}
+		if (MsgPackReader::equals (key, keyLen, commandKey)) {
+			if (!reader.readString (rxCommand.cmd, rxCommand.cmdLen)) {
 				return false;
 			}
-		} else if (!strcmp (doc[commandKey], stateCommandValue)) {
-			DEBUG_INFO ("Status = %d", getState ());
-			if (!sendGetStatus ()) {
-				DEBUG_WARN ("Error sending get state command response");
+		} else if (MsgPackReader::equals (key, keyLen, positionKey)) {
+			if (!reader.readInt (rxCommand.pos)) {
 				return false;
 			}
-		} else if (!strcmp (doc[commandKey], travelTimeValue)) {
-			DEBUG_INFO ("Get travel time request");
-			if (!sendGetTravelTime ()) {
-				DEBUG_WARN ("Error sending get travel time command response");
+			rxCommand.hasPos = true;
+		} else if (MsgPackReader::equals (key, keyLen, travelTimeValue)) {
+			if (!reader.readInt (rxCommand.time)) {
 				return false;
 			}
-		}
-	} else if (command == nodeMessageType_t::DOWNSTREAM_DATA_SET) {
-		if (!strcmp (doc[commandKey], fullUpCommandValue)) { // Command full rollup
-			DEBUG_INFO ("Full up request");
-			if (!sendCommandResp (fullUpCommandValue, true)) {
-				DEBUG_WARN ("Error sending Full rollup command response");
+			rxCommand.hasTime = true;
+		} else if (MsgPackReader::equals (key, keyLen, channelKey)) {
+			if (!reader.readInt (rxCommand.channel)) {
+				return false;
+			}
+		} else if (MsgPackReader::equals (key, keyLen, groupKey)) {
+			if (!reader.readInt (rxCommand.group) || rxCommand.group < 0 || rxCommand.group > BLIND_MAX_GROUPS) {
 				return false;
 			}
-			fullRollup ();
-		} else if (!strcmp (doc[commandKey], fullDownCommandValue)) { // Command full rolldown
-			DEBUG_INFO ("Full down request");
-			if (!sendCommandResp (fullDownCommandValue, true)) {
-				DEBUG_WARN ("Error sending Full rolldown command response");
+			rxCommand.hasGroup = true;
+		} else if (MsgPackReader::equals (key, keyLen, groupsValue)) {
+			size_t count;
+			int32_t group;
+			if (!reader.readArraySize (count)) {
 				return false;
 			}
-			fullRolldown ();
-		} else if (!strcmp (doc[commandKey], gotoCommandValue)) { // Command go to position
-			if (!doc.containsKey (positionKey)) {
-				if (!sendCommandResp (gotoCommandValue, false)) {
-					DEBUG_WARN ("Error sending go command response");
+			for (size_t j = 0; j < count; j++) {
+				if (!reader.readInt (group) || group < 1 || group > BLIND_MAX_GROUPS) {
+					return false;
 				}
+				rxCommand.groups |= 1 << (group - 1);
+			}
+			rxCommand.hasGroups = true;
+		} else if (MsgPackReader::equals (key, keyLen, atKey)) {
+			if (!reader.readInt64 (rxCommand.at)) {
+				return false;
+			}
+			rxCommand.hasAt = true;
+		} else if (MsgPackReader::equals (key, keyLen, priorityKey)) {
+			if (!reader.readInt (rxCommand.priority) || rxCommand.priority < 0 || rxCommand.priority > UINT8_MAX) {
+				return false;
+			}
+		} else if (MsgPackReader::equals (key, keyLen, idKey)) {
+			if (!reader.readInt (rxCommand.id)) {
+				return false;
+			}
+			rxCommand.hasId = true;
+		} else if (MsgPackReader::equals (key, keyLen, buttonKey)) {
+			const char* button;
+			size_t buttonLen;
+			if (!reader.readString (button, buttonLen)) {
+				return false;
+			}
+			if (MsgPackReader::equals (button, buttonLen, upButtonValue)) {
+				rxCommand.button = button_t::UP_BUTTON;
+			} else if (MsgPackReader::equals (button, buttonLen, downButtonValue)) {
+				rxCommand.button = button_t::DOWN_BUTTON;
+			} else {
+				return false;
+			}
+			rxCommand.hasButton = true;
+		} else if (MsgPackReader::equals (key, keyLen, countNumberKey)) {
+			if (!reader.readInt (rxCommand.count)) {
+				return false;
+			}
+		} else if (MsgPackReader::equals (key, keyLen, actionKey)) {
+			if (!reader.readString (rxCommand.action, rxCommand.actionLen)) {
+				return false;
+			}
+		} else if (MsgPackReader::equals (key, keyLen, presetCommandValue)) {
+			if (!reader.readInt (rxCommand.preset)) {
 				return false;
 			}
-			int position = doc[positionKey];
-			DEBUG_INFO ("Go to position %d request", position);
-			if (!sendCommandResp (gotoCommandValue, gotoPosition (position))) {
-				DEBUG_WARN ("Error sending go command response");
+			rxCommand.hasPreset = true;
+		} else if (MsgPackReader::equals (key, keyLen, hhmmKey)) {
+			int32_t hhmm;
+			if (!reader.readInt (hhmm) || hhmm < 0 || hhmm / 100 >= 24 || hhmm % 100 >= 60) {
 				return false;
 			}
-		} else if (!strcmp (doc[commandKey], stopCommandValue)) { // Command stop
-			DEBUG_INFO ("Stop request");
-			if (!sendCommandResp (stopCommandValue, true)) {
-				DEBUG_WARN ("Error sending stop command response");
+			rxCommand.minute = hhmm / 100 * 60 + hhmm % 100;
+			rxCommand.hasMinute = true;
+		} else if (MsgPackReader::equals (key, keyLen, daysKey)) {
+			if (!reader.readInt (rxCommand.days) || rxCommand.days < 0 || rxCommand.days > SCHEDULE_EVERY_DAY) {
 				return false;
 			}
-			requestStop ();
-		} else if (!strcmp (doc[commandKey], travelTimeValue)) { // Command set travel time
-			DEBUG_INFO ("Set travel time request");
-			if (doc.containsKey (travelTimeValue)) {
-				DEBUG_DBG ("Found time parameter");
-				setTravelTime (doc[travelTimeValue]);
-				if (!sendGetTravelTime ()) {
-					DEBUG_WARN ("Error sending set travel time command response");
+		} else if (MsgPackReader::equals (key, keyLen, jitterKey)) {
+			if (!reader.readInt (rxCommand.jitter) || rxCommand.jitter < 0 || rxCommand.jitter > MAX_SCHEDULE_DELAY / 1000) {
+				return false;
+			}
+		} else if (MsgPackReader::equals (key, keyLen, utcOffsetKey)) {
+			if (!reader.readInt (rxCommand.utcOffset) || abs (rxCommand.utcOffset) > MAX_UTC_OFFSET) {
+				return false;
+			}
+			rxCommand.hasUtcOffset = true;
+		} else if (MsgPackReader::equals (key, keyLen, keysKey)) {
+			size_t count;
+			if (!reader.readArraySize (count)) {
+				return false;
+			}
+			for (size_t j = 0; j < count; j++) {
+				const char* name;
+				size_t nameLen;
+				uint8_t field = 0;
+				if (!reader.readString (name, nameLen)) {
 					return false;
 				}
-			} else {
-				DEBUG_WARN ("JSON does not contains %s", travelTimeValue);
+				for (const auto& entry : responseFields) {
+					if (MsgPackReader::equals (name, nameLen, entry.key)) {
+						field = entry.field;
+					}
+				}
+				if (!field) {
+					return false;
+				}
+				rxCommand.fields |= field;
+			}
+		} else if (MsgPackReader::equals (key, keyLen, stepsKey)) {
+			size_t count;
+			if (!reader.readArraySize (count) || count > BLIND_QUEUE_SIZE) {
 				return false;
 			}
+			for (size_t j = 0; j < count; j++) {
+				blindStep_t& step = rxCommand.steps[j];
+				size_t stepFields;
+				int32_t value;
+				if (!reader.readMapSize (stepFields)) {
+					return false;
+				}
+				for (size_t k = 0; k < stepFields; k++) {
+					if (!reader.readString (key, keyLen)) {
+						return false;
+					}
+					if (MsgPackReader::equals (key, keyLen, positionKey)) {
+						if (!reader.readInt (value)) {
+							return false;
+						}
+						step.action = ACTION_GOTO;
+						step.pos = constrain (value, 0, 100);
+					} else if (MsgPackReader::equals (key, keyLen, waitKey)) {
+						if (!reader.readInt (value) || value < 0 || value > MAX_SCHEDULE_DELAY) {
+							return false;
+						}
+						step.action = ACTION_WAIT;
+						step.wait = value;
+					} else if (!reader.skip ()) {
+						return false;
+					}
+				}
+				if (step.action == ACTION_NONE) {
+					return false;
+				}
+			}
+			rxCommand.stepCount = count;
+		} else if (!reader.skip ()) {
+			return false;
+		}
+	}
+	return rxCommand.cmd != NULL;
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::decodePresetByte (uint8_t value, blindCommand_t& rxCommand) {
+	memset (&rxCommand, 0, sizeof (rxCommand));
+	rxCommand.cmd = presetCommandValue;
+	rxCommand.cmdLen = strlen (presetCommandValue);
+	rxCommand.channel = value >> 4;
+	rxCommand.id = value & 0x0F;
+	rxCommand.hasId = true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetPositionCommand (const blindCommand_t& rxCommand) {
+	updateState (rxCommand.channel); // Position is only updated on deadlines while moving
+	DEBUG_INFO ("Position = %d", getAngle (rxCommand.channel));
+	if (!sendGetPosition (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending get position command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetStateCommand (const blindCommand_t& rxCommand) {
+	updateState (rxCommand.channel);
+	DEBUG_INFO ("Status = %d", getState (rxCommand.channel));
+	if (!sendGetStatus (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending get state command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetTravelTimeCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Get travel time request");
+	if (!sendGetTravelTime (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending get travel time command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processFullUpCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Full up request");
+	if (!sendCommandResp (fullUpCommandValue, startAction (rxCommand.channel, ACTION_FULL_UP, rxCommand), rxCommand.channel)) {
+		DEBUG_WARN ("Error sending Full rollup command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processFullDownCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Full down request");
+	if (!sendCommandResp (fullDownCommandValue, startAction (rxCommand.channel, ACTION_FULL_DOWN, rxCommand), rxCommand.channel)) {
+		DEBUG_WARN ("Error sending Full rolldown command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGotoCommand (const blindCommand_t& rxCommand) {
+	if (!rxCommand.hasPos) {
+		if (!sendCommandResp (gotoCommandValue, false, rxCommand.channel)) {
+			DEBUG_WARN ("Error sending go command response");
+		}
+		return false;
+	}
+	DEBUG_INFO ("Go to position %d request", rxCommand.pos);
+	if (!sendCommandResp (gotoCommandValue, startAction (rxCommand.channel, ACTION_GOTO, rxCommand), rxCommand.channel)) {
+		DEBUG_WARN ("Error sending go command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processSequenceCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Sequence request with %d steps", rxCommand.stepCount);
+	bool result = rxCommand.stepCount > 0 && enqueue (rxCommand.channel, rxCommand.steps, rxCommand.stepCount, rxCommand) && runQueue (rxCommand.channel, true);
+	if (!sendCommandResp (sequenceCommandValue, result, rxCommand.channel)) {
+		DEBUG_WARN ("Error sending sequence command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processStopCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Stop request");
+	bool merged = mergeResponses ();
+	if (merged) {
+		requestStop (rxCommand.channel, false); // Response carries final position
+	}
+	if (!sendCommandResp (stopCommandValue, true, rxCommand.channel)) {
+		DEBUG_WARN ("Error sending stop command response");
+		return false;
+	}
+	if (!merged) {
+		requestStop (rxCommand.channel);
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processSetTravelTimeCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Set travel time request");
+	if (!rxCommand.hasTime) {
+		DEBUG_WARN ("Command does not contain %s", travelTimeValue);
+		return false;
+	}
+	DEBUG_DBG ("Found time parameter");
+	setTravelTime (rxCommand.channel, rxCommand.time);
+	if (!sendGetTravelTime (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending set travel time command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetGroupsCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Get groups request");
+	if (!sendGetGroups (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending get groups command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processSetGroupsCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Set groups request");
+	if (!rxCommand.hasGroups) {
+		DEBUG_WARN ("Command does not contain %s", groupsValue);
+		return false;
+	}
+	channelConfig[rxCommand.channel].groups = rxCommand.groups;
+	saveConfig ();
+	if (!sendGetGroups (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending set groups command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetPresetsCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Get presets request");
+	if (!sendGetPresets (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending get presets command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processRecallPresetCommand (const blindCommand_t& rxCommand) {
+	if (!rxCommand.hasId || !presetSet (rxCommand.channel, rxCommand.id)) {
+		DEBUG_WARN ("Preset %d is not set", rxCommand.id);
+		if (!sendCommandResp (presetCommandValue, false, rxCommand.channel)) {
+			DEBUG_WARN ("Error sending preset command response");
+		}
+		return false;
+	}
+	DEBUG_INFO ("Recall preset %d request", rxCommand.id);
+	if (!sendCommandResp (presetCommandValue, startAction (rxCommand.channel, ACTION_PRESET, rxCommand), rxCommand.channel)) {
+		DEBUG_WARN ("Error sending preset command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processSavePresetCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Save preset %d request", rxCommand.id);
+	if (!rxCommand.hasId || rxCommand.id < 1 || rxCommand.id > BLIND_PRESETS) {
+		DEBUG_WARN ("Wrong preset %d", rxCommand.id);
+		return false;
+	}
+	int angle;
+	if (rxCommand.hasPos) {
+		angle = rxCommand.pos < 0 ? -1 : constrain (rxCommand.pos, 0, 100); // Negative position clears preset
+	} else {
+		updateState (rxCommand.channel);
+		angle = getAngle (rxCommand.channel);
+		if (angle == -1) {
+			DEBUG_WARN ("Position not calibrated");
+			return false;
+		}
+	}
+	channelConfig[rxCommand.channel].presets[rxCommand.id - 1] = angle;
+	saveConfig ();
+	if (!sendGetPresets (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending save preset command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processBindPresetCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Bind preset %d request", rxCommand.id);
+	if (!rxCommand.hasButton || rxCommand.count < PRESET_FIRST_PRESS || rxCommand.count >= PRESET_FIRST_PRESS + BLIND_PRESET_PRESSES) {
+		DEBUG_WARN ("Wrong button press %d", rxCommand.count);
+		return false;
+	}
+	if (!rxCommand.hasId || rxCommand.id < 0 || rxCommand.id > BLIND_PRESETS) {
+		DEBUG_WARN ("Wrong preset %d", rxCommand.id);
+		return false;
+	}
+	blindChannelHw_t& channelHw = channelConfig[rxCommand.channel];
+	uint8_t* bindings = rxCommand.button == button_t::UP_BUTTON ? channelHw.upPressPreset : channelHw.downPressPreset;
+	bindings[rxCommand.count - PRESET_FIRST_PRESS] = rxCommand.id; // Preset 0 removes binding
+	saveConfig ();
+	if (!sendGetPresets (rxCommand.channel)) {
+		DEBUG_WARN ("Error sending bind preset command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendGetPresets (uint8_t channel) {
+	const size_t capacity = JSON_OBJECT_SIZE (5) + JSON_ARRAY_SIZE (BLIND_PRESETS) + 2 * JSON_ARRAY_SIZE (BLIND_PRESET_PRESSES);
+	DynamicJsonDocument json (capacity);
+
+	json[commandKey] = presetCommandValue;
+	addChannel (json, channel);
+	JsonArray presets = json.createNestedArray (presetsKey);
+	for (int preset = 0; preset < BLIND_PRESETS; preset++) {
+		presets.add (channelConfig[channel].presets[preset]);
+	}
+	JsonArray up = json.createNestedArray (upButtonValue);
+	JsonArray down = json.createNestedArray (downButtonValue);
+	for (int press = 0; press < BLIND_PRESET_PRESSES; press++) {
+		up.add (channelConfig[channel].upPressPreset[press]);
+		down.add (channelConfig[channel].downPressPreset[press]);
+	}
+
+	return sendUplinkJson (json);
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetScheduleCommand (const blindCommand_t&) {
+	DEBUG_INFO ("Get schedule request");
+	if (!sendGetSchedule ()) {
+		DEBUG_WARN ("Error sending get schedule command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processSetScheduleCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Set schedule request");
+	if (rxCommand.hasId) {
+		blindSchedule_t entry;
+		memset (&entry, 0, sizeof (entry)); // Entry without action is removed
+		if (rxCommand.id < 1 || rxCommand.id > BLIND_SCHEDULE_SIZE || (rxCommand.action && !decodeScheduleEntry (rxCommand, entry))) {
+			DEBUG_WARN ("Wrong schedule entry %d", rxCommand.id);
+			return false;
+		}
+		config.schedule[rxCommand.id - 1] = entry;
+	}
+	if (rxCommand.hasUtcOffset) {
+		config.utcOffset = rxCommand.utcOffset;
+	}
+	saveConfig ();
+	startSchedule ();
+	if (!sendGetSchedule ()) {
+		DEBUG_WARN ("Error sending set schedule command response");
+		return false;
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::decodeScheduleEntry (const blindCommand_t& rxCommand, blindSchedule_t& entry) {
+	if (!rxCommand.hasMinute) {
+		return false;
+	}
+	if (MsgPackReader::equals (rxCommand.action, rxCommand.actionLen, fullUpCommandValue)) {
+		entry.action = ACTION_FULL_UP;
+	} else if (MsgPackReader::equals (rxCommand.action, rxCommand.actionLen, fullDownCommandValue)) {
+		entry.action = ACTION_FULL_DOWN;
+	} else if (MsgPackReader::equals (rxCommand.action, rxCommand.actionLen, gotoCommandValue) && rxCommand.hasPos) {
+		entry.action = ACTION_GOTO;
+		entry.pos = constrain (rxCommand.pos, 0, 100);
+	} else if (MsgPackReader::equals (rxCommand.action, rxCommand.actionLen, presetCommandValue) && rxCommand.hasPreset
+			   && rxCommand.preset >= 1 && rxCommand.preset <= BLIND_PRESETS) {
+		entry.action = ACTION_PRESET;
+		entry.pos = rxCommand.preset;
+	} else {
+		return false;
+	}
+	entry.minute = rxCommand.minute;
+	entry.days = rxCommand.days ? rxCommand.days : SCHEDULE_EVERY_DAY;
+	entry.jitter = rxCommand.jitter;
+	entry.channel = rxCommand.channel;
+	entry.priority = rxCommand.priority;
+	return true;
+}
+
+/**
+  * @brief Gets command name of a queue action
+  */
+static const char* actionName (uint8_t action) {
+	switch (action) {
+	case ACTION_GOTO:
+		return gotoCommandValue;
+	case ACTION_FULL_UP:
+		return fullUpCommandValue;
+	case ACTION_FULL_DOWN:
+		return fullDownCommandValue;
+	case ACTION_PRESET:
+		return presetCommandValue;
+	default:
+		return "";
+	}
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendGetSchedule () {
+	const size_t capacity = JSON_OBJECT_SIZE (3) + JSON_ARRAY_SIZE (BLIND_SCHEDULE_SIZE) + BLIND_SCHEDULE_SIZE * JSON_ARRAY_SIZE (8);
+	DynamicJsonDocument json (capacity);
+
+	json[commandKey] = scheduleCommandValue;
+	json[utcOffsetKey] = config.utcOffset;
+	// Every entry is a list so that a full schedule fits in one message
+	JsonArray entries = json.createNestedArray (scheduleCommandValue);
+	for (int i = 0; i < BLIND_SCHEDULE_SIZE; i++) {
+		const blindSchedule_t& entry = config.schedule[i];
+		if (!entry.days) {
+			continue;
+		}
+		JsonArray item = entries.createNestedArray ();
+		item.add (i + 1);
+		item.add (entry.minute / 60 * 100 + entry.minute % 60);
+		item.add (entry.days);
+		item.add (actionName (entry.action));
+		item.add (entry.pos);
+		item.add (entry.jitter);
+		item.add (entry.channel);
+		item.add (entry.priority);
+	}
+
+	return sendUplinkJson (json);
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGroupCommand (nodeMessageType_t command, const blindCommand_t& rxCommand) {
+	if (command != nodeMessageType_t::DOWNSTREAM_DATA_SET) {
+		DEBUG_WARN ("Group commands must be SET");
+		return false;
+	}
+	bool isGoto = MsgPackReader::equals (rxCommand.cmd, rxCommand.cmdLen, gotoCommandValue);
+	bool isFullUp = MsgPackReader::equals (rxCommand.cmd, rxCommand.cmdLen, fullUpCommandValue);
+	bool isFullDown = MsgPackReader::equals (rxCommand.cmd, rxCommand.cmdLen, fullDownCommandValue);
+	bool isStop = MsgPackReader::equals (rxCommand.cmd, rxCommand.cmdLen, stopCommandValue);
+	bool isSequence = MsgPackReader::equals (rxCommand.cmd, rxCommand.cmdLen, sequenceCommandValue);
+	bool isPreset = MsgPackReader::equals (rxCommand.cmd, rxCommand.cmdLen, presetCommandValue);
+	if (!(isGoto && rxCommand.hasPos) && !isFullUp && !isFullDown && !isStop && !(isSequence && rxCommand.stepCount) && !(isPreset && rxCommand.hasId)) {
+		DEBUG_WARN ("Wrong group command %.*s", (int)rxCommand.cmdLen, rxCommand.cmd);
+		return false;
+	}
+
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (!channelEnabled (channel) || !inGroup (channel, rxCommand.group)) {
+			continue;
+		}
+		DEBUG_INFO ("Group %d command %.*s on channel %d", rxCommand.group, (int)rxCommand.cmdLen, rxCommand.cmd, channel);
+		if (isGoto) {
+			startAction (channel, ACTION_GOTO, rxCommand);
+		} else if (isFullUp) {
+			startAction (channel, ACTION_FULL_UP, rxCommand);
+		} else if (isFullDown) {
+			startAction (channel, ACTION_FULL_DOWN, rxCommand);
+		} else if (isPreset) {
+			if (presetSet (channel, rxCommand.id)) { // Every blind recalls its own preset
+				startAction (channel, ACTION_PRESET, rxCommand);
+			}
+		} else if (isSequence) {
+			if (enqueue (channel, rxCommand.steps, rxCommand.stepCount, rxCommand)) {
+				runQueue (channel, true);
+			}
+		} else {
+			requestStop (channel);
 		}
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendGetGroups (uint8_t channel) {
+	const size_t capacity = JSON_OBJECT_SIZE (3) + JSON_ARRAY_SIZE (BLIND_MAX_GROUPS);
+	DynamicJsonDocument json (capacity);
+
+	json[commandKey] = groupsValue;
+	addChannel (json, channel);
+	JsonArray groups = json.createNestedArray (groupsValue);
+	for (int group = 1; group <= BLIND_MAX_GROUPS; group++) {
+		if (inGroup (channel, group)) {
+			groups.add (group);
+		}
+	}
+
+	return sendUplinkJson (json);
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetFieldsCommand (const blindCommand_t& rxCommand) {
+	DEBUG_INFO ("Get fields request");
+	updateState (rxCommand.channel);
+	if (!sendGetFields (rxCommand.channel, rxCommand.fields ? rxCommand.fields : RESPONSE_FIELDS_STATUS | FIELD_TRAVEL_TIME)) {
+		DEBUG_WARN ("Error sending get command response");
+		return false;
+	}
+	return true;
+}
 
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::processGetStatsCommand (const blindCommand_t&) {
+	DEBUG_INFO ("Get stats request");
+	if (!sendStats ()) {
+		DEBUG_WARN ("Error sending get stats command response");
+		return false;
+	}
+	return true;
+}
 
+/**
+  * @brief Adds histogram buckets followed by maximum duration to a JSON array
+  */
+static void addHistogram (JsonArray array, const LatencyHistogram& histogram) {
+	for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+		array.add (histogram.count[bucket]);
 	}
+	array.add (histogram.max);
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendStats () {
+	const size_t capacity = JSON_OBJECT_SIZE (10) + 3 * JSON_ARRAY_SIZE (LATENCY_BUCKETS + 1);
+	DynamicJsonDocument json (capacity);
+
+	json[commandKey] = statsCommandValue;
+	addHistogram (json.createNestedArray (loopStatsKey), loopLatency);
+	addHistogram (json.createNestedArray (relayStatsKey), relayLatency);
+	addHistogram (json.createNestedArray (sendStatsKey), uplink.latency ());
+	json[sendFailuresKey] = uplink.failures ();
+	json[droppedKey] = uplink.dropped ();
+	heapStats.sample ();
+	json[freeHeapKey] = ESP.getFreeHeap ();
+	json[minFreeHeapKey] = heapStats.minFree;
+	json[maxBlockKey] = HeapStats::maxFreeBlock ();
+	json[minMaxBlockKey] = heapStats.minBlock;
+
+	if (!sendUplinkJson (json)) {
+		return false; // Counters are kept for next request
+	}
+
+	// Every response covers time since previous one
+	loopLatency.clear ();
+	relayLatency.clear ();
+	uplink.clearStats ();
+	heapStats.clear ();
 	return true;
 }
 
-bool CONTROLLER_CLASS_NAME::sendGetPosition () {
-	const size_t capacity = JSON_OBJECT_SIZE (2);
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendGetPosition (uint8_t channel) {
+	const size_t capacity = JSON_OBJECT_SIZE (3);
 	DynamicJsonDocument json (capacity);
 
 	json[commandKey] = positionCommandValue;
-	json[positionKey] = getPosition ();
+	addChannel (json, channel);
+	json[positionKey] = getAngle (channel);
 
-	return sendJson (json);
+	return sendUplinkJson (json);
 }
 
-bool CONTROLLER_CLASS_NAME::sendGetTravelTime () {
-	const size_t capacity = JSON_OBJECT_SIZE (2);
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendGetTravelTime (uint8_t channel) {
+	const size_t capacity = JSON_OBJECT_SIZE (3);
 	DynamicJsonDocument json (capacity);
 
 	json[commandKey] = travelTimeValue;
-	json[travelTimeValue] = config.fullTravellingTime;
+	addChannel (json, channel);
+	json[travelTimeValue] = channelConfig[channel].fullTravellingTime;
 
-	return sendJson (json);
+	return sendUplinkJson (json);
 }
 
 
-bool CONTROLLER_CLASS_NAME::sendGetStatus () {
-	const size_t capacity = JSON_OBJECT_SIZE (3);
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendGetStatus (uint8_t channel) {
+	if (config.telemetryEncoding == TELEMETRY_CAYENNELPP) {
+		return sendStateLpp (channel, getState (channel), getAngle (channel));
+	}
+
+	const size_t capacity = JSON_OBJECT_SIZE (4);
 	DynamicJsonDocument json (capacity);
 
 	json[commandKey] = stateCommandValue;
-	json[stateCommandValue] = (int)getState ();
-	json[positionKey] = getPosition ();
+	addChannel (json, channel);
+	json[stateCommandValue] = (int)getState (channel);
+	json[positionKey] = getAngle (channel);
 
-	return sendJson (json);
+	return sendUplinkJson (json);
 }
 
-bool CONTROLLER_CLASS_NAME::sendCommandResp (const char* command, bool result) {
-	const size_t capacity = JSON_OBJECT_SIZE (2);
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendGetFields (uint8_t channel, uint8_t fields) {
+	const size_t capacity = JSON_OBJECT_SIZE (8) + JSON_ARRAY_SIZE (BLIND_MAX_GROUPS);
+	DynamicJsonDocument json (capacity);
+
+	json[commandKey] = getCommandValue;
+	addChannel (json, channel);
+	addFields (json, channel, fields);
+
+	return sendUplinkJson (json);
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::addFields (DynamicJsonDocument& json, uint8_t channel, uint8_t fields) {
+	if (fields & FIELD_STATE) {
+		json[stateCommandValue] = (int)getState (channel);
+	}
+	if (fields & FIELD_POSITION) {
+		json[positionKey] = getAngle (channel);
+	}
+	if (fields & FIELD_TARGET) {
+		json[targetKey] = getTargetAngle (channel);
+	}
+	if (fields & FIELD_TIME_LEFT) {
+		json[timeLeftKey] = getTimeLeft (channel);
+	}
+	if (fields & FIELD_TRAVEL_TIME) {
+		json[travelTimeValue] = channelConfig[channel].fullTravellingTime;
+	}
+	if (fields & FIELD_GROUPS) {
+		JsonArray groups = json.createNestedArray (groupsValue);
+		for (int group = 1; group <= BLIND_MAX_GROUPS; group++) {
+			if (inGroup (channel, group)) {
+				groups.add (group);
+			}
+		}
+	}
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendCommandResp (const char* command, bool result, uint8_t channel) {
+	const size_t capacity = JSON_OBJECT_SIZE (7);
 	DynamicJsonDocument json (capacity);
 
 	json[commandKey] = command;
+	addChannel (json, channel);
 	json[resultKey] = (int)result;
+	if (mergeResponses ()) {
+		addFields (json, channel, RESPONSE_FIELDS_STATUS);
+		DEBUG_INFO ("Channel %d. State: %s. Position %d. Sent with response", channel, stateToStr (getState (channel)), getAngle (channel));
+		setReported (channel, getState (channel), getAngle (channel));
+	}
 
-	return sendJson (json);
+	return sendUplinkJson (json);
 }
 
-void CONTROLLER_CLASS_NAME::processBlindEvent (blindState_t state, int8_t position) {
-	DEBUG_INFO ("State: %s. Position %d", stateToStr (state), position);
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::setReported (uint8_t channel, blindState_t state, int8_t position) {
+	lastShowedPos[channel] = millis ();
+	reportJitter[channel] = random (65536); // Blinds that report together now do not do it again together
+	lastReportedState[channel] = state;
+	lastReportedPosition[channel] = position;
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::processBlindEvent (uint8_t channel, blindState_t state, int8_t position, uplinkPriority_t priority) {
+	DEBUG_INFO ("Channel %d. State: %s. Position %d", channel, stateToStr (state), position);
+
+	setReported (channel, state, position);
+
+	if (config.telemetryEncoding == TELEMETRY_CAYENNELPP) {
+		sendStateLpp (channel, state, position, priority);
+		return;
+	}
 
 	const size_t capacity = JSON_OBJECT_SIZE (5);
 	DynamicJsonDocument json (capacity);
 
+	addChannel (json, channel);
 	json[stateCommandValue] = (int)state;
 	json[positionKey] = position;
 	json[memKey] = ESP.getFreeHeap ();
 
-	sendJson (json);
+	sendUplinkJson (json, priority, channel);
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::addChannel (DynamicJsonDocument& json, uint8_t channel) {
+	if (CHANNELS > 1) {
+		json[channelKey] = channel;
+	}
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendStateLpp (uint8_t channel, blindState_t state, int8_t position, uplinkPriority_t priority) {
+	if (!lpp) {
+		return false;
+	}
+	uint8_t base = channel * LPP_CHANNELS_PER_BLIND;
+	lpp->reset ();
+	lpp->addDigitalInput (base + LPP_STATE_CHANNEL, (uint8_t)state);
+	lpp->addDigitalInput (base + LPP_POSITION_CHANNEL, (uint8_t)position);
+
+	return sendUplink (lpp->getBuffer (), lpp->getSize (), CAYENNELPP, priority, channel);
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendUplink (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, uplinkPriority_t priority, uint8_t slot) {
+	bool result = uplink.send (data, length, encoding, priority, sendData, slot);
+	if (uplink.pending ()) {
+		wakeUp (); // Let loop schedule retry
+	}
+	return result;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendUplinkJson (DynamicJsonDocument& json, uplinkPriority_t priority, uint8_t slot) {
+	size_t frameSize = UplinkQueue::frameSize (priority);
+	if (measureMsgPack (json) > frameSize) {
+		DEBUG_WARN ("Message too long. %u bytes", (unsigned)measureMsgPack (json));
+		return false;
+	}
+	heapStats.sample (); // Message is still allocated, so heap is near its lowest
+	size_t length = serializeMsgPack (json, (char*)uplink.buffer (), frameSize);
+	return sendUplink (uplink.buffer (), length, MSG_PACK, priority, slot);
 }
 
-bool CONTROLLER_CLASS_NAME::sendButtonPress (button_t button, int count) {
-	const size_t capacity = JSON_OBJECT_SIZE (3);
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::sendButtonPress (uint8_t channel, button_t button, int count) {
+	if (config.telemetryEncoding == TELEMETRY_CAYENNELPP) {
+		if (!lpp) {
+			return false;
+		}
+		lpp->reset ();
+		lpp->addDigitalInput (channel * LPP_CHANNELS_PER_BLIND + (button == button_t::DOWN_BUTTON ? LPP_DOWN_BUTTON_CHANNEL : LPP_UP_BUTTON_CHANNEL), count);
+		return sendUplink (lpp->getBuffer (), lpp->getSize (), CAYENNELPP);
+	}
+
+	const size_t capacity = JSON_OBJECT_SIZE (4);
 	DynamicJsonDocument json (capacity);
 
 	json[commandKey] = eventValue;
+	addChannel (json, channel);
 	if (button == button_t::DOWN_BUTTON)
 		json[buttonKey] = downButtonValue;
 	else
 		json[buttonKey] = upButtonValue;
 	json[countNumberKey] = (int)count;
 
-	return sendJson (json);
+	return sendUplinkJson (json);
 }
 
-void CONTROLLER_CLASS_NAME::callbackUpButton (uint8_t pin, uint8_t event, uint8_t count, uint16_t length) {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::callbackUpButton (uint8_t channel, uint8_t, uint8_t event, uint8_t count, uint16_t) {
 	DEBUG_INFO ("Up button. Event %d Count %d", event, count);
+	lastButtonEvent = millis ();
+	wakeUp ();
 	if (event == EVENT_PRESSED) {
-		sendButtonPress (button_t::UP_BUTTON, count);
+		clearQueue (channel); // Local action overrides queued steps
 		DEBUG_DBG ("Up button pressed. Count %d", count);
 		if (count == 1) { // First button press
 			DEBUG_INFO ("Call simple roll up");
-			positionRequest = -1; // Request undefined position
-			travellingTime = -1;
-			blindState = rollingUp;
-			movingUp = false; // Not moving down yet
+			positionRequest[channel] = -1; // Request undefined position
+			travellingTime[channel] = -1;
+			blindState[channel] = rollingUp;
+			movingUp[channel] = false; // Not moving down yet
 			DEBUG_DBG ("--- STATE: Rolling up");
 		} else if (count == 2) { // Second button press --> full roll up
 			DEBUG_INFO ("Call full roll up");
-			fullRollup ();
+			fullRollup (channel);
+		} else if (uint8_t preset = pressPreset (channelConfig[channel].upPressPreset, count)) {
+			DEBUG_INFO ("Call preset %d", preset);
+			recallPreset (channel, preset);
 		}
+		updateState (channel); // Start motor before any radio work
+		sendButtonPress (channel, button_t::UP_BUTTON, count);
 	}
-	if (event == EVENT_RELEASED && positionRequest == -1) { // Check button release on undefined position request
+	if (event == EVENT_RELEASED && positionRequest[channel] == -1) { // Check button release on undefined position request
 		DEBUG_INFO ("Stop rolling up");
-		blindState = stopped;
-		movingUp = false;
+		blindState[channel] = stopped;
 		DEBUG_DBG ("--- STATE: Stopped");
-		processBlindEvent (blindState, position);
+		updateState (channel); // Calculates position where blind was stopped
+		processBlindEvent (channel, blindState[channel], getAngle (channel));
 	//} else if (event == EVENT_PRESSED) {
 	//	if (count == 2) { // Second button press --> full roll up
 	//		DEBUG_INFO ("Call full roll up");
-	//		fullRollup ();
+	//		fullRollup (channel);
 	//	}
 	}
 }
 
-void CONTROLLER_CLASS_NAME::callbackDownButton (uint8_t pin, uint8_t event, uint8_t count, uint16_t length) {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::callbackDownButton (uint8_t channel, uint8_t, uint8_t event, uint8_t count, uint16_t) {
 	DEBUG_INFO ("Down button. Event %d Count %d", event, count);
+	lastButtonEvent = millis ();
+	wakeUp ();
 	if (event == EVENT_PRESSED) {
-		sendButtonPress (button_t::DOWN_BUTTON, count);
+		clearQueue (channel); // Local action overrides queued steps
 		DEBUG_DBG ("Down button pressed. Count %d", count);
 		if (count == 1) { // First button press
 			DEBUG_INFO ("Call simple roll down");
-			positionRequest = -1; // Request undefined position
-			travellingTime = -1;
-			blindState = rollingDown;
-			movingDown = false; // Not moving down yet
+			positionRequest[channel] = -1; // Request undefined position
+			travellingTime[channel] = -1;
+			blindState[channel] = rollingDown;
+			movingDown[channel] = false; // Not moving down yet
 			DEBUG_DBG ("--- STATE: Rolling down");
 		} else if (count == 2) { // Second button press --> full roll down
 			DEBUG_INFO ("Call full roll down");
-			fullRolldown ();
+			fullRolldown (channel);
+		} else if (uint8_t preset = pressPreset (channelConfig[channel].downPressPreset, count)) {
+			DEBUG_INFO ("Call preset %d", preset);
+			recallPreset (channel, preset);
 		}
+		updateState (channel); // Start motor before any radio work
+		sendButtonPress (channel, button_t::DOWN_BUTTON, count);
 	}
-	if (event == EVENT_RELEASED && positionRequest == -1) { // Check button release on undefined position request
+	if (event == EVENT_RELEASED && positionRequest[channel] == -1) { // Check button release on undefined position request
 		DEBUG_INFO ("Stop rollinging down");
-		blindState = stopped;
-		movingDown = false;
+		blindState[channel] = stopped;
 		DEBUG_DBG ("--- STATE: Stopped");
-		processBlindEvent (blindState, position);
+		updateState (channel); // Calculates position where blind was stopped
+		processBlindEvent (channel, blindState[channel], getAngle (channel));
 	//} else if (event == EVENT_PRESSED) {
 	//	if (count == 2) { // Second button press --> full roll down
 	//		DEBUG_INFO ("Call full roll down");
-	//		fullRolldown ();
+	//		fullRolldown (channel);
 	//	}
 	}
 
 }
 
-void CONTROLLER_CLASS_NAME::defaultConfig () {
-	config.upRelayPin = UP_RELAY_PIN;
-	config.downRelayPin = DOWN_RELAY_PIN;
-	config.upButton = UP_BUTTON_PIN;
-	config.downButton = DOWN_BUTTON_PIN;
-	if (!config.fullTravellingTime)
-		config.fullTravellingTime = ROLLING_TIME;
-	config.notifPeriod = config.fullTravellingTime / NOTIF_PERIOD_RATIO;
-	config.keepAlivePeriod = config.fullTravellingTime * KEEP_ALIVE_PERIOD_RATIO;
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::defaultConfig () {
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		// Only first channel has a default wiring
+		channelConfig[channel].upRelayPin = channel ? NO_PIN : UP_RELAY_PIN;
+		channelConfig[channel].downRelayPin = channel ? NO_PIN : DOWN_RELAY_PIN;
+		channelConfig[channel].upButton = channel ? NO_BUTTON : UP_BUTTON_PIN;
+		channelConfig[channel].downButton = channel ? NO_BUTTON : DOWN_BUTTON_PIN;
+		if (!channelConfig[channel].fullTravellingTime)
+			channelConfig[channel].fullTravellingTime = ROLLING_TIME;
+		channelConfig[channel].relayDeadTime = RELAY_DEAD_TIME_DEFAULT;
+		memset (channelConfig[channel].presets, -1, sizeof (channelConfig[channel].presets));
+		memset (channelConfig[channel].upPressPreset, 0, sizeof (channelConfig[channel].upPressPreset));
+		memset (channelConfig[channel].downPressPreset, 0, sizeof (channelConfig[channel].downPressPreset));
+	}
 	config.ON_STATE = ON_STATE_DEFAULT;
+	config.telemetryEncoding = TELEMETRY_MSGPACK;
+	config.curveProfile = CURVE_PROFILE_DEFAULT;
+	config.reportStep = REPORT_STEP_DEFAULT;
+	config.reportMinInterval = REPORT_MIN_INTERVAL_DEFAULT;
+	config.reportMaxInterval = REPORT_MAX_INTERVAL_DEFAULT;
+	memset (config.curvePoints, 0, sizeof (config.curvePoints));
+	config.clockSync = false;
+	memset (config.schedule, 0, sizeof (config.schedule));
+	config.utcOffset = 0;
+	config.mergedResponse = false;
 }
 
-void CONTROLLER_CLASS_NAME::setup (EnigmaIOTNodeClass* node, void* data) {
+
+/**
+  * @brief Hashes node address and channel number to a fixed value 0-65535 of every blind
+  */
+static uint16_t addressPhase (const uint8_t* address, uint8_t channel) {
+	uint32_t hash = 2166136261u; // FNV-1a
+	for (int i = 0; i < ENIGMAIOT_ADDR_LEN; i++) {
+		hash = (hash ^ address[i]) * 16777619u;
+	}
+	hash = (hash ^ channel) * 16777619u;
+	return (hash >> 16) ^ hash; // Sequential addresses differ mostly on high bits
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::setup (EnigmaIOTNodeClass* node, void* data) {
 	enigmaIotNode = node;
 	blindControlerHw_t* data_p = (blindControlerHw_t*)data;
 
-	defaultConfig ();
+	if (!channelConfig[0].fullTravellingTime) { // Configuration was not loaded
+		defaultConfig ();
+	}
 
 	if (data_p) {
-		DEBUG_WARN ("Load user config from parameter. Not using stored data");
-		config.downButton = data_p->downButton;
-		config.downRelayPin = data_p->downRelayPin;
-		if (!config.fullTravellingTime)
-			config.fullTravellingTime = data_p->fullTravellingTime;
+		for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+			channelConfig[channel].downButton = data_p[channel].downButton;
+			channelConfig[channel].downRelayPin = data_p[channel].downRelayPin;
+			channelConfig[channel].upButton = data_p[channel].upButton;
+			channelConfig[channel].upRelayPin = data_p[channel].upRelayPin;
+		}
+	}
+	if (data_p && configStored) {
+		DEBUG_INFO ("Pins taken from parameter. Using stored configuration");
+	} else if (data_p) {
+		DEBUG_INFO ("No stored configuration. Using parameter");
+		for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+			if (data_p[channel].fullTravellingTime)
+				channelConfig[channel].fullTravellingTime = data_p[channel].fullTravellingTime;
+			channelConfig[channel].upTravellingTime = data_p[channel].upTravellingTime;
+			channelConfig[channel].startDelay = data_p[channel].startDelay;
+			channelConfig[channel].runOnTime = data_p[channel].runOnTime;
+		}
 		config.ON_STATE = data_p->ON_STATE;
-		OFF_STATE = !config.ON_STATE;
-		config.upButton = data_p->upButton;
-		config.upRelayPin = data_p->upRelayPin;
+		config.telemetryEncoding = data_p->telemetryEncoding;
+		config.curveProfile = data_p->curveProfile;
+		config.reportStep = data_p->reportStep;
+		config.reportMinInterval = data_p->reportMinInterval;
+		config.reportMaxInterval = data_p->reportMaxInterval;
+		memcpy (config.curvePoints, data_p->curvePoints, sizeof (config.curvePoints));
+		config.clockSync = data_p->clockSync;
+		config.mergedResponse = data_p->mergedResponse;
 	}
+	OFF_STATE = !config.ON_STATE;
 
-	config.keepAlivePeriod = config.fullTravellingTime * KEEP_ALIVE_PERIOD_RATIO;
-	config.notifPeriod = config.fullTravellingTime / NOTIF_PERIOD_RATIO;
+	if (config.clockSync) {
+		enigmaIotNode->enableClockSync (true); // Needed for scheduled commands
+	}
+	startSchedule ();
+
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		position[channel] = -1;
+		positionRequest[channel] = -1;
+		angleRequest[channel] = -1;
+		blindState[channel] = stopped;
+		travellingTime[channel] = -1;
+		lastReportedState[channel] = stopped;
+		lastReportedPosition[channel] = -1;
+		reportJitter[channel] = random (65536);
+		// Nodes that boot together after a power cut send their first keep alive at different points of its period
+		lastShowedPos[channel] = millis () - ((uint64_t)maxReportInterval (channel) * addressPhase (enigmaIotNode->getNodeAddress (), channel) >> 16);
+	}
 
 	configurePins ();
 
+	if (!lpp) {
+		lpp = new CayenneLPP (LPP_FRAME_SIZE);
+	}
+
+	if (!curve.begin (config.curveProfile, config.curvePoints)) {
+		DEBUG_WARN ("Wrong custom curve points. Using linear curve");
+	}
+
 	DEBUG_INFO ("==== Blind Controller Configuration ====");
-	DEBUG_INFO ("Up Relay pin: %d", config.upRelayPin);
-	DEBUG_INFO ("Down Relay pin: %d", config.downRelayPin);
-	DEBUG_INFO ("Up Button pin: %d", config.upButton);
-	DEBUG_INFO ("Down Button pin: %d", config.downButton);
-	DEBUG_INFO ("Full travelling time: %d ms", config.fullTravellingTime);
-	DEBUG_INFO ("Notification period time: %d ms", config.notifPeriod);
-	DEBUG_INFO ("Keep Alive period time: %d ms", config.keepAlivePeriod);
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (!channelEnabled (channel)) {
+			continue;
+		}
+		positionStore[channel].begin (channel);
+		int8_t savedPosition;
+		uint8_t savedState;
+		if (positionStore[channel].restore (savedPosition, savedState)) {
+			if (savedState == stopped) {
+				// Saved as whole percent, so restored position is up to 0.5 % away from the real one
+				position[channel] = savedPosition << POSITION_SHIFT;
+				DEBUG_INFO ("Channel %d. Restored position %d", channel, savedPosition);
+			} else {
+				// Reset while moving. Blind ran on for an unknown time after relay went off
+				DEBUG_WARN ("Channel %d. Stopped while %s at %d. Needs calibration", channel, stateToStr (savedState), savedPosition);
+			}
+		}
+
+		DEBUG_INFO ("Channel %d", channel);
+		DEBUG_INFO ("Up Relay pin: %d", channelConfig[channel].upRelayPin);
+		DEBUG_INFO ("Down Relay pin: %d", channelConfig[channel].downRelayPin);
+		DEBUG_INFO ("Up Button pin: %d", channelConfig[channel].upButton);
+		DEBUG_INFO ("Down Button pin: %d", channelConfig[channel].downButton);
+		DEBUG_INFO ("Full travelling time: %d ms down, %d ms up", (int)channelConfig[channel].fullTravellingTime, (int)travelTime (channel, true));
+		DEBUG_INFO ("Start delay: %d ms. Run on time: %d ms", (int)channelConfig[channel].startDelay, (int)channelConfig[channel].runOnTime);
+		DEBUG_INFO ("Notification period time: %d ms", (int)notifPeriod (channel));
+		DEBUG_INFO ("Keep Alive period time: %d ms", (int)(channelConfig[channel].fullTravellingTime * KEEP_ALIVE_PERIOD_RATIO));
+	}
 	DEBUG_INFO ("On Relay state: %s", config.ON_STATE ? "HIGH" : "LOW");
+	DEBUG_INFO ("Telemetry encoding: %s", config.telemetryEncoding == TELEMETRY_CAYENNELPP ? "CayenneLPP" : "MsgPack");
+	DEBUG_INFO ("Curve profile: %d", config.curveProfile);
+	DEBUG_INFO ("Report step: %d %%. Interval %d - %d ms", config.reportStep, (int)config.reportMinInterval, (int)config.reportMaxInterval);
+	DEBUG_INFO ("Clock sync: %s", config.clockSync ? "enabled" : "disabled");
+	DEBUG_INFO ("Merged responses: %s", config.mergedResponse ? "enabled" : "disabled");
 
 
 	DEBUG_DBG ("Finish begin");
 
 }
 
-void CONTROLLER_CLASS_NAME::configurePins () {
-	if (upButton) {
-		delete(upButton);
-	}
-	if (downButton) {
-		delete(downButton);
-	}
-	upButton = new DebounceEvent (config.upButton, std::bind (&BlindController::callbackUpButton, this, _1, _2, _3, _4), BUTTON_PUSHBUTTON | BUTTON_DEFAULT_HIGH | BUTTON_SET_PULLUP, BUTTON_DELAY, BUTTON_REPEAT);
-	downButton = new DebounceEvent (config.downButton, std::bind (&BlindController::callbackDownButton, this, _1, _2, _3, _4), BUTTON_PUSHBUTTON | BUTTON_DEFAULT_HIGH | BUTTON_SET_PULLUP, BUTTON_DELAY, BUTTON_REPEAT);
 
-	pinMode (config.upRelayPin, OUTPUT);
-	pinMode (config.downRelayPin, OUTPUT);
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::configurePins () {
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+#if BLIND_BUTTON_ISR
+		buttons.end (2 * channel);
+		buttons.end (2 * channel + 1);
+		if (!channelEnabled (channel)) {
+			continue;
+		}
+		buttons.begin (2 * channel, channelConfig[channel].upButton, std::bind (&MultiBlindController::callbackUpButton, this, channel, _1, _2, _3, _4), BUTTON_DELAY, BUTTON_REPEAT);
+		buttons.begin (2 * channel + 1, channelConfig[channel].downButton, std::bind (&MultiBlindController::callbackDownButton, this, channel, _1, _2, _3, _4), BUTTON_DELAY, BUTTON_REPEAT);
+#else
+		if (upButton[channel]) {
+			delete(upButton[channel]);
+			upButton[channel] = NULL;
+		}
+		if (downButton[channel]) {
+			delete(downButton[channel]);
+			downButton[channel] = NULL;
+		}
+		if (!channelEnabled (channel)) {
+			continue;
+		}
+		if (channelConfig[channel].upButton != NO_BUTTON) {
+			upButton[channel] = new DebounceEvent (channelConfig[channel].upButton, std::bind (&MultiBlindController::callbackUpButton, this, channel, _1, _2, _3, _4), BUTTON_PUSHBUTTON | BUTTON_DEFAULT_HIGH | BUTTON_SET_PULLUP, BUTTON_DELAY, BUTTON_REPEAT);
+		}
+		if (channelConfig[channel].downButton != NO_BUTTON) {
+			downButton[channel] = new DebounceEvent (channelConfig[channel].downButton, std::bind (&MultiBlindController::callbackDownButton, this, channel, _1, _2, _3, _4), BUTTON_PUSHBUTTON | BUTTON_DEFAULT_HIGH | BUTTON_SET_PULLUP, BUTTON_DELAY, BUTTON_REPEAT);
+		}
+#endif
+
+		pinMode (channelConfig[channel].upRelayPin, OUTPUT);
+		pinMode (channelConfig[channel].downRelayPin, OUTPUT);
+		relaysOn[channel] = true; // Force relays to off state on first loop
+	}
+	wakeUp ();
 }
 
-void CONTROLLER_CLASS_NAME::fullRollup () {
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::fullRollup (uint8_t channel) {
 	DEBUG_DBG ("Configure full roll up");
-	positionRequest = 100;
-	travellingTime = config.fullTravellingTime * 1.1;
-	blindState = rollingUp;
+	angleRequest[channel] = -1;
+	wakeUp ();
+	positionRequest[channel] = POSITION_FULL;
+	travellingTime[channel] = fullMovementTime (channel, true);
+	blindState[channel] = rollingUp;
 	DEBUG_DBG ("--- STATE: Rolling up");
 }
 
-void CONTROLLER_CLASS_NAME::fullRolldown () {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::fullRolldown (uint8_t channel) {
 	DEBUG_DBG ("Configure full roll down");
-	positionRequest = 0;
-	travellingTime = config.fullTravellingTime * 1.1;
-	blindState = rollingDown;
+	angleRequest[channel] = -1;
+	wakeUp ();
+	positionRequest[channel] = 0;
+	travellingTime[channel] = fullMovementTime (channel, false);
+	blindState[channel] = rollingDown;
 	DEBUG_DBG ("--- STATE: Rolling down");
 }
 
-int angleToPosition (int angle) {
-	if (angle >= 0 && angle <= 100) {
-		return pos_len_lut[angle];
+template <uint8_t CHANNELS>
+int8_t MultiBlindController<CHANNELS>::getAngle (uint8_t channel) {
+	if (position[channel] == -1) {
+		return -1;
+	}
+	if (angleRequest[channel] != -1 && abs (position[channel] - positionRequest[channel]) < POSITION_MIN_MOVE) {
+		return angleRequest[channel];
 	}
-	return -1;
+	return curve.positionToAngle (position[channel]);
 }
 
-int positionToAngle (int position) {
-	if (position == -1) {
-		return -1;
+template <uint8_t CHANNELS>
+int8_t MultiBlindController<CHANNELS>::getTargetAngle (uint8_t channel) {
+	if ((blindState[channel] != rollingUp && blindState[channel] != rollingDown) || positionRequest[channel] == -1) {
+		return getAngle (channel);
 	}
-	if (position <= 0) {
-		return 0;
+	if (angleRequest[channel] != -1) {
+		return angleRequest[channel];
 	}
-	if (position >= 100) {
-		return 100;
+	return curve.positionToAngle (positionRequest[channel]);
+}
+
+template <uint8_t CHANNELS>
+clock_t MultiBlindController<CHANNELS>::getTimeLeft (uint8_t channel) {
+	if ((blindState[channel] != rollingUp && blindState[channel] != rollingDown) || travellingTime[channel] <= 0) {
+		return 0;
 	}
-	for (int i = 0; i < sizeof (pos_len_lut); i++) {
-		if (pos_len_lut[i] == position) {
-			return i+1;
-		}
+	if (!movingUp[channel] && !movingDown[channel]) { // Relays not switched on yet
+		return travellingTime[channel];
 	}
-	return -1;
+	time_t timeMoving = millis () - blindStartedMoving[channel];
+	return timeMoving < travellingTime[channel] ? travellingTime[channel] - timeMoving : 0;
 }
 
-bool CONTROLLER_CLASS_NAME::gotoPosition (int pos) {
-	int currentPosition = position;
-	DEBUG_INFO ("Go to position %d. Current = %d", pos, currentPosition);
-	pos = angleToPosition (pos);
-	DEBUG_INFO ("Linear position = %d", pos);
-
-	if (pos <= 0) {
-		pos = 0;
-		currentPosition = 100; // Force full rolling down
-	} else if (pos >= 100) {
-		pos = 100;
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::gotoPosition (int pos, uint8_t channel) {
+	int currentPosition = position[channel];
+	DEBUG_INFO ("Go to position %d. Current = %d", pos, getPosition (channel));
+	int angle = pos < 0 ? 0 : (pos > 100 ? 100 : pos);
+	wakeUp ();
+	int target = curve.angleToPosition (angle); // Not rounded so that angle is reached as accurately as possible
+	DEBUG_INFO ("Linear position = %d", toPercent (target));
+
+	if (target <= 0) {
+		target = 0;
+		currentPosition = POSITION_FULL; // Force full rolling down
+	} else if (target >= POSITION_FULL) {
+		target = POSITION_FULL;
 		currentPosition = 0; // Force full rolling up
-	} else if (position == -1) {
-		DEBUG_INFO ("Position not calibrated. Pos = %d", pos);
+	} else if (position[channel] == -1) {
+		DEBUG_INFO ("Position not calibrated. Pos = %d", toPercent (target));
 		return false;
 	}
-	stop ();
-	positionRequest = pos;
-	if (pos > currentPosition) {
-		blindState = rollingUp;
-		DEBUG_INFO ("--- STATE: Rolling up from %d to  %d", position, pos);
-		if (pos < 100) {
-			travellingTime = movementToTime (pos - position);
+	if (retarget (channel, target)) {
+		angleRequest[channel] = target > 0 && target < POSITION_FULL ? angle : -1;
+		return true;
+	}
+	stop (channel);
+	positionRequest[channel] = target;
+	angleRequest[channel] = angle;
+	if (target >= currentPosition + POSITION_MIN_MOVE) {
+		blindState[channel] = rollingUp;
+		DEBUG_INFO ("--- STATE: Rolling up from %d to  %d", getPosition (channel), toPercent (target));
+		if (target < POSITION_FULL) {
+			travellingTime[channel] = movementToTime (channel, true, target - position[channel]);
 		} else {
-			fullRollup ();
+			fullRollup (channel);
 		}
-	} else if (pos < currentPosition) {
-		blindState = rollingDown;
-		DEBUG_INFO ("--- STATE: Rolling down from %d to %d", position, pos);
-		if (pos > 0) {
-			travellingTime = movementToTime (position - pos);
+	} else if (target <= currentPosition - POSITION_MIN_MOVE) {
+		blindState[channel] = rollingDown;
+		DEBUG_INFO ("--- STATE: Rolling down from %d to %d", getPosition (channel), toPercent (target));
+		if (target > 0) {
+			travellingTime[channel] = movementToTime (channel, false, position[channel] - target);
 		} else {
-			fullRolldown ();
+			fullRolldown (channel);
 		}
 	} else {
 		DEBUG_INFO ("Requested = Current position");
-		processBlindEvent (blindState, positionToAngle(position));
+		processBlindEvent (channel, blindState[channel], getAngle (channel));
+	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::retarget (uint8_t channel, int target) {
+	if (!movingUp[channel] && !movingDown[channel]) {
+		return false;
+	}
+	updateState (channel); // Get current position
+	bool up = movingUp[channel];
+	if (blindState[channel] != (up ? rollingUp : rollingDown) || (position[channel] != -1 && (up ? target <= position[channel] : target >= position[channel]))) {
+		return false;
+	}
+	DEBUG_INFO ("Retarget %s movement from %d to %d", up ? "up" : "down", toPercent (positionRequest[channel]), toPercent (target));
+	if (target == POSITION_FULL) {
+		fullRollup (channel);
+	} else if (target == 0) {
+		fullRolldown (channel);
+	} else {
+		// Relays stay on. Movement time is counted from original start
+		positionRequest[channel] = target;
+		finalPosition[channel] = target;
+		travellingTime[channel] = movementToTime (channel, up, abs (target - originalPosition[channel]));
+		wakeUp ();
 	}
 	return true;
 }
 
-void  CONTROLLER_CLASS_NAME::rollup () {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::rollup (uint8_t channel) {
 	time_t timeMoving;
 
-	if (!movingUp) {
-		DEBUG_DBG ("Started roll up. Position Request %d. Original position %d", positionRequest, position);
-		movingDown = false;
-		movingUp = true;
-		blindStartedMoving = millis ();
-		originalPosition = position;
-		finalPosition = positionRequest;
-		digitalWrite (config.downRelayPin, OFF_STATE);
-		digitalWrite (config.upRelayPin, config.ON_STATE);
-	}
-	timeMoving = millis () - blindStartedMoving;
-	if (position != -1 && position < 100) {
-		position = originalPosition + timeToPos (timeMoving);
-		if (position > 100) {
-			position = 100;
+	if (!movingUp[channel]) {
+		if (movingDown[channel]) { // Reversal
+			stop (channel);
+		}
+		if (deadTimeLeft (channel, true)) {
+			return;
+		}
+		DEBUG_DBG ("Started roll up. Position Request %d. Original position %d", toPercent (positionRequest[channel]), getPosition (channel));
+		movingDown[channel] = false;
+		movingUp[channel] = true;
+		disarmCutoff (channel); // Timer may belong to a previous movement
+		blindStartedMoving[channel] = millis ();
+		positionSpeed[channel] = movementSpeed (channel, movingUp[channel]);
+		originalPosition[channel] = position[channel];
+		finalPosition[channel] = positionRequest[channel];
+		digitalWrite (channelConfig[channel].downRelayPin, OFF_STATE);
+		digitalWrite (channelConfig[channel].upRelayPin, config.ON_STATE);
+		relaysOn[channel] = true;
+		if (relayLatencyPending[channel]) {
+			relayLatency.add (relayRequested[channel]);
+			relayLatencyPending[channel] = false;
 		}
 	}
-	if (travellingTime > 0 && timeMoving > travellingTime) {
+	armCutoff (channel, channelConfig[channel].upRelayPin);
+	timeMoving = millis () - blindStartedMoving[channel];
+	if (position[channel] != -1 && position[channel] < POSITION_FULL) {
+		position[channel] = min (originalPosition[channel] + timeToPos (channel, timeMoving), POSITION_FULL);
+	}
+	if (travellingTime[channel] > 0 && (timeMoving > travellingTime[channel] || cutoffFired (channel))) {
 		DEBUG_DBG ("Stopped roll up");
-		if (positionRequest == 100) {
-			position = 100;
+		if (positionRequest[channel] != -1) { // Planned movement ends exactly at requested position
+			position[channel] = positionRequest[channel];
 		}
-		blindState = stopped;
+		blindState[channel] = stopped;
 		DEBUG_DBG ("--- STATE: Stopped");
-		processBlindEvent (blindState, positionToAngle(position));
+		processBlindEvent (channel, blindState[channel], getAngle (channel));
 	} else {
-		if (timeMoving > config.fullTravellingTime * 1.1) {
-			blindState = stopped;
-			position = 100;
+		if (timeMoving > fullMovementTime (channel, true)) {
+			blindState[channel] = stopped;
+			position[channel] = POSITION_FULL;
 			DEBUG_DBG ("--- STATE: Stopped");
-			processBlindEvent (blindState, positionToAngle(position));
+			processBlindEvent (channel, blindState[channel], getAngle (channel));
 		}
 	}
 }
 
-void CONTROLLER_CLASS_NAME::rolldown () {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::rolldown (uint8_t channel) {
 	time_t timeMoving;
 
-	if (!movingDown) {
-		DEBUG_DBG ("Started roll down. Position Request %d. Original position %d", positionRequest, position);
-		movingUp = false;
-		movingDown = true;
-		blindStartedMoving = millis ();
-		originalPosition = position;
-		finalPosition = positionRequest;
-		digitalWrite (config.upRelayPin, OFF_STATE);
-		digitalWrite (config.downRelayPin, config.ON_STATE);
-	}
-	timeMoving = millis () - blindStartedMoving;
-	if (position != -1 && position > 0) {
-		position = originalPosition - timeToPos (timeMoving);
-		if (position < 0) {
-			position = 0;
+	if (!movingDown[channel]) {
+		if (movingUp[channel]) { // Reversal
+			stop (channel);
+		}
+		if (deadTimeLeft (channel, false)) {
+			return;
+		}
+		DEBUG_DBG ("Started roll down. Position Request %d. Original position %d", toPercent (positionRequest[channel]), getPosition (channel));
+		movingUp[channel] = false;
+		movingDown[channel] = true;
+		disarmCutoff (channel); // Timer may belong to a previous movement
+		blindStartedMoving[channel] = millis ();
+		positionSpeed[channel] = movementSpeed (channel, movingUp[channel]);
+		originalPosition[channel] = position[channel];
+		finalPosition[channel] = positionRequest[channel];
+		digitalWrite (channelConfig[channel].upRelayPin, OFF_STATE);
+		digitalWrite (channelConfig[channel].downRelayPin, config.ON_STATE);
+		relaysOn[channel] = true;
+		if (relayLatencyPending[channel]) {
+			relayLatency.add (relayRequested[channel]);
+			relayLatencyPending[channel] = false;
 		}
 	}
-	if (travellingTime > 0 && timeMoving > travellingTime) {
+	armCutoff (channel, channelConfig[channel].downRelayPin);
+	timeMoving = millis () - blindStartedMoving[channel];
+	if (position[channel] != -1 && position[channel] > 0) {
+		position[channel] = max (originalPosition[channel] - timeToPos (channel, timeMoving), 0);
+	}
+	if (travellingTime[channel] > 0 && (timeMoving > travellingTime[channel] || cutoffFired (channel))) {
 		DEBUG_DBG ("Stopped roll down");
-		if (positionRequest == 0) {
-			position = 0;
+		if (positionRequest[channel] != -1) { // Planned movement ends exactly at requested position
+			position[channel] = positionRequest[channel];
 		}
-		blindState = stopped;
+		blindState[channel] = stopped;
 		DEBUG_DBG ("--- STATE: Stopped");
-		processBlindEvent (blindState, positionToAngle (position));
+		processBlindEvent (channel, blindState[channel], getAngle (channel));
 	} else {
-		if (timeMoving > config.fullTravellingTime * 1.1) {
-			blindState = stopped;
-			position = 0;
+		if (timeMoving > fullMovementTime (channel, false)) {
+			blindState[channel] = stopped;
+			position[channel] = 0;
 			DEBUG_DBG ("--- STATE: Stopped");
-			processBlindEvent (blindState, positionToAngle (position));
+			processBlindEvent (channel, blindState[channel], getAngle (channel));
+		}
+	}
+
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::startAction (uint8_t channel, blindAction_t action, const blindCommand_t& rxCommand) {
+	blindStep_t step = { 0, (uint8_t)action, (int8_t)(action == ACTION_PRESET ? rxCommand.id : constrain (rxCommand.pos, 0, 100)) };
+	return enqueue (channel, &step, 1, rxCommand) && runQueue (channel, true);
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::enqueue (uint8_t channel, const blindStep_t* steps, uint8_t count, const blindCommand_t& rxCommand) {
+	if (rxCommand.priority < queuePriority[channel] && (queuePending (channel) || blindState[channel] != stopped)) {
+		DEBUG_WARN ("Channel %d runs a command with priority %d. Rejected", channel, queuePriority[channel]);
+		return false;
+	}
+	clock_t start = millis ();
+	if (rxCommand.hasAt && !config.clockSync) {
+		DEBUG_WARN ("Clock sync is disabled. Starting now");
+	} else if (rxCommand.hasAt) {
+		int64_t delay = rxCommand.at - enigmaIotNode->clock ();
+		if (delay > MAX_SCHEDULE_DELAY) {
+			DEBUG_WARN ("Start time is too far");
+			return false;
+		} else if (delay > 0) {
+			DEBUG_INFO ("Channel %d. Start scheduled in %d ms", channel, (int)delay);
+			start += (clock_t)delay;
+		} else {
+			DEBUG_WARN ("Start time is %d ms late", (int)-delay);
+		}
+	}
+	memcpy (queue[channel], steps, count * sizeof (blindStep_t));
+	queueHead[channel] = 0;
+	queueLength[channel] = count;
+	queuePriority[channel] = rxCommand.priority;
+	queueResume[channel] = start;
+	wakeUp ();
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::runQueue (uint8_t channel, bool fromCommand) {
+	while (queueReady (channel) && (long)(millis () - queueResume[channel]) >= 0) {
+		const blindStep_t& step = queue[channel][queueHead[channel]++];
+		DEBUG_INFO ("Channel %d. Step %d: action %d", channel, queueHead[channel], step.action);
+		if (step.action == ACTION_WAIT) {
+			queueResume[channel] = millis () + step.wait;
+		} else if (!runAction (channel, (blindAction_t)step.action, step.pos)) {
+			DEBUG_WARN ("Channel %d. Step failed. Queue cleared", channel);
+			clearQueue (channel);
+			return false;
+		} else if (fromCommand) {
+			// Measured only if relays have to be switched on. A retargeted movement keeps them on
+			relayRequested[channel] = rxStarted;
+			relayLatencyPending[channel] = blindState[channel] != stopped && !(blindState[channel] == rollingUp ? movingUp[channel] : movingDown[channel]);
 		}
 	}
+	return true;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::runAction (uint8_t channel, blindAction_t action, int pos) {
+	switch (action) {
+	case ACTION_GOTO:
+		return gotoPosition (pos, channel);
+	case ACTION_FULL_UP:
+		fullRollup (channel);
+		return true;
+	case ACTION_FULL_DOWN:
+		fullRolldown (channel);
+		return true;
+	case ACTION_PRESET:
+		return recallPreset (channel, pos);
+	default:
+		return false;
+	}
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::recallPreset (uint8_t channel, int preset) {
+	if (!presetSet (channel, preset)) {
+		DEBUG_WARN ("Channel %d. Preset %d is not set", channel, preset);
+		return false;
+	}
+	DEBUG_INFO ("Channel %d. Preset %d", channel, preset);
+	return gotoPosition (channelConfig[channel].presets[preset - 1], channel);
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::startSchedule () {
+	scheduleActive = false;
+	for (const blindSchedule_t& entry : config.schedule) {
+		scheduleActive = scheduleActive || entry.days;
+	}
+	if (scheduleActive) {
+		enigmaIotNode->enableClockSync (true); // Schedule runs on network time
+		scheduleCheck = millis ();
+		wakeUp ();
+	}
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::runSchedule () {
+	int64_t now = enigmaIotNode->clock ();
+	if (now < SCHEDULE_MIN_TIME) {
+		scheduleCheck = millis () + SCHEDULE_RETRY_PERIOD; // Clock is not synchronized yet
+		return;
+	}
+	int64_t localTime = now + config.utcOffset * 60000LL;
+	int32_t minute = localTime / 60000;
+	if (lastScheduleMinute == -1 || abs (minute - lastScheduleMinute) > SCHEDULE_MAX_CATCH_UP) {
+		DEBUG_INFO ("Schedule starts on local minute %d", minute % MINUTES_PER_DAY);
+		lastScheduleMinute = minute - 1; // Entries of current minute still run, but not older ones
+	}
+	while (lastScheduleMinute < minute) { // Does nothing if clock went back a little
+		runSchedule (++lastScheduleMinute);
+	}
+	scheduleCheck = millis () + (60000 - localTime % 60000);
+}
 
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::runSchedule (int32_t minute) {
+	int minuteOfDay = minute % MINUTES_PER_DAY;
+	int weekday = (minute / MINUTES_PER_DAY + 3) % 7; // 1970-01-01 was Thursday. Monday is 0
+	blindCommand_t rxCommand;
+
+	for (int i = 0; i < BLIND_SCHEDULE_SIZE; i++) {
+		const blindSchedule_t& entry = config.schedule[i];
+		if (!(entry.days & (1 << weekday)) || entry.minute != minuteOfDay || entry.channel >= CHANNELS || !channelEnabled (entry.channel)) {
+			continue;
+		}
+		memset (&rxCommand, 0, sizeof (rxCommand));
+		rxCommand.priority = entry.priority;
+		blindStep_t step = { 0, entry.action, entry.pos };
+		if (!enqueue (entry.channel, &step, 1, rxCommand)) {
+			continue;
+		}
+		// Random delay spreads movements, and their notifications, of blinds that share the same time
+		clock_t delay = entry.jitter ? random (entry.jitter * 1000L + 1) : 0;
+		queueResume[entry.channel] += delay;
+		DEBUG_INFO ("Schedule entry %d. Channel %d starts in %d ms", i + 1, entry.channel, (int)delay);
+	}
 }
 
-void CONTROLLER_CLASS_NAME::requestStop () {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::requestStop (uint8_t channel, bool notify) {
 	DEBUG_DBG ("Configure stop");
-	blindState = stopped;
+	clearQueue (channel); // Stop preempts any queued step
+	wakeUp ();
+	blindState[channel] = stopped;
 	DEBUG_DBG ("--- STATE: Stopped");
-	processBlindEvent (blindState, positionToAngle (position));
+	updateState (channel); // Stop now so that final position is reported
+	if (notify) {
+		processBlindEvent (channel, blindState[channel], getAngle (channel));
+	}
 }
 
-void CONTROLLER_CLASS_NAME::setTravelTime (int travelTime) {
-	DEBUG_INFO ("Setting travel time to %d", travelTime);
-	config.fullTravellingTime = travelTime;
-	config.keepAlivePeriod = config.fullTravellingTime * KEEP_ALIVE_PERIOD_RATIO;
-	config.notifPeriod = config.fullTravellingTime / NOTIF_PERIOD_RATIO;
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::setTravelTime (uint8_t channel, int travelTime) {
+	DEBUG_INFO ("Setting channel %d travel time to %d", channel, travelTime);
+	channelConfig[channel].fullTravellingTime = travelTime;
+	wakeUp ();
 	saveConfig ();
 }
 
-void CONTROLLER_CLASS_NAME::stop () {
-	digitalWrite (config.upRelayPin, OFF_STATE);
-	digitalWrite (config.downRelayPin, OFF_STATE);
-	movingDown = false;
-	movingUp = false;
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::stop (uint8_t channel) {
+	if ((movingUp[channel] || movingDown[channel]) && position[channel] != -1 && position[channel] != positionRequest[channel]) {
+		// Movement interrupted. Blind keeps moving during run on time
+		time_t timeMoving = millis () - blindStartedMoving[channel] + channelConfig[channel].runOnTime;
+		int movement = timeToPos (channel, timeMoving);
+		int newPosition = movingUp[channel] ? originalPosition[channel] + movement : originalPosition[channel] - movement;
+		position[channel] = constrain (newPosition, 0, POSITION_FULL);
+	}
+	if (movingUp[channel] || movingDown[channel]) {
+		relaysOffTime[channel] = millis ();
+		lastMovedUp[channel] = movingUp[channel];
+	}
+	disarmCutoff (channel);
+	digitalWrite (channelConfig[channel].upRelayPin, OFF_STATE);
+	digitalWrite (channelConfig[channel].downRelayPin, OFF_STATE);
+	relaysOn[channel] = false;
+	movingDown[channel] = false;
+	movingUp[channel] = false;
+}
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::armCutoff (uint8_t channel, int pin) {
+#if BLIND_RELAY_TIMER
+	if (travellingTime[channel] <= 0 || cutoffTime[channel] == travellingTime[channel]) {
+		return;
+	}
+	cutoffTime[channel] = travellingTime[channel]; // Changes on retarget
+	time_t left = travellingTime[channel] - (time_t)(millis () - blindStartedMoving[channel]);
+	if (left > 0) {
+		cutoffTimer[channel].arm (left, pin, OFF_STATE);
+	}
+#else
+	(void)channel;
+	(void)pin;
+#endif
 }
 
-void CONTROLLER_CLASS_NAME::sendPosition () {
-	static clock_t lastShowedPos;
-	switch (blindState) {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::sendPosition (uint8_t channel) {
+	clock_t elapsed = millis () - lastShowedPos[channel];
+
+	if (blindState[channel] != lastReportedState[channel]) {
+		DEBUG_INFO ("State changed. Position: %d", getPosition (channel));
+		processBlindEvent (channel, blindState[channel], getAngle (channel));
+		return;
+	}
+
+	switch (blindState[channel]) {
 	case rollingUp:
 	case rollingDown:
-		if (millis () - lastShowedPos > config.notifPeriod) {
-			lastShowedPos = millis ();
-			DEBUG_INFO ("Position: %d", position);
-			processBlindEvent (blindState, positionToAngle (position));
-		}
-		break;
-	case stopped:
-		if (millis () - lastShowedPos > config.keepAlivePeriod) {
-			lastShowedPos = millis ();
-			DEBUG_INFO ("Position: %d", position);
-			processBlindEvent (blindState, positionToAngle (position));
+		if (config.reportStep) {
+			if (elapsed >= config.reportMinInterval && positionChanged (channel)) {
+				DEBUG_INFO ("Position: %d", getPosition (channel));
+				processBlindEvent (channel, blindState[channel], getAngle (channel), UPLINK_LOW);
+				return;
+			}
+		} else if (elapsed > notifPeriod (channel)) {
+			DEBUG_INFO ("Position: %d", getPosition (channel));
+			processBlindEvent (channel, blindState[channel], getAngle (channel), UPLINK_LOW);
+			return;
 		}
 		break;
 	case error:
-		if (millis () - lastShowedPos > config.keepAlivePeriod) {
-			lastShowedPos = millis ();
+		if (elapsed > maxReportInterval (channel)) {
 			DEBUG_WARN ("Blind in error status");
-			DEBUG_INFO ("Position: %d", position);
-			processBlindEvent (blindState, positionToAngle (position));
 		}
 		break;
+	default:
+		break;
+	}
+
+	if (elapsed > maxReportInterval (channel)) { // Nothing sent for a long time
+		DEBUG_INFO ("Position: %d", getPosition (channel));
+		processBlindEvent (channel, blindState[channel], getAngle (channel), UPLINK_LOW);
+	}
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::positionChanged (uint8_t channel) {
+	int8_t angle = getAngle (channel);
+	int change = angle - lastReportedPosition[channel];
+	return angle != lastReportedPosition[channel] && (angle == -1 || lastReportedPosition[channel] == -1 || abs (change) >= config.reportStep);
+}
+
+template <uint8_t CHANNELS>
+clock_t MultiBlindController<CHANNELS>::notifPeriod (uint8_t channel) {
+	return withJitter (channel, channelConfig[channel].fullTravellingTime / NOTIF_PERIOD_RATIO);
+}
+
+template <uint8_t CHANNELS>
+clock_t MultiBlindController<CHANNELS>::maxReportInterval (uint8_t channel) {
+	return withJitter (channel, config.reportStep ? config.reportMaxInterval : channelConfig[channel].fullTravellingTime * KEEP_ALIVE_PERIOD_RATIO);
+}
+
+
+template <uint8_t CHANNELS>
+clock_t MultiBlindController<CHANNELS>::withJitter (uint8_t channel, clock_t period) {
+	return period - ((uint64_t)(period / REPORT_JITTER_RATIO) * reportJitter[channel] >> 16);
+}
+
+
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::loop () {
+#if BLIND_BUTTON_ISR
+	buttons.loop ();
+#else
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (upButton[channel])
+			upButton[channel]->loop ();
+		if (downButton[channel])
+			downButton[channel]->loop ();
+	}
+#endif
+
+	if ((long)(millis () - nextTask) < 0) { // Nothing to do until next deadline
+		return;
+	}
+	uint32_t started = LatencyHistogram::start ();
+
+	if (scheduleActive && (long)(millis () - scheduleCheck) >= 0) {
+		runSchedule ();
+	}
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (!channelEnabled (channel)) {
+			continue;
+		}
+		if (queuePending (channel)) {
+			runQueue (channel);
+		}
+		updateState (channel);
+		sendPosition (channel);
 	}
+	uplink.loop (sendData);
+	nextTask = nextDeadline ();
+	loopLatency.add (started);
 }
 
 
-void CONTROLLER_CLASS_NAME::loop () {
-	if (upButton)
-		upButton->loop ();
-	if (downButton)
-		downButton->loop ();
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::updateState () {
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (channelEnabled (channel)) {
+			updateState (channel);
+		}
+	}
+}
 
-	switch (blindState) {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::updateState (uint8_t channel) {
+	switch (blindState[channel]) {
 	case stopped:
-		stop ();
+		if (relaysOn[channel]) {
+			stop (channel);
+			positionStore[channel].commit (getPosition (channel), blindState[channel]);
+		}
 		break;
 	case rollingUp:
-		rollup ();
+		rollup (channel);
+		positionStore[channel].start (getPosition (channel), blindState[channel]);
+		break;
+	case rollingDown:
+		rolldown (channel);
+		positionStore[channel].start (getPosition (channel), blindState[channel]);
+		break;
+	default:
 		break;
+	}
+}
+
+
+template <uint8_t CHANNELS>
+clock_t MultiBlindController<CHANNELS>::nextDeadline () {
+	clock_t now = millis ();
+	clock_t deadline = now + IDLE_POLL_PERIOD;
+	bool found = false;
+
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (!channelEnabled (channel)) {
+			continue;
+		}
+		clock_t channelDeadline = nextDeadline (channel, now);
+		if (!found || (long)(channelDeadline - deadline) < 0) {
+			deadline = channelDeadline;
+			found = true;
+		}
+	}
+
+	if (uplink.pending () && (long)(uplink.nextAttempt () - deadline) < 0) {
+		deadline = uplink.nextAttempt ();
+	}
+
+	if (scheduleActive && (long)(scheduleCheck - deadline) < 0) {
+		deadline = scheduleCheck;
+	}
+
+	if ((long)(deadline - now) < 0) {
+		return now;
+	}
+	return deadline;
+}
+
+template <uint8_t CHANNELS>
+clock_t MultiBlindController<CHANNELS>::nextDeadline (uint8_t channel, clock_t now) {
+	clock_t deadline;
+
+	// Times are compared with > so every deadline is 1 ms after its period elapses
+	switch (blindState[channel]) {
+	case rollingUp:
 	case rollingDown:
-		rolldown ();
+		if (!movingUp[channel] && !movingDown[channel]) { // Movement not started yet
+			return now + deadTimeLeft (channel, blindState[channel] == rollingUp);
+		}
+		deadline = blindStartedMoving[channel] + (travellingTime[channel] > 0 ? travellingTime[channel] : fullMovementTime (channel, movingUp[channel])) + 1;
+		if (config.reportStep) {
+			// Check position change every 1% of travel, but not before minimum interval
+			clock_t check = now + travelTime (channel, movingUp[channel]) / 100;
+			if ((long)(lastShowedPos[channel] + config.reportMinInterval - check) > 0) {
+				check = lastShowedPos[channel] + config.reportMinInterval;
+			}
+			if ((long)(check - deadline) < 0) {
+				deadline = check;
+			}
+		} else if ((long)(lastShowedPos[channel] + notifPeriod (channel) + 1 - deadline) < 0) {
+			deadline = lastShowedPos[channel] + notifPeriod (channel) + 1;
+		}
 		break;
+	case stopped:
+		if (relaysOn[channel]) {
+			return now;
+		}
+		// fall through
 	default:
+		deadline = lastShowedPos[channel] + maxReportInterval (channel) + 1;
 		break;
 	}
 
-	sendPosition ();
+	if (queueReady (channel) && (long)(queueResume[channel] - deadline) < 0) {
+		deadline = queueResume[channel];
+	}
+	return deadline;
+}
+
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::buttonActive () {
+#if BLIND_BUTTON_ISR
+	if (buttons.active ()) {
+		return true;
+	}
+#else
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if ((upButton[channel] && upButton[channel]->pressed ()) || (downButton[channel] && downButton[channel]->pressed ())) {
+			return true;
+		}
+	}
+#endif
+	// Release event is generated after BUTTON_REPEAT ms without a new press
+	return millis () - lastButtonEvent <= BUTTON_REPEAT;
+}
+
+
+template <uint8_t CHANNELS>
+uint32_t MultiBlindController<CHANNELS>::idleTime () {
+	if (buttonActive ()) {
+		return 0;
+	}
+	long remaining = nextTask - millis ();
+	if (remaining <= 0) {
+		return 0;
+	}
+	return remaining < IDLE_POLL_PERIOD ? remaining : IDLE_POLL_PERIOD;
+}
+
+template <uint8_t CHANNELS>
+int16_t MultiBlindController<CHANNELS>::timeToPos (uint8_t channel, time_t movementTime) {
+	movementTime -= channelConfig[channel].startDelay; // Motor has not started moving yet
+	if (movementTime <= 0) {
+		return 0;
+	}
+	if (movementTime >= travelTime (channel, movingUp[channel])) {
+		return POSITION_FULL;
+	}
+	return ((uint32_t)movementTime * positionSpeed[channel]) >> 16; // Less than 2^32 as movement time is below travel time
 }
 
-time_t CONTROLLER_CLASS_NAME::movementToTime (int8_t movement) {
-	clock_t calculatedTime = movement * config.fullTravellingTime / 100;
-	DEBUG_INFO ("config.fullTravellingTime = %d", config.fullTravellingTime);
-	DEBUG_INFO ("Calculated time: %d", calculatedTime);
+template <uint8_t CHANNELS>
+time_t MultiBlindController<CHANNELS>::movementToTime (uint8_t channel, bool up, int16_t movement) {
+	clock_t fullTime = travelTime (channel, up);
+	clock_t calculatedTime = ((uint64_t)movement * fullTime + POSITION_FULL / 2) / POSITION_FULL; // Rounded to nearest ms
+	DEBUG_INFO ("Travelling time = %d", (int)fullTime);
+	DEBUG_INFO ("Calculated time: %d", (int)calculatedTime);
 
-	if (calculatedTime >= config.fullTravellingTime) {
-		calculatedTime = config.fullTravellingTime * 1.1;
+	if (calculatedTime >= fullTime) {
+		calculatedTime = fullMovementTime (channel, up);
+	} else {
+		// Blind starts moving after start delay and keeps moving during run on time after relay is off
+		calculatedTime += channelConfig[channel].startDelay;
+		calculatedTime = calculatedTime > channelConfig[channel].runOnTime ? calculatedTime - channelConfig[channel].runOnTime : 1;
 	}
-	DEBUG_INFO ("Desired movement: %d. Calculated time: %d", movement, calculatedTime);
+	DEBUG_INFO ("Desired movement: %d. Calculated time: %d", toPercent (movement), (int)calculatedTime);
 	return calculatedTime;
 }
 
-CONTROLLER_CLASS_NAME::~CONTROLLER_CLASS_NAME () {
-	delete(upButton);
-	delete(downButton);
+template <uint8_t CHANNELS>
+MultiBlindController<CHANNELS>::~MultiBlindController () {
+#if !BLIND_BUTTON_ISR // Interrupts are detached by ButtonCapture
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		delete(upButton[channel]);
+		delete(downButton[channel]);
+	}
+#endif
+	delete(lpp);
 	sendData = 0;
 }
 
-void CONTROLLER_CLASS_NAME::configManagerStart () {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::configManagerStart () {
 
 	//static char upRelayStr[10];
 	//itoa (config.upRelayPin, upRelayStr, 9);
@@ -623,9 +2035,21 @@ void CONTROLLER_CLASS_NAME::configManagerStart () {
 	//downButtonParam = new AsyncWiFiManagerParameter ("downButtonParam", "Down Button Pin", downButtonStr, 9, "required type=\"number\" min=\"0\" max=\"16\" step=\"1\"");
 
 	static char fullTravelTimeParamStr[10];
-	itoa (config.fullTravellingTime / 1000, fullTravelTimeParamStr, 9);
+	itoa (channelConfig[0].fullTravellingTime / 1000, fullTravelTimeParamStr, 9);
 	fullTravelTimeParam = new AsyncWiFiManagerParameter ("fullTravelTimeParam", "Full Travel Time", fullTravelTimeParamStr, 9, "required type=\"number\" min=\"0\" max=\"3600\" step=\"1\"");
 
+	static char telemetryEncodingStr[4];
+	itoa (config.telemetryEncoding, telemetryEncodingStr, 10);
+	telemetryEncodingParam = new AsyncWiFiManagerParameter ("telemetryEncodingParam", "Compact telemetry (CayenneLPP)", telemetryEncodingStr, 3, "required type=\"number\" min=\"0\" max=\"1\" step=\"1\"");
+
+	static char reportStepStr[4];
+	itoa (config.reportStep, reportStepStr, 10);
+	reportStepParam = new AsyncWiFiManagerParameter ("reportStepParam", "Report position every % (0 = periodic)", reportStepStr, 3, "required type=\"number\" min=\"0\" max=\"100\" step=\"1\"");
+
+	static char curveProfileStr[4];
+	itoa (config.curveProfile, curveProfileStr, 10);
+	curveProfileParam = new AsyncWiFiManagerParameter ("curveProfileParam", "Curve (0 linear, 1 awning, 2 roller, 3 custom)", curveProfileStr, 3, "required type=\"number\" min=\"0\" max=\"3\" step=\"1\"");
+
 	//static char notifPeriodTimeStr[10];
 	//itoa (config.notifPeriod/1000, notifPeriodTimeStr, 9);
 	//notifPeriodTimeParam = new AsyncWiFiManagerParameter ("notifPeriodTimeParam", "Notification Period", notifPeriodTimeStr, 9, "required type=\"number\" min=\"0\" max=\"3600\" step=\"1\"");
@@ -645,18 +2069,25 @@ void CONTROLLER_CLASS_NAME::configManagerStart () {
 	//enigmaIotNode->addWiFiManagerParameter (upButtonParam);
 	//enigmaIotNode->addWiFiManagerParameter (downButtonParam);
 	enigmaIotNode->addWiFiManagerParameter (fullTravelTimeParam);
+	enigmaIotNode->addWiFiManagerParameter (telemetryEncodingParam);
+	enigmaIotNode->addWiFiManagerParameter (reportStepParam);
+	enigmaIotNode->addWiFiManagerParameter (curveProfileParam);
 	//enigmaIotNode->addWiFiManagerParameter (notifPeriodTimeParam);
 	//enigmaIotNode->addWiFiManagerParameter (keepAlivePeriodTimeParam);
 	//enigmaIotNode->addWiFiManagerParameter (onStateParam);
 }
 
-void CONTROLLER_CLASS_NAME::configManagerExit (bool status) {
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::configManagerExit (bool status) {
 	DEBUG_INFO ("==== Blind Controller Configuration result ====");
 	//DEBUG_INFO ("Up Relay pin: %s", upRelayPinParam->getValue());
 	//DEBUG_INFO ("Down Relay pin: %s", downRelayPinParam->getValue ());
 	//DEBUG_INFO ("Up Button pin: %s", upButtonParam->getValue ());
 	//DEBUG_INFO ("Down Button pin: %s", downButtonParam->getValue ());
 	DEBUG_INFO ("Full travelling time: %s s", fullTravelTimeParam->getValue ());
+	DEBUG_INFO ("Compact telemetry: %s", telemetryEncodingParam->getValue ());
+	DEBUG_INFO ("Report step: %s", reportStepParam->getValue ());
+	DEBUG_INFO ("Curve profile: %s", curveProfileParam->getValue ());
 	//DEBUG_INFO ("Notification period time: %s s", notifPeriodTimeParam->getValue ());
 	//DEBUG_INFO ("Keep Alive period time: %s s", keepAlivePeriodTimeParam->getValue ());
 	//DEBUG_INFO ("On Relay state: %s", onStateParam->getValue ());
@@ -666,7 +2097,10 @@ void CONTROLLER_CLASS_NAME::configManagerExit (bool status) {
 		//config.downRelayPin = atoi (downRelayPinParam->getValue ());
 		//config.upButton = atoi (upButtonParam->getValue ());
 		//config.downButton = atoi (downButtonParam->getValue ());
-		config.fullTravellingTime = atoi (fullTravelTimeParam->getValue ()) * 1000;
+		channelConfig[0].fullTravellingTime = atoi (fullTravelTimeParam->getValue ()) * 1000;
+		config.telemetryEncoding = atoi (telemetryEncodingParam->getValue ()) == 1 ? TELEMETRY_CAYENNELPP : TELEMETRY_MSGPACK;
+		config.curveProfile = (curveProfile_t)constrain (atoi (curveProfileParam->getValue ()), CURVE_LINEAR, CURVE_CUSTOM);
+		config.reportStep = constrain (atoi (reportStepParam->getValue ()), 0, 100);
 		//config.notifPeriod = atoi (notifPeriodTimeParam->getValue ()) * 1000;
 		//config.keepAlivePeriod = atoi (keepAlivePeriodTimeParam->getValue ()) * 1000;
 		//config.ON_STATE = atoi (onStateParam->getValue ());
@@ -686,6 +2120,9 @@ void CONTROLLER_CLASS_NAME::configManagerExit (bool status) {
 	//free (upButtonParam);
 	//free (downButtonParam);
 	delete (fullTravelTimeParam);
+	delete (telemetryEncodingParam);
+	delete (reportStepParam);
+	delete (curveProfileParam);
 	//free (notifPeriodTimeParam);
 	//free (keepAlivePeriodTimeParam);
 	//free (onStateParam);
@@ -693,126 +2130,244 @@ void CONTROLLER_CLASS_NAME::configManagerExit (bool status) {
 	DEBUG_DBG ("Finish exit config manager");
 }
 
-bool CONTROLLER_CLASS_NAME::loadConfig () {
-	//SPIFFS.remove (CONFIG_FILE); // Only for testing
-	bool json_correct = false;
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::loadConfig () {
+	bool result = true;
+
+	defaultConfig (); // Values not present on file keep their defaults
 
 	if (!SPIFFS.begin ()) {
 		DEBUG_WARN ("Error starting filesystem. Formatting");
 		SPIFFS.format ();
 	}
 
-	if (SPIFFS.exists (CONFIG_FILE)) {
-		DEBUG_INFO ("Opening %s file", CONFIG_FILE);
-		File configFile = SPIFFS.open (CONFIG_FILE, "r");
-		if (configFile) {
-			size_t size = configFile.size ();
-			DEBUG_DBG ("%s opened. %u bytes", CONFIG_FILE, size);
-			DynamicJsonDocument doc (512);
-			DeserializationError error = deserializeJson (doc, configFile);
-			if (error) {
-				DEBUG_ERROR ("Failed to parse file");
-			} else {
-				DEBUG_DBG ("JSON file parsed");
-			}
+	if (!loadBinaryConfig ()) {
+		result = false;
+	}
 
-			if (/*doc.containsKey ("upRelayPin") && doc.containsKey ("downRelayPin")
-				&& doc.containsKey ("upButton") && doc.containsKey ("downButton")
-				&& */doc.containsKey ("fullTravellingTime") /*&& doc.containsKey ("notifPeriod")
-				&& doc.containsKey ("keepAlivePeriod") && doc.containsKey ("onState")*/) {
-				json_correct = true;
+	if (SPIFFS.exists (CONFIG_JSON_FILE)) {
+		// JSON file is imported on top of stored configuration and replaced by binary record
+		if (importJsonConfig ()) {
+			if (saveConfig ()) {
+				SPIFFS.remove (CONFIG_JSON_FILE);
+				DEBUG_INFO ("%s migrated to %s", CONFIG_JSON_FILE, CONFIG_FILE);
 			}
+			result = true;
+		} else {
+			DEBUG_WARN ("Ignoring %s", CONFIG_JSON_FILE);
+		}
+	}
 
-			//config.upRelayPin = doc["upRelayPin"].as<int> ();
-			//config.downRelayPin = doc["downRelayPin"].as<int> ();
-			//config.upButton = doc["upButton"].as<int> ();
-			//config.downButton = doc["downButton"].as<int> ();
-			config.fullTravellingTime = doc["fullTravellingTime"].as<int> ();
-			//config.notifPeriod = doc["notifPeriod"].as<int> ();
-			//config.keepAlivePeriod = doc["keepAlivePeriod"].as<int> ();
-			//config.ON_STATE = doc["onState"].as<int> ()==1?HIGH:LOW;
-
-			configFile.close ();
-			if (json_correct) {
-				DEBUG_INFO ("Blind controller configuration successfuly read");
-			} else {
-				DEBUG_WARN ("Blind controller configuration error");
-			}
-			DEBUG_INFO ("==== Blind Controller  Configuration ====");
-			//DEBUG_INFO ("Up Relay pin: %d", config.upRelayPin);
-			//DEBUG_INFO ("Down Relay pin: %d", config.downRelayPin);
-			//DEBUG_INFO ("Up Button pin: %d", config.upButton);
-			//DEBUG_INFO ("Down Button pin: %d", config.downButton);
-			DEBUG_INFO ("Full travelling time: %d ms", config.fullTravellingTime);
-			//DEBUG_INFO ("Notification period time: %d ms", config.notifPeriod);
-			//DEBUG_INFO ("Keep Alive period time: %dms ", config.keepAlivePeriod);
-			//DEBUG_INFO ("On Relay state: %d", config.ON_STATE);
+	DEBUG_INFO ("==== Blind Controller  Configuration ====");
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		DEBUG_INFO ("Channel %d full travelling time: %d ms", channel, (int)channelConfig[channel].fullTravellingTime);
+	}
+	DEBUG_INFO ("Telemetry encoding: %d", config.telemetryEncoding);
+	DEBUG_INFO ("Curve profile: %d", config.curveProfile);
+	DEBUG_INFO ("Report step: %d %%. Interval %d - %d ms", config.reportStep, (int)config.reportMinInterval, (int)config.reportMaxInterval);
 
-			size_t jsonLen = measureJsonPretty (doc) + 1;
-			char* output = (char*)malloc (jsonLen);
-			size_t resultlen = serializeJsonPretty (doc, output, jsonLen);
+	return result;
+}
 
-			DEBUG_DBG ("File content:\n%s", output);
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::loadBinaryConfig () {
+	blindConfigRecord_t record;
+	uint16_t version;
 
-			free (output);
+	configToRecord (record); // Fields not present on older records keep current values
+	if (!RecordFile::read (CONFIG_FILE, CONFIG_MAGIC, &record, sizeof (record), version, configRecordLength, CONFIG_VERSION)) {
+		if (SPIFFS.exists (CONFIG_FILE)) {
+			DEBUG_WARN ("Blind controller configuration error. Using defaults");
+			return false;
+		}
+		DEBUG_INFO ("%s does not exist", CONFIG_FILE);
+		return !SPIFFS.exists (CONFIG_JSON_FILE);
+	}
+	DEBUG_INFO ("Blind controller configuration version %u successfuly read", version);
+	configStored = true;
 
-		} else {
-			DEBUG_WARN ("Error opening %s", CONFIG_FILE);
-			defaultConfig ();
+	channelConfig[0].fullTravellingTime = record.fullTravellingTime;
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (channel) {
+			channelConfig[channel].fullTravellingTime = record.channelTravellingTime[channel - 1];
 		}
-	} else {
-		DEBUG_WARN ("%s do not exist", CONFIG_FILE);
-		defaultConfig ();
+		channelConfig[channel].upTravellingTime = record.upTravellingTime[channel];
+		channelConfig[channel].startDelay = record.startDelay[channel];
+		channelConfig[channel].runOnTime = record.runOnTime[channel];
+		channelConfig[channel].groups = record.groups[channel];
+		channelConfig[channel].relayDeadTime = record.relayDeadTime[channel];
+		for (int preset = 0; preset < BLIND_PRESETS; preset++) {
+			channelConfig[channel].presets[preset] = constrain (record.presets[channel][preset], -1, 100);
+		}
+		for (int press = 0; press < BLIND_PRESET_PRESSES; press++) {
+			channelConfig[channel].upPressPreset[press] = constrain (record.upPressPreset[channel][press], 0, BLIND_PRESETS);
+			channelConfig[channel].downPressPreset[press] = constrain (record.downPressPreset[channel][press], 0, BLIND_PRESETS);
+		}
+	}
+	config.telemetryEncoding = record.telemetryEncoding == TELEMETRY_CAYENNELPP ? TELEMETRY_CAYENNELPP : TELEMETRY_MSGPACK;
+	config.curveProfile = (curveProfile_t)constrain (record.curveProfile, (uint8_t)CURVE_LINEAR, (uint8_t)CURVE_CUSTOM);
+	config.reportStep = constrain (record.reportStep, 0, 100);
+	config.reportMinInterval = record.reportMinInterval;
+	config.reportMaxInterval = record.reportMaxInterval;
+	config.clockSync = record.clockSync;
+	memcpy (config.curvePoints, record.curvePoints, sizeof (config.curvePoints));
+	for (int i = 0; i < BLIND_SCHEDULE_SIZE; i++) {
+		blindSchedule_t& entry = config.schedule[i];
+		entry = record.schedule[i];
+		if (entry.minute >= MINUTES_PER_DAY || entry.action < ACTION_GOTO || entry.action > ACTION_PRESET || entry.action == ACTION_WAIT) {
+			entry.days = 0;
+		}
+		entry.days &= SCHEDULE_EVERY_DAY;
 	}
+	config.utcOffset = constrain (record.utcOffset, -MAX_UTC_OFFSET, MAX_UTC_OFFSET);
+	config.mergedResponse = record.mergedResponse;
+	return true;
+}
 
-	return json_correct;
+template <uint8_t CHANNELS>
+void MultiBlindController<CHANNELS>::configToRecord (blindConfigRecord_t& record) {
+	memset (&record, 0, sizeof (record));
+	record.fullTravellingTime = channelConfig[0].fullTravellingTime;
+	for (uint8_t channel = 0; channel < CHANNELS; channel++) {
+		if (channel) {
+			record.channelTravellingTime[channel - 1] = channelConfig[channel].fullTravellingTime;
+		}
+		record.upTravellingTime[channel] = channelConfig[channel].upTravellingTime;
+		record.startDelay[channel] = channelConfig[channel].startDelay;
+		record.runOnTime[channel] = channelConfig[channel].runOnTime;
+		record.groups[channel] = channelConfig[channel].groups;
+		record.relayDeadTime[channel] = channelConfig[channel].relayDeadTime;
+		memcpy (record.presets[channel], channelConfig[channel].presets, sizeof (record.presets[channel]));
+		memcpy (record.upPressPreset[channel], channelConfig[channel].upPressPreset, sizeof (record.upPressPreset[channel]));
+		memcpy (record.downPressPreset[channel], channelConfig[channel].downPressPreset, sizeof (record.downPressPreset[channel]));
+	}
+	record.telemetryEncoding = config.telemetryEncoding;
+	record.curveProfile = config.curveProfile;
+	record.reportStep = config.reportStep;
+	record.reportMinInterval = config.reportMinInterval;
+	record.reportMaxInterval = config.reportMaxInterval;
+	record.clockSync = config.clockSync;
+	memcpy (record.curvePoints, config.curvePoints, sizeof (record.curvePoints));
+	memcpy (record.schedule, config.schedule, sizeof (record.schedule));
+	record.utcOffset = config.utcOffset;
+	record.mergedResponse = config.mergedResponse;
 }
 
-bool CONTROLLER_CLASS_NAME::saveConfig () {
-	if (!SPIFFS.begin ()) {
-		DEBUG_WARN ("Error opening filesystem");
+/**
+  * @brief Reads a blind setting from JSON configuration. A number sets first blind and an array sets one blind per element
+  */
+template <uint8_t CHANNELS>
+static void readChannelSetting (JsonVariant value, blindChannelHw_t (&channels)[CHANNELS], clock_t blindChannelHw_t::* field) {
+	if (value.is<JsonArray> ()) {
+		for (int channel = 0; channel < CHANNELS && channel < (int)value.size (); channel++) {
+			channels[channel].*field = value[channel].as<int> ();
+		}
+	} else if (!value.isNull ()) {
+		channels[0].*field = value.as<int> ();
+	}
+}
+
+/**
+  * @brief Reads a list setting of every blind from JSON configuration. A list of numbers sets first blind and a list of lists sets one blind per element
+  */
+template <uint8_t CHANNELS, typename T, size_t N>
+static void readChannelList (JsonVariant value, blindChannelHw_t (&channels)[CHANNELS], T (blindChannelHw_t::* field)[N], int minValue, int maxValue) {
+	if (!value.is<JsonArray> ()) {
+		return;
+	}
+	bool perChannel = value[0].is<JsonArray> ();
+	for (int channel = 0; channel < CHANNELS && channel < (perChannel ? (int)value.size () : 1); channel++) {
+		JsonVariant list = perChannel ? value[channel] : value;
+		for (int i = 0; i < (int)N && i < (int)list.size (); i++) {
+			(channels[channel].*field)[i] = constrain (list[i].as<int> (), minValue, maxValue);
+		}
 	}
-	DEBUG_INFO ("Filesystem opened");
+}
 
-	File configFile = SPIFFS.open (CONFIG_FILE, "w");
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::importJsonConfig () {
+	DEBUG_INFO ("Opening %s file", CONFIG_JSON_FILE);
+	File configFile = SPIFFS.open (CONFIG_JSON_FILE, "r");
 	if (!configFile) {
-		DEBUG_WARN ("Failed to open config file %s for writing", CONFIG_FILE);
+		DEBUG_WARN ("Error opening %s", CONFIG_JSON_FILE);
 		return false;
-	} else {
-		DEBUG_DBG ("%s opened for writting", CONFIG_FILE);
 	}
+	DEBUG_DBG ("%s opened. %u bytes", CONFIG_JSON_FILE, (unsigned)configFile.size ());
 
-	DynamicJsonDocument doc (512);
-
-	//doc["upRelayPin"] = config.upRelayPin;
-	//doc["downRelayPin"] = config.downRelayPin;
-	//doc["upButton"] = config.upButton;
-	//doc["downButton"] = config.downButton;
-	doc["fullTravellingTime"] = config.fullTravellingTime;
-	//doc["notifPeriod"] = config.notifPeriod;
-	//doc["keepAlivePeriod"] = config.keepAlivePeriod;
-	//doc["onState"] = config.ON_STATE;
-
-	if (serializeJson (doc, configFile) == 0) {
-		DEBUG_ERROR ("Failed to write to file");
-		configFile.close ();
-		//SPIFFS.remove (CONFIG_FILE);
+	DynamicJsonDocument doc (1024);
+	DeserializationError error = deserializeJson (doc, configFile);
+	configFile.close ();
+	if (error || !doc.containsKey ("fullTravellingTime")) {
+		DEBUG_ERROR ("Failed to parse file");
 		return false;
 	}
+	DEBUG_DBG ("JSON file parsed");
 
-	size_t jsonLen = measureJsonPretty (doc) + 1;
-	char* output = (char*)malloc (jsonLen);
-	size_t resultlen = serializeJsonPretty (doc, output, jsonLen);
-
-	DEBUG_VERBOSE ("File content:\n%s", output);
+	channelConfig[0].fullTravellingTime = doc["fullTravellingTime"].as<int> ();
+	JsonArray channelTimes = doc["channelTravellingTime"]; // Channels after first one
+	for (int channel = 1; channel < CHANNELS && channel <= (int)channelTimes.size (); channel++) {
+		channelConfig[channel].fullTravellingTime = channelTimes[channel - 1].as<int> ();
+	}
+	readChannelSetting (doc["upTravellingTime"].as<JsonVariant> (), channelConfig, &blindChannelHw_t::upTravellingTime);
+	readChannelSetting (doc["startDelay"].as<JsonVariant> (), channelConfig, &blindChannelHw_t::startDelay);
+	readChannelSetting (doc["runOnTime"].as<JsonVariant> (), channelConfig, &blindChannelHw_t::runOnTime);
+	readChannelSetting (doc["relayDeadTime"].as<JsonVariant> (), channelConfig, &blindChannelHw_t::relayDeadTime);
+	readChannelList (doc["presets"].as<JsonVariant> (), channelConfig, &blindChannelHw_t::presets, -1, 100);
+	readChannelList (doc["upPressPresets"].as<JsonVariant> (), channelConfig, &blindChannelHw_t::upPressPreset, 0, BLIND_PRESETS);
+	readChannelList (doc["downPressPresets"].as<JsonVariant> (), channelConfig, &blindChannelHw_t::downPressPreset, 0, BLIND_PRESETS);
+	config.telemetryEncoding = doc["telemetry"].as<int> () == TELEMETRY_CAYENNELPP ? TELEMETRY_CAYENNELPP : TELEMETRY_MSGPACK;
+	if (doc.containsKey ("curve")) {
+		config.curveProfile = (curveProfile_t)constrain (doc["curve"].as<int> (), CURVE_LINEAR, CURVE_CUSTOM);
+	}
+	if (doc.containsKey ("reportStep")) {
+		config.reportStep = constrain (doc["reportStep"].as<int> (), 0, 100);
+	}
+	if (doc.containsKey ("reportMinInterval")) {
+		config.reportMinInterval = doc["reportMinInterval"].as<int> ();
+	}
+	if (doc.containsKey ("reportMaxInterval")) {
+		config.reportMaxInterval = doc["reportMaxInterval"].as<int> ();
+	}
+	if (doc.containsKey ("clockSync")) {
+		config.clockSync = doc["clockSync"].as<bool> ();
+	}
+	if (doc.containsKey ("utcOffset")) {
+		config.utcOffset = constrain (doc["utcOffset"].as<int> (), -MAX_UTC_OFFSET, MAX_UTC_OFFSET);
+	}
+	if (doc.containsKey ("mergedResponse")) {
+		config.mergedResponse = doc["mergedResponse"].as<bool> ();
+	}
+	JsonArray curvePoints = doc["curvePoints"];
+	for (int i = 0; i < CURVE_POINTS && i < (int)curvePoints.size (); i++) {
+		config.curvePoints[i] = curvePoints[i].as<int> ();
+	}
+	return true;
+}
 
-	free (output);
+template <uint8_t CHANNELS>
+bool MultiBlindController<CHANNELS>::saveConfig () {
+	blindConfigRecord_t record;
 
-	configFile.flush ();
-	size_t size = configFile.size ();
+	if (!SPIFFS.begin ()) {
+		DEBUG_WARN ("Error opening filesystem");
+	}
 
-	//configFile.write ((uint8_t*)(&mqttgw_config), sizeof (mqttgw_config));
-	configFile.close ();
-	DEBUG_INFO ("Blind controller configuration saved to flash. %u bytes", size);
+	configToRecord (record);
+	if (!RecordFile::write (CONFIG_FILE, CONFIG_MAGIC, CONFIG_VERSION, &record, configRecordLength[CONFIG_VERSION - 1])) {
+		DEBUG_WARN ("Failed to write config file %s", CONFIG_FILE);
+		return false;
+	}
+	DEBUG_INFO ("Blind controller configuration saved to flash. %u bytes", configRecordLength[CONFIG_VERSION - 1]);
+	configStored = true;
 	return true;
-}
\ No newline at end of file
+}
+
+// Every supported channel count is built. Linker drops the ones that are not used
+template class MultiBlindController<1>;
+template class MultiBlindController<2>;
+template class MultiBlindController<3>;
+template class MultiBlindController<4>;
+template class MultiBlindController<5>;
+template class MultiBlindController<6>;
+template class MultiBlindController<7>;
+template class MultiBlindController<8>;
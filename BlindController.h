@@ -15,7 +15,53 @@
 
 #include <EnigmaIOTjsonController.h>
 #include <DebounceEvent.h>
+#include <CayenneLPP.h>
+#include "MsgPackReader.h"
+#include "BlindCurve.h"
+#include "UplinkQueue.h"
+#include "PositionStore.h"
+#include "RelayTimer.h"
+#include "LatencyStats.h"
+#include "ButtonCapture.h"
 
+/**
+  * @brief Encoding used for state, position and button event uplink messages
+  */
+typedef enum {
+	TELEMETRY_MSGPACK = 0, ///< @brief JSON document with string keys, sent as MsgPack
+	TELEMETRY_CAYENNELPP = 1 ///< @brief Fixed channel CayenneLPP frame. See README for channel layout
+} telemetryEncoding_t;
+
+#ifndef BLIND_CHANNELS
+#define BLIND_CHANNELS 1 ///< @brief Number of blinds driven by `BlindController`
+#endif
+
+#ifndef BLIND_BUTTON_ISR
+#define BLIND_BUTTON_ISR 0 ///< @brief Capture button edges from GPIO interrupts instead of polling buttons from `loop`
+#endif
+
+#ifndef BLIND_RELAY_TIMER
+#define BLIND_RELAY_TIMER 1 ///< @brief Switch relays off from a timer on movement deadline instead of waiting for `loop`
+#endif
+
+constexpr auto BLIND_MAX_CHANNELS = 8; ///< @brief Maximum number of blinds driven by one node
+constexpr auto NO_PIN = -1; ///< @brief Relay pin value for a channel that is not connected
+constexpr auto NO_BUTTON = 0xFF; ///< @brief Button pin value for a channel without local buttons
+constexpr auto BLIND_MAX_GROUPS = 16; ///< @brief Groups are numbered from 1 to this value. Group 0 includes every blind
+constexpr auto BLIND_QUEUE_SIZE = 8; ///< @brief Maximum number of steps waiting on every blind
+constexpr auto BLIND_PRESETS = 4; ///< @brief Stored positions of every blind, numbered from 1
+constexpr auto PRESET_FIRST_PRESS = 3; ///< @brief Lowest press count that may recall a preset. 1 and 2 presses are simple and full movements
+constexpr auto BLIND_PRESET_PRESSES = 3; ///< @brief Number of press counts, from `PRESET_FIRST_PRESS`, that may recall a preset
+constexpr auto BLIND_SCHEDULE_SIZE = 8; ///< @brief Maximum number of schedule entries of a node
+constexpr auto POSITION_SHIFT = 8; ///< @brief Linear positions are tracked with 8 fractional bits, as `BlindCurve` uses
+constexpr auto POSITION_FULL = 100 << POSITION_SHIFT; ///< @brief Fully rolled up linear position
+constexpr auto POSITION_MIN_MOVE = 1 << (POSITION_SHIFT - 1); ///< @brief Smaller position changes are not worth switching relays
+
+/**
+  * @brief Hardware configuration passed to `setup`. Multichannel controllers take an array with one element per blind,
+  * and settings not related to a single blind are taken from first element. Pins are always used. Travel times and
+  * shared settings are only used while there is no stored configuration
+  */
 struct blindControlerHw_t {
 	int upRelayPin;
 	int downRelayPin;
@@ -25,8 +71,129 @@ struct blindControlerHw_t {
 	clock_t notifPeriod;
 	clock_t keepAlivePeriod;
 	int ON_STATE;
+	telemetryEncoding_t telemetryEncoding;
+	curveProfile_t curveProfile;
+	uint8_t curvePoints[CURVE_POINTS]; ///< @brief Linear position for every 10% of angle when using custom curve
+	uint8_t reportStep; ///< @brief Position change in % that triggers a notification while moving. 0 to notify every `notifPeriod`
+	clock_t reportMinInterval; ///< @brief Minimum time between position notifications while moving
+	clock_t reportMaxInterval; ///< @brief Maximum time without notifications when `reportStep` is not 0. `keepAlivePeriod` is used otherwise
+	clock_t upTravellingTime; ///< @brief Time to roll up completely. 0 if it is the same as `fullTravellingTime`
+	clock_t startDelay; ///< @brief Time since relay is switched on until blind starts moving
+	clock_t runOnTime; ///< @brief Time that blind keeps moving after relay is switched off
+	bool clockSync; ///< @brief Enables clock synchronization so that commands may be scheduled with `at` key
+	bool mergedResponse; ///< @brief Movement command responses carry resulting state, instead of a separate notification
 };
 
+/**
+  * @brief Hardware of a single blind
+  */
+struct blindChannelHw_t {
+	int upRelayPin; ///< @brief `NO_PIN` if channel is not used
+	int downRelayPin;
+	uint8_t upButton; ///< @brief `NO_BUTTON` if channel is only controlled remotely
+	uint8_t downButton;
+	clock_t fullTravellingTime; ///< @brief Time to roll down completely
+	clock_t upTravellingTime; ///< @brief Time to roll up completely. 0 if it is the same as `fullTravellingTime`
+	clock_t startDelay; ///< @brief Time since relay is switched on until blind starts moving
+	clock_t runOnTime; ///< @brief Time that blind keeps moving after relay is switched off
+	clock_t relayDeadTime; ///< @brief Minimum time with both relays off before reversing direction
+	uint16_t groups; ///< @brief Bit `n - 1` is set if blind belongs to group `n`
+	int8_t presets[BLIND_PRESETS]; ///< @brief Angle of every preset. -1 if preset is not set
+	uint8_t upPressPreset[BLIND_PRESET_PRESSES]; ///< @brief Preset recalled by pressing up button `PRESET_FIRST_PRESS` or more times. 0 for none
+	uint8_t downPressPreset[BLIND_PRESET_PRESSES]; ///< @brief Preset recalled by pressing down button `PRESET_FIRST_PRESS` or more times. 0 for none
+};
+
+/**
+  * @brief Movement that node runs by itself at a local time
+  */
+struct blindSchedule_t {
+	uint16_t minute; ///< @brief Local time of day, in minutes since midnight
+	uint16_t jitter; ///< @brief Movement starts after a random delay up to this value, in seconds
+	uint8_t days; ///< @brief Bit 0 is Monday and bit 6 is Sunday. 0 if entry is not used
+	uint8_t channel; ///< @brief Blind that moves
+	uint8_t action; ///< @brief `ACTION_GOTO`, `ACTION_FULL_UP`, `ACTION_FULL_DOWN` or `ACTION_PRESET`
+	int8_t pos; ///< @brief Target of `ACTION_GOTO` or preset number of `ACTION_PRESET`
+	uint8_t priority; ///< @brief Priority of started movement, as `prio` key of commands
+};
+
+/**
+  * @brief Settings shared by all blinds of a controller
+  */
+struct blindConfig_t {
+	int ON_STATE;
+	telemetryEncoding_t telemetryEncoding;
+	curveProfile_t curveProfile;
+	uint8_t curvePoints[CURVE_POINTS]; ///< @brief Linear position for every 10% of angle when using custom curve
+	uint8_t reportStep; ///< @brief Position change in % that triggers a notification while moving. 0 to notify every `fullTravellingTime / NOTIF_PERIOD_RATIO`
+	clock_t reportMinInterval; ///< @brief Minimum time between position notifications while moving
+	clock_t reportMaxInterval; ///< @brief Maximum time without notifications when `reportStep` is not 0. `fullTravellingTime * KEEP_ALIVE_PERIOD_RATIO` is used otherwise
+	bool clockSync; ///< @brief Enables clock synchronization so that commands may be scheduled with `at` key
+	blindSchedule_t schedule[BLIND_SCHEDULE_SIZE]; ///< @brief Movements run at local times
+	int16_t utcOffset; ///< @brief Minutes added to network time to get local time of schedule
+	bool mergedResponse; ///< @brief Movement command responses carry resulting state, instead of a separate notification
+};
+
+/**
+  * @brief Configuration as stored on flash. New fields must be added at the end, increasing `CONFIG_VERSION`
+  */
+struct blindConfigRecord_t {
+	uint32_t fullTravellingTime; ///< @brief First channel travel time
+	uint32_t reportMinInterval;
+	uint32_t reportMaxInterval;
+	uint8_t telemetryEncoding;
+	uint8_t curveProfile;
+	uint8_t reportStep;
+	uint8_t curvePoints[CURVE_POINTS];
+	uint32_t channelTravellingTime[BLIND_MAX_CHANNELS - 1]; ///< @brief Travel time of channels after first one. Version 2
+	uint32_t upTravellingTime[BLIND_MAX_CHANNELS]; ///< @brief Version 3
+	uint16_t startDelay[BLIND_MAX_CHANNELS]; ///< @brief Version 3
+	uint16_t runOnTime[BLIND_MAX_CHANNELS]; ///< @brief Version 3
+	uint16_t groups[BLIND_MAX_CHANNELS]; ///< @brief Version 4
+	uint8_t clockSync; ///< @brief Version 5
+	uint16_t relayDeadTime[BLIND_MAX_CHANNELS]; ///< @brief Version 6
+	int8_t presets[BLIND_MAX_CHANNELS][BLIND_PRESETS]; ///< @brief Version 7
+	uint8_t upPressPreset[BLIND_MAX_CHANNELS][BLIND_PRESET_PRESSES]; ///< @brief Version 7
+	uint8_t downPressPreset[BLIND_MAX_CHANNELS][BLIND_PRESET_PRESSES]; ///< @brief Version 7
+	blindSchedule_t schedule[BLIND_SCHEDULE_SIZE]; ///< @brief Version 8
+	int16_t utcOffset; ///< @brief Version 8
+	uint8_t mergedResponse; ///< @brief Version 9
+};
+
+/**
+  * @brief Step of a command queue
+  */
+typedef enum {
+	ACTION_NONE = 0,
+	ACTION_GOTO = 1,
+	ACTION_FULL_UP = 2,
+	ACTION_FULL_DOWN = 3,
+	ACTION_WAIT = 4,
+	ACTION_PRESET = 5
+} blindAction_t;
+
+/**
+  * @brief Queued step. Every step but first one waits until blind stops and previous pause has elapsed
+  */
+struct blindStep_t {
+	uint32_t wait; ///< @brief Pause length of `ACTION_WAIT`, in ms
+	uint8_t action; ///< @brief `blindAction_t` value
+	int8_t pos; ///< @brief Target of `ACTION_GOTO` or preset number of `ACTION_PRESET`
+};
+
+/**
+  * @brief Blind status fields that a response may carry. Bit mask
+  */
+typedef enum {
+	FIELD_STATE = 1, ///< @brief `state` key
+	FIELD_POSITION = 2, ///< @brief `pos` key
+	FIELD_TARGET = 4, ///< @brief `to` key. Angle where current movement ends
+	FIELD_TIME_LEFT = 8, ///< @brief `eta` key. Time until current movement ends, in ms
+	FIELD_TRAVEL_TIME = 16, ///< @brief `time` key. Full travel time
+	FIELD_GROUPS = 32 ///< @brief `groups` key
+} responseField_t;
+
+constexpr auto RESPONSE_FIELDS_STATUS = FIELD_STATE | FIELD_POSITION | FIELD_TARGET | FIELD_TIME_LEFT; ///< @brief Fields of a merged response
+
 typedef enum {
 	rollingUp = 1,
 	rollingDown = 2,
@@ -34,6 +201,44 @@ typedef enum {
 	error = 0
 } blindState_t;
 
+/**
+  * @brief Downlink command decoded in place from received MsgPack payload
+  */
+struct blindCommand_t {
+	const char* cmd; ///< @brief Command name. Points to received buffer so it is not null terminated
+	size_t cmdLen; ///< @brief Command name length
+	int32_t pos; ///< @brief Requested position. Valid if `hasPos` is `true`
+	int32_t time; ///< @brief Requested travel time. Valid if `hasTime` is `true`
+	int32_t channel; ///< @brief Blind the command applies to. 0 if command has no `ch` key
+	int32_t group; ///< @brief Target group of a broadcast command. Valid if `hasGroup` is `true`
+	uint16_t groups; ///< @brief Group membership mask. Valid if `hasGroups` is `true`
+	int64_t at; ///< @brief Network time when movement has to start. Valid if `hasAt` is `true`
+	int32_t priority; ///< @brief Commands with lower priority than queued steps are rejected. 0 if command has no `prio` key
+	int32_t id; ///< @brief Preset or schedule entry number. Valid if `hasId` is `true`
+	int32_t button; ///< @brief `button_t` value. Valid if `hasButton` is `true`
+	int32_t count; ///< @brief Number of button presses. 0 if command has no `num` key
+	const char* action; ///< @brief Command run by a schedule entry. Points to received buffer. `NULL` if command has no `do` key
+	size_t actionLen; ///< @brief Length of `action`
+	int32_t preset; ///< @brief Preset recalled by a schedule entry. Valid if `hasPreset` is `true`
+	int32_t minute; ///< @brief Schedule entry time of day, in minutes since midnight. Valid if `hasMinute` is `true`
+	int32_t days; ///< @brief Schedule entry weekday mask. 0 if command has no `days` key
+	int32_t jitter; ///< @brief Schedule entry random delay window, in seconds
+	int32_t utcOffset; ///< @brief Local time offset, in minutes. Valid if `hasUtcOffset` is `true`
+	uint8_t fields; ///< @brief `responseField_t` mask asked by `get` command. 0 if command has no `keys` key
+	blindStep_t steps[BLIND_QUEUE_SIZE]; ///< @brief Sequence of `seq` command
+	uint8_t stepCount; ///< @brief Number of elements in `steps`
+	bool hasPos;
+	bool hasTime;
+	bool hasGroup;
+	bool hasGroups;
+	bool hasAt;
+	bool hasId;
+	bool hasButton;
+	bool hasPreset;
+	bool hasMinute;
+	bool hasUtcOffset;
+};
+
 typedef enum {
 	UP_BUTTON,
 	DOWN_BUTTON
@@ -46,26 +251,88 @@ typedef enum {
 #error This code only supports ESP8266 or ESP32 platforms
 #endif
 
-#define CONTROLLER_CLASS_NAME BlindController
 static const char* CONTROLLER_NAME = "Blind controller";
 
-class CONTROLLER_CLASS_NAME : EnigmaIOTjsonController {
+/**
+  * @brief Drives `CHANNELS` blinds from a single node
+  *
+  * Blind state is kept as one array per field, indexed by channel. Commands select a blind with `ch` key and
+  * notifications include it when there is more than one channel.
+  */
+template <uint8_t CHANNELS>
+class MultiBlindController : EnigmaIOTjsonController {
+	static_assert (CHANNELS >= 1 && CHANNELS <= BLIND_MAX_CHANNELS, "Wrong number of channels");
+	static_assert (BLIND_MAX_CHANNELS <= POSITION_MAX_CHANNELS && BLIND_MAX_CHANNELS <= UPLINK_LOW_LANE_MAX, "Not enough room for every channel");
+
 protected:
-	blindControlerHw_t config;
+	blindConfig_t config; ///< @brief Settings shared by all blinds
+	blindChannelHw_t channelConfig[CHANNELS]; ///< @brief Pins and travel time of every blind
+	bool configStored = false; ///< @brief Configuration was read from or saved to flash, so `setup` data does not replace it
 	int OFF_STATE;
-	DebounceEvent* upButton;
-	DebounceEvent* downButton;
-	int8_t position = -1;
-	int8_t positionRequest = -1;
-	int8_t originalPosition;
-	int8_t finalPosition;
-	blindState_t blindState = stopped;
-	time_t travellingTime = -1;
-	time_t blindStartedMoving;
-	bool movingUp = false;
-	bool movingDown = false;
+	CayenneLPP* lpp = NULL; ///< @brief Reused buffer for CayenneLPP telemetry frames. Created on `setup`
+	BlindCurve curve; ///< @brief Relation between angle and linear position
+	uplinkFrame_t uplinkLowLane[CHANNELS]; ///< @brief Storage for newest position of every blind waiting for retry
+	UplinkQueue uplink{ uplinkLowLane, CHANNELS }; ///< @brief Outbound messages waiting for retry
+	clock_t lastButtonEvent = 0; ///< @brief Last time a button event was received
+	clock_t nextTask = 0; ///< @brief Time when `loop` has to update state or send a notification
+	LatencyHistogram loopLatency; ///< @brief Duration of `loop` calls that had work to do
+	LatencyHistogram relayLatency; ///< @brief Time since a command is received until relay is switched on
+	HeapStats heapStats; ///< @brief Heap minimums, sampled on every message sent
+	uint32_t rxStarted; ///< @brief Cycle counter when last command was received
+	bool scheduleActive = false; ///< @brief `true` if schedule has any entry
+	clock_t scheduleCheck = 0; ///< @brief Time when schedule has to be checked again, as `millis ()` value
+	int32_t lastScheduleMinute = -1; ///< @brief Last local minute, since epoch, whose entries were run. -1 before clock is synchronized
+
+	// Blind state. One element per channel
+#if BLIND_BUTTON_ISR
+	buttonInput_t buttonInputs[2 * CHANNELS]; ///< @brief Up and down button of every blind
+	ButtonCapture buttons{ buttonInputs, 2 * CHANNELS };
+#else
+	DebounceEvent* upButton[CHANNELS] = {}; ///< @brief NULL for blinds without up button
+	DebounceEvent* downButton[CHANNELS] = {}; ///< @brief NULL for blinds without down button
+#endif
+	PositionStore positionStore[CHANNELS]; ///< @brief Keeps position across reboots
+	int16_t position[CHANNELS]; ///< @brief Linear position with `POSITION_SHIFT` fractional bits. -1 if not calibrated
+	int16_t positionRequest[CHANNELS]; ///< @brief Linear position where current movement ends, as `position`
+	int8_t angleRequest[CHANNELS]; ///< @brief Angle requested on last go command. Reported while blind stays at requested position
+	int16_t originalPosition[CHANNELS]; ///< @brief Linear position when current movement started
+	int16_t finalPosition[CHANNELS];
+	blindState_t blindState[CHANNELS];
+	time_t travellingTime[CHANNELS]; ///< @brief Relay on time planned for current movement
+	time_t blindStartedMoving[CHANNELS];
+	uint32_t positionSpeed[CHANNELS]; ///< @brief Linear position change per ms of current movement, with 16 more fractional bits
+	bool movingUp[CHANNELS];
+	bool movingDown[CHANNELS];
+	bool relaysOn[CHANNELS]; ///< @brief `true` if any relay may be on. Avoids rewriting relay pins while stopped
+	clock_t relaysOffTime[CHANNELS]; ///< @brief Last time a movement was stopped
+	bool lastMovedUp[CHANNELS]; ///< @brief Direction of last stopped movement
+#if BLIND_RELAY_TIMER
+	RelayTimer cutoffTimer[CHANNELS]; ///< @brief Switches relay off on movement deadline
+	time_t cutoffTime[CHANNELS]; ///< @brief `travellingTime` that timer was armed for. 0 if not armed
+#endif
+	clock_t lastShowedPos[CHANNELS]; ///< @brief Last time position was notified
+	uint16_t reportJitter[CHANNELS]; ///< @brief Random shortening of report periods, in 1/65536 of the largest shortening. Changed on every notification
+	blindState_t lastReportedState[CHANNELS]; ///< @brief State sent on last notification
+	int8_t lastReportedPosition[CHANNELS]; ///< @brief Position sent on last notification
+	blindStep_t queue[CHANNELS][BLIND_QUEUE_SIZE]; ///< @brief Steps waiting to be run
+	uint8_t queueHead[CHANNELS]; ///< @brief Index of next step to run
+	uint8_t queueLength[CHANNELS]; ///< @brief Number of steps in queue, including those already run
+	uint8_t queuePriority[CHANNELS]; ///< @brief Priority of queued steps and of movement started by them
+	clock_t queueResume[CHANNELS]; ///< @brief Time when next step may start, as `millis ()` value
+	uint32_t relayRequested[CHANNELS]; ///< @brief Cycle counter when command that starts next movement was received
+	bool relayLatencyPending[CHANNELS]; ///< @brief `true` if next relay switch on has to be added to `relayLatency`
 	//sendJson_cb sendJson; // Defined on parent class
 
+	typedef bool (MultiBlindController::* commandHandler_t) (const blindCommand_t& rxCommand);
+
+	struct commandEntry_t {
+		const char* name; ///< @brief Value of `cmd` key
+		nodeMessageType_t type; ///< @brief `DOWNSTREAM_DATA_GET` or `DOWNSTREAM_DATA_SET`
+		commandHandler_t handler;
+	};
+
+	static const commandEntry_t commandTable[]; ///< @brief Downlink commands dispatch table
+
 	AsyncWiFiManagerParameter* upRelayPinParam; ///< @brief Configuration field for up relay pin
 	AsyncWiFiManagerParameter* downRelayPinParam; ///< @brief Configuration field for down relay pin
 	AsyncWiFiManagerParameter* upButtonParam; ///< @brief Configuration field for up button pin
@@ -74,12 +341,29 @@ protected:
 	AsyncWiFiManagerParameter* notifPeriodTimeParam; ///< @brief Configuration field for notification period time
 	AsyncWiFiManagerParameter* keepAlivePeriodTimeParam; ///< @brief Configuration field for keep alive time
 	AsyncWiFiManagerParameter* onStateParam; ///< @brief Configuration field for on state value for relay pins
+	AsyncWiFiManagerParameter* telemetryEncodingParam; ///< @brief Configuration field for compact telemetry encoding
+	AsyncWiFiManagerParameter* curveProfileParam; ///< @brief Configuration field for angle curve profile
+	AsyncWiFiManagerParameter* reportStepParam; ///< @brief Configuration field for position notification step
 
 public:
+	/**
+	  * @brief Starts controller
+	  * @param node EnigmaIOT node instance
+	  * @param data Optional array of `CHANNELS` `blindControlerHw_t` elements with wiring of every blind. Its settings
+	  * are only used if no configuration is stored
+	  */
 	void setup (EnigmaIOTNodeClass* node, void* data = NULL);
 	bool processRxCommand (const uint8_t* mac, const uint8_t* buffer, uint8_t length, nodeMessageType_t command, nodePayloadEncoding_t payloadEncoding);
 	void loop ();
-	~CONTROLLER_CLASS_NAME ();
+
+	/**
+	  * @brief Gets time that main loop may sleep before calling `loop` again
+	  *
+	  * Buttons are still polled every `IDLE_POLL_PERIOD` ms. No sleep is allowed while a button is being used.
+	  * @return Time in ms. 0 if `loop` has work to do
+	  */
+	uint32_t idleTime ();
+	~MultiBlindController ();
 	/**
 	 * @brief Called when wifi manager starts config portal
 	 * @param enigmaIotGw Pointer to EnigmaIOT gateway instance
@@ -108,21 +392,99 @@ protected:
 	  * @return Returns `true` if save was successful. `false` otherwise
 	  */
 	bool saveConfig ();
+	/**
+	  * @brief Loads configuration binary record
+	  * @return Returns `false` if stored record is not valid
+	  */
+	bool loadBinaryConfig ();
+	/**
+	  * @brief Loads configuration from JSON file written by older versions
+	  * @return Returns `false` if file could not be parsed
+	  */
+	bool importJsonConfig ();
+	void configToRecord (blindConfigRecord_t& record);
 
 	void defaultConfig ();
 	void configurePins ();
 
-	void rollup ();
-	void rolldown ();
-	void stop ();
-	void fullRollup ();
-	void fullRolldown ();
-	bool gotoPosition (int pos);
-	int8_t getPosition () {
-		return position;
+	/**
+	  * @brief Checks if a blind is connected to channel
+	  */
+	bool channelEnabled (uint8_t channel) {
+		return channelConfig[channel].upRelayPin != NO_PIN && channelConfig[channel].downRelayPin != NO_PIN;
 	}
-	blindState_t getState () {
-		return blindState;
+
+	/**
+	  * @brief Drives relays and updates position of every blind according to its state
+	  */
+	void updateState ();
+	void updateState (uint8_t channel);
+	void rollup (uint8_t channel);
+	void rolldown (uint8_t channel);
+	void stop (uint8_t channel);
+	/**
+	  * @brief Arms relay cutoff timer for current movement. Does nothing if movement has no planned end or timer is already armed for it
+	  * @param pin Relay pin that is on
+	  */
+	void armCutoff (uint8_t channel, int pin);
+	void disarmCutoff (uint8_t channel) {
+#if BLIND_RELAY_TIMER
+		cutoffTimer[channel].disarm ();
+		cutoffTime[channel] = 0;
+#else
+		(void)channel;
+#endif
+	}
+	/**
+	  * @brief Checks if cutoff timer has switched relay off. Movement is over even if `loop` has not reached its deadline yet,
+	  * so that a retarget is not taken as extension of a movement whose motor is already stopped
+	  */
+	bool cutoffFired (uint8_t channel) {
+#if BLIND_RELAY_TIMER
+		return cutoffTime[channel] && !cutoffTimer[channel].armed ();
+#else
+		(void)channel;
+		return false;
+#endif
+	}
+	/**
+	  * @brief Moves stop deadline of a running movement when new target is further in the same direction
+	  * @param target Linear position with `POSITION_SHIFT` fractional bits
+	  * @return Returns `false` if blind is not moving towards `target`
+	  */
+	bool retarget (uint8_t channel, int target);
+	/**
+	  * @brief Gets time that relays have to stay off before blind may start moving in a direction
+	  * @param up `true` for rolling up
+	  * @return Time in ms. 0 if there is no pending dead time
+	  */
+	clock_t deadTimeLeft (uint8_t channel, bool up) {
+		clock_t elapsed = millis () - relaysOffTime[channel];
+		if (up == lastMovedUp[channel] || elapsed >= channelConfig[channel].relayDeadTime) {
+			return 0;
+		}
+		return channelConfig[channel].relayDeadTime - elapsed;
+	}
+	void fullRollup (uint8_t channel = 0);
+	void fullRolldown (uint8_t channel = 0);
+	bool gotoPosition (int pos, uint8_t channel = 0);
+	/**
+	  * @brief Gets linear position rounded to integer percentage
+	  * @return Position 0-100 or -1 if position is not calibrated yet
+	  */
+	int8_t getPosition (uint8_t channel = 0) {
+		return toPercent (position[channel]);
+	}
+	static int8_t toPercent (int16_t linearPosition) {
+		return linearPosition == -1 ? -1 : (linearPosition + (1 << (POSITION_SHIFT - 1))) >> POSITION_SHIFT;
+	}
+	/**
+	  * @brief Gets blind position as seen by user
+	  * @return Angle 0-100 or -1 if position is not calibrated yet
+	  */
+	int8_t getAngle (uint8_t channel = 0);
+	blindState_t getState (uint8_t channel = 0) {
+		return blindState[channel];
 	}
 	const char* stateToStr (int state) {
 		switch (state) {
@@ -132,24 +494,260 @@ protected:
 			return "Rolling down";
 		case stopped:
 			return "Stopped";
+		default:
+			return "Error";
 		}
 	}
-	void requestStop ();
-	void setTravelTime (int travelTime);
-	void callbackUpButton (uint8_t pin, uint8_t event, uint8_t count, uint16_t length);
-	void callbackDownButton (uint8_t pin, uint8_t event, uint8_t count, uint16_t length);
-	bool sendButtonPress (button_t button, int count);
-	int8_t timeToPos (time_t movementTime) {
-		return movementTime * 100 / config.fullTravellingTime;
+	/**
+	  * @brief Stops blind and clears its queue
+	  * @param notify Sends new state. Merged command response carries it otherwise
+	  */
+	void requestStop (uint8_t channel, bool notify = true);
+	/**
+	  * @brief Gets angle where current movement ends, or current angle if blind is stopped
+	  */
+	int8_t getTargetAngle (uint8_t channel);
+	/**
+	  * @brief Gets time until current movement ends, in ms. 0 if blind is stopped
+	  */
+	clock_t getTimeLeft (uint8_t channel);
+	/**
+	  * @brief Starts a movement now or, if command has `at` key, schedules it to start at that network time
+	  * @return Returns `false` if movement cannot be done, start time is too far or blind runs a higher priority command
+	  */
+	bool startAction (uint8_t channel, blindAction_t action, const blindCommand_t& rxCommand);
+	/**
+	  * @brief Replaces queued steps of a blind. First step preempts current movement and starts at `at` time if it is given
+	  * @return Returns `false` if start time is too far or blind runs a higher priority command
+	  */
+	bool enqueue (uint8_t channel, const blindStep_t* steps, uint8_t count, const blindCommand_t& rxCommand);
+	/**
+	  * @brief Runs queued steps that are due. Queue is cleared if a step fails
+	  * @param fromCommand `true` if called while processing a command, so that relay latency is measured
+	  * @return Returns `false` if a step could not be run
+	  */
+	bool runQueue (uint8_t channel, bool fromCommand = false);
+	bool runAction (uint8_t channel, blindAction_t action, int pos);
+	/**
+	  * @brief Moves blind to a stored preset
+	  * @param preset Preset number, from 1 to `BLIND_PRESETS`
+	  * @return Returns `false` if preset is not set or position is not calibrated
+	  */
+	bool recallPreset (uint8_t channel, int preset);
+	bool presetSet (uint8_t channel, int preset) {
+		return preset >= 1 && preset <= BLIND_PRESETS && channelConfig[channel].presets[preset - 1] != -1;
+	}
+	/**
+	  * @brief Gets preset bound to a button press count
+	  * @param bindings `upPressPreset` or `downPressPreset` of a blind
+	  * @return Preset number. 0 if press count has no preset
+	  */
+	static uint8_t pressPreset (const uint8_t* bindings, uint8_t count) {
+		return count >= PRESET_FIRST_PRESS && count < PRESET_FIRST_PRESS + BLIND_PRESET_PRESSES ? bindings[count - PRESET_FIRST_PRESS] : 0;
+	}
+	void clearQueue (uint8_t channel) {
+		queueHead[channel] = 0;
+		queueLength[channel] = 0;
+		queuePriority[channel] = 0;
+		relayLatencyPending[channel] = false;
+	}
+	bool queuePending (uint8_t channel) {
+		return queueHead[channel] < queueLength[channel];
 	}
-	time_t movementToTime (int8_t movement);
-	void sendPosition ();
+	/**
+	  * @brief Checks if next step only waits for its time. Steps after first one wait for blind to stop too
+	  */
+	bool queueReady (uint8_t channel) {
+		return queuePending (channel) && (queueHead[channel] == 0 || blindState[channel] == stopped);
+	}
+	void setTravelTime (uint8_t channel, int travelTime);
+	void callbackUpButton (uint8_t channel, uint8_t pin, uint8_t event, uint8_t count, uint16_t length);
+	void callbackDownButton (uint8_t channel, uint8_t pin, uint8_t event, uint8_t count, uint16_t length);
+	bool sendButtonPress (uint8_t channel, button_t button, int count);
+	/**
+	  * @brief Gets time to travel between both ends, not including start delay
+	  * @param up `true` for rolling up
+	  */
+	clock_t travelTime (uint8_t channel, bool up) {
+		return up && channelConfig[channel].upTravellingTime ? channelConfig[channel].upTravellingTime : channelConfig[channel].fullTravellingTime;
+	}
+	/**
+	  * @brief Calculates linear position change per ms of relay on time, with 16 more fractional bits than `position`
+	  */
+	uint32_t movementSpeed (uint8_t channel, bool up) {
+		clock_t time = travelTime (channel, up);
+		return time ? ((uint32_t)POSITION_FULL << 16) / time : 0; // Not used without travel time. `timeToPos` returns full movement
+	}
+	/**
+	  * @brief Calculates position change of current movement after relay has been on for some time.
+	  * Uses speed calculated when movement started so that no division is needed while moving
+	  * @param movementTime Time since relay was switched on, in ms
+	  * @return Linear position change with `POSITION_SHIFT` fractional bits
+	  */
+	int16_t timeToPos (uint8_t channel, time_t movementTime);
+	/**
+	  * @brief Calculates how long relay has to be on to move blind some distance, compensating start and run on delays
+	  * @param up `true` for rolling up
+	  * @param movement Linear position change with `POSITION_SHIFT` fractional bits
+	  */
+	time_t movementToTime (uint8_t channel, bool up, int16_t movement);
+	/**
+	  * @brief Gets relay on time for a full movement, with a margin to make sure that blind reaches its end
+	  */
+	time_t fullMovementTime (uint8_t channel, bool up) {
+		return channelConfig[channel].startDelay + travelTime (channel, up) * 1.1;
+	}
+	/**
+	  * @brief Sends position on state change, on position change while moving and as keep alive if nothing was sent for `maxReportInterval`
+	  */
+	void sendPosition (uint8_t channel);
+	/**
+	  * @brief Checks if position has changed more than `reportStep` since last notification
+	  */
+	bool positionChanged (uint8_t channel);
+	/**
+	  * @brief Gets period of position notifications while moving, when `reportStep` is 0
+	  */
+	clock_t notifPeriod (uint8_t channel);
+	/**
+	  * @brief Gets maximum time without notifications. Blind sends a keep alive when it elapses
+	  */
+	clock_t maxReportInterval (uint8_t channel);
+	/**
+	  * @brief Shortens a report period by a random part, so that blinds that reported together drift apart
+	  */
+	clock_t withJitter (uint8_t channel, clock_t period);
+	/**
+	  * @brief Calculates next time `loop` has work to do: movement end, position notification or keep alive
+	  * @return Deadline as `millis ()` value
+	  */
+	clock_t nextDeadline ();
+	clock_t nextDeadline (uint8_t channel, clock_t now);
+	/**
+	  * @brief Forces `loop` to process state on next call. Must be called on every state or configuration change
+	  */
+	void wakeUp () {
+		nextTask = millis ();
+	}
+	bool buttonActive ();
+	/**
+	  * @brief Checks if schedule has entries and, if so, enables clock synchronization and checks schedule on next `loop`
+	  */
+	void startSchedule ();
+	/**
+	  * @brief Runs entries of every local minute since last check and sets `scheduleCheck` to next minute start
+	  */
+	void runSchedule ();
+	void runSchedule (int32_t minute);
+	/**
+	  * @brief Fills a schedule entry from a `sched` command
+	  * @return Returns `false` if command has no valid time or action
+	  */
+	bool decodeScheduleEntry (const blindCommand_t& rxCommand, blindSchedule_t& entry);
+
+	/**
+	  * @brief Adds channel number to a message. Nothing is added on single blind controllers, so that messages do not change
+	  */
+	void addChannel (DynamicJsonDocument& json, uint8_t channel);
+
+	/**
+	  * @brief Decodes a MsgPack command directly from received buffer, without copies or heap usage
+	  * @param buffer Received payload
+	  * @param length Payload length
+	  * @param rxCommand Decoded command
+	  * @return Returns `false` if payload is not a map or does not contain a `cmd` string
+	  */
+	bool decodeCommand (const uint8_t* buffer, uint8_t length, blindCommand_t& rxCommand);
+	/**
+	  * @brief Decodes a one byte preset recall. Low nibble is preset number and high nibble is blind
+	  */
+	void decodePresetByte (uint8_t value, blindCommand_t& rxCommand);
+	bool processGetPositionCommand (const blindCommand_t& rxCommand);
+	bool processGetStateCommand (const blindCommand_t& rxCommand);
+	bool processGetTravelTimeCommand (const blindCommand_t& rxCommand);
+	bool processFullUpCommand (const blindCommand_t& rxCommand);
+	bool processFullDownCommand (const blindCommand_t& rxCommand);
+	bool processGotoCommand (const blindCommand_t& rxCommand);
+	bool processSequenceCommand (const blindCommand_t& rxCommand);
+	bool processStopCommand (const blindCommand_t& rxCommand);
+	bool processSetTravelTimeCommand (const blindCommand_t& rxCommand);
+	bool processGetGroupsCommand (const blindCommand_t& rxCommand);
+	bool processSetGroupsCommand (const blindCommand_t& rxCommand);
+	bool processGetStatsCommand (const blindCommand_t& rxCommand);
+	bool processGetPresetsCommand (const blindCommand_t& rxCommand);
+	bool processRecallPresetCommand (const blindCommand_t& rxCommand);
+	bool processSavePresetCommand (const blindCommand_t& rxCommand);
+	bool processBindPresetCommand (const blindCommand_t& rxCommand);
+	bool processGetScheduleCommand (const blindCommand_t& rxCommand);
+	bool processSetScheduleCommand (const blindCommand_t& rxCommand);
+	bool processGetFieldsCommand (const blindCommand_t& rxCommand);
+	/**
+	  * @brief Runs a movement command on every blind that belongs to target group. No response is sent, so that
+	  * a broadcast command does not trigger a response from every node
+	  * @return Returns `false` if command is not a movement command
+	  */
+	bool processGroupCommand (nodeMessageType_t command, const blindCommand_t& rxCommand);
+	/**
+	  * @brief Checks if command responses have to carry blind state. CayenneLPP telemetry keeps state on its own frames
+	  */
+	bool mergeResponses () {
+		return config.mergedResponse && config.telemetryEncoding != TELEMETRY_CAYENNELPP;
+	}
+	bool inGroup (uint8_t channel, int32_t group) {
+		return group == 0 || (channelConfig[channel].groups & (1 << (group - 1)));
+	}
+
+	bool sendGetTravelTime (uint8_t channel);
+	bool sendGetGroups (uint8_t channel);
+	bool sendGetPresets (uint8_t channel);
+	bool sendGetSchedule ();
+	/**
+	  * @brief Sends latency histograms and heap minimums and clears them once message is sent or queued
+	  */
+	bool sendStats ();
+	bool sendGetPosition (uint8_t channel);
+	bool sendGetStatus (uint8_t channel = 0);
+	/**
+	  * @brief Sends any set of blind status fields in a single message
+	  * @param fields `responseField_t` mask
+	  */
+	bool sendGetFields (uint8_t channel, uint8_t fields);
+	/**
+	  * @brief Adds blind status fields to a message
+	  * @param fields `responseField_t` mask
+	  */
+	void addFields (DynamicJsonDocument& json, uint8_t channel, uint8_t fields);
+	/**
+	  * @brief Sends command result. With `mergedResponse` it carries `RESPONSE_FIELDS_STATUS` too and counts as
+	  * state notification, so that no other message follows until state changes again
+	  */
+	bool sendCommandResp (const char* command, bool result, uint8_t channel);
+	void processBlindEvent (uint8_t channel, blindState_t state, int8_t position, uplinkPriority_t priority = UPLINK_HIGH);
+	/**
+	  * @brief Records a state notification. Sets what is compared to decide when next one is needed
+	  */
+	void setReported (uint8_t channel, blindState_t state, int8_t position);
 
-	bool sendGetTravelTime ();
-	bool sendGetPosition ();
-	bool sendGetStatus ();
-	bool sendCommandResp (const char* command, bool result);
-	void processBlindEvent (blindState_t state, int8_t position);
+	/**
+	  * @brief Sends blind state and position as a CayenneLPP frame
+	  * @param channel Blind number. Selects LPP channels
+	  * @param state Blind state
+	  * @param position Blind position. -1 is sent as 255
+	  * @param priority Uplink queue lane
+	  * @return Returns `true` if message was sent or queued
+	  */
+	bool sendStateLpp (uint8_t channel, blindState_t state, int8_t position, uplinkPriority_t priority = UPLINK_HIGH);
+	/**
+	  * @brief Sends a frame through uplink queue so that it is retried if radio is busy
+	  * @param slot Low priority slot. Blind number for position messages
+	  * @return Returns `true` if message was sent or queued
+	  */
+	bool sendUplink (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, uplinkPriority_t priority = UPLINK_HIGH, uint8_t slot = 0);
+	/**
+	  * @brief Serializes a message as MsgPack directly into uplink queue buffer and sends it
+	  * @return Returns `true` if message was sent or queued
+	  */
+	bool sendUplinkJson (DynamicJsonDocument& json, uplinkPriority_t priority = UPLINK_HIGH, uint8_t slot = 0);
 
     bool sendStartAnouncement () {
         // You can send a 'hello' message when your node starts. Useful to detect unexpected reboot
@@ -161,10 +759,16 @@ protected:
         snprintf (version_buf, 10, "%d.%d.%d",
                   ENIGMAIOT_PROT_VERS[0], ENIGMAIOT_PROT_VERS[1], ENIGMAIOT_PROT_VERS[2]);
         json["version"] = String (version_buf);
+        if (CHANNELS > 1) {
+            json["channels"] = CHANNELS;
+        }
 
-        return sendJson (json);
+        return sendUplinkJson (json);
     }
 };
 
+typedef MultiBlindController<BLIND_CHANNELS> BlindController;
+#define CONTROLLER_CLASS_NAME BlindController
+
 #endif
 
@@ -0,0 +1,108 @@
+//
+//
+//
+
+#include "BlindCurve.h"
+
+// Linear position for angles 0, 10, 20 ... 100
+constexpr uint8_t LINEAR_POINTS[CURVE_POINTS] = { 0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100 };
+constexpr uint8_t AWNING_POINTS[CURVE_POINTS] = { 0, 1, 5, 11, 19, 29, 41, 55, 69, 84, 100 };
+constexpr uint8_t ROLLER_POINTS[CURVE_POINTS] = { 0, 12, 23, 34, 44, 54, 63, 73, 82, 91, 100 };
+
+constexpr bool curvePointsValid (const uint8_t* points, uint8_t i = 1) {
+	return i >= CURVE_POINTS ? (points[0] == 0 && points[CURVE_POINTS - 1] == 100)
+		: (points[i] > points[i - 1] && curvePointsValid (points, i + 1));
+}
+
+constexpr uint16_t curveForward (const uint8_t* points, uint8_t angle) {
+	return angle >= 100 ? points[CURVE_POINTS - 1] << 8
+		: (points[angle / 10] << 8) + ((points[angle / 10 + 1] - points[angle / 10]) * 256 * (angle % 10) + 5) / 10;
+}
+
+// Index of curve segment that contains a linear position
+constexpr uint8_t curveSegment (const uint8_t* points, uint8_t position, uint8_t segment = 0) {
+	return (segment >= CURVE_POINTS - 2 || position < points[segment + 1]) ? segment
+		: curveSegment (points, position, segment + 1);
+}
+
+constexpr uint16_t curveInverseInSegment (const uint8_t* points, uint8_t position, uint8_t segment) {
+	return ((segment * 10) << 8) + ((position - points[segment]) * 2560 + (points[segment + 1] - points[segment]) / 2) / (points[segment + 1] - points[segment]);
+}
+
+constexpr uint16_t curveInverse (const uint8_t* points, uint8_t position) {
+	return curveInverseInSegment (points, position, curveSegment (points, position));
+}
+
+template <size_t... Is> struct indexSequence {};
+template <size_t N, size_t... Is> struct makeIndexSequence : makeIndexSequence<N - 1, N - 1, Is...> {};
+template <size_t... Is> struct makeIndexSequence<0, Is...> {
+	typedef indexSequence<Is...> type;
+};
+
+template <size_t... Is>
+constexpr curveTable_t makeCurveTable (const uint8_t* points, indexSequence<Is...>) {
+	return curveTable_t { { curveForward (points, Is)... }, { curveInverse (points, Is)... } };
+}
+
+static_assert (curvePointsValid (LINEAR_POINTS), "Wrong linear curve definition");
+static_assert (curvePointsValid (AWNING_POINTS), "Wrong awning curve definition");
+static_assert (curvePointsValid (ROLLER_POINTS), "Wrong roller curve definition");
+
+static constexpr curveTable_t linearTable PROGMEM = makeCurveTable (LINEAR_POINTS, makeIndexSequence<CURVE_TABLE_SIZE>::type ());
+static constexpr curveTable_t awningTable PROGMEM = makeCurveTable (AWNING_POINTS, makeIndexSequence<CURVE_TABLE_SIZE>::type ());
+static constexpr curveTable_t rollerTable PROGMEM = makeCurveTable (ROLLER_POINTS, makeIndexSequence<CURVE_TABLE_SIZE>::type ());
+
+BlindCurve::~BlindCurve () {
+	delete (customTable);
+}
+
+bool BlindCurve::checkPoints (const uint8_t* points) {
+	return points && curvePointsValid (points);
+}
+
+bool BlindCurve::begin (curveProfile_t profile, const uint8_t* points) {
+	delete (customTable);
+	customTable = NULL;
+
+	switch (profile) {
+	case CURVE_AWNING:
+		table = &awningTable;
+		return true;
+	case CURVE_ROLLER:
+		table = &rollerTable;
+		return true;
+	case CURVE_CUSTOM:
+		if (checkPoints (points)) {
+			customTable = new curveTable_t;
+			for (uint8_t i = 0; i < CURVE_TABLE_SIZE; i++) {
+				customTable->forward[i] = curveForward (points, i);
+				customTable->inverse[i] = curveInverse (points, i);
+			}
+			table = customTable;
+			return true;
+		}
+		table = &linearTable;
+		return false;
+	default:
+		table = &linearTable;
+		return true;
+	}
+}
+
+uint16_t BlindCurve::angleToPosition (uint8_t angle) const {
+	if (angle > 100) {
+		angle = 100;
+	}
+	return pgm_read_word (&table->forward[angle]);
+}
+
+uint8_t BlindCurve::positionToAngle (uint16_t position) const {
+	uint8_t index = position >> 8;
+	if (index >= 100) {
+		return 100;
+	}
+	uint16_t low = pgm_read_word (&table->inverse[index]);
+	uint16_t high = pgm_read_word (&table->inverse[index + 1]);
+	uint32_t angle = low + (((uint32_t)(high - low) * (position & 0xFF) + 128) >> 8);
+	return (angle + 128) >> 8;
+}
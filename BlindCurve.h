@@ -0,0 +1,79 @@
+// BlindCurve.h
+
+#ifndef _BLINDCURVE_h
+#define _BLINDCURVE_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+
+constexpr auto CURVE_POINTS = 11; ///< @brief Curves are defined by linear position every 10% of angle
+constexpr auto CURVE_TABLE_SIZE = 101;
+
+/**
+  * @brief Relation between blind angle (position as seen by user) and linear position (proportional to motor run time)
+  */
+typedef enum {
+	CURVE_LINEAR = 0, ///< @brief Angle equals linear position
+	CURVE_AWNING = 1, ///< @brief Articulated arm awning
+	CURVE_ROLLER = 2, ///< @brief Roller blind. Fabric speed increases as roll diameter grows
+	CURVE_CUSTOM = 3 ///< @brief Curve points loaded from configuration
+} curveProfile_t;
+
+/**
+  * @brief Conversion tables. All values are fixed point with 8 fractional bits
+  */
+struct curveTable_t {
+	uint16_t forward[CURVE_TABLE_SIZE]; ///< @brief Linear position for every integer angle
+	uint16_t inverse[CURVE_TABLE_SIZE]; ///< @brief Angle for every integer linear position
+};
+
+/**
+  * @brief Converts between angle and linear position in constant time
+  *
+  * Curves are piecewise linear between points placed every 10% of angle. Since point values are
+  * integer percentages, interpolating inverse table between integer linear positions is exact, so
+  * converting an angle to linear position and back returns the same angle.
+  */
+class BlindCurve {
+public:
+	BlindCurve () {
+		begin (CURVE_LINEAR);
+	}
+	~BlindCurve ();
+
+	/**
+	  * @brief Selects curve profile
+	  * @param profile Curve profile
+	  * @param points Linear position for angles 0, 10, ... 100. Only used for `CURVE_CUSTOM`
+	  * @return Returns `false` if custom points are not valid. Linear curve is used in that case
+	  */
+	bool begin (curveProfile_t profile, const uint8_t* points = NULL);
+
+	/**
+	  * @brief Gets linear position for an angle
+	  * @param angle Angle 0-100
+	  * @return Linear position 0-100 with 8 fractional bits
+	  */
+	uint16_t angleToPosition (uint8_t angle) const;
+
+	/**
+	  * @brief Gets angle for a linear position
+	  * @param position Linear position 0-100 with 8 fractional bits
+	  * @return Angle 0-100, rounded to nearest integer
+	  */
+	uint8_t positionToAngle (uint16_t position) const;
+
+	/**
+	  * @brief Checks that custom points start at 0, end at 100 and are strictly increasing
+	  */
+	static bool checkPoints (const uint8_t* points);
+
+protected:
+	const curveTable_t* table = NULL;
+	curveTable_t* customTable = NULL;
+};
+
+#endif
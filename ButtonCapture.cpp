@@ -0,0 +1,144 @@
+//
+//
+//
+
+#include "ButtonCapture.h"
+
+constexpr auto NO_INPUT_PIN = 0xFF;
+
+ButtonCapture::ButtonCapture (buttonInput_t* inputs, uint8_t count) : inputs (inputs), count (count) {
+	for (uint8_t i = 0; i < count; i++) {
+		inputs[i].capture = this;
+		inputs[i].pin = NO_INPUT_PIN;
+	}
+}
+
+ButtonCapture::~ButtonCapture () {
+	for (uint8_t i = 0; i < count; i++) {
+		end (i);
+	}
+}
+
+void ButtonCapture::begin (uint8_t input, uint8_t pin, TDebounceEventCallback callback, uint32_t debounceTime, uint32_t repeatTime) {
+	if (input >= count) {
+		return;
+	}
+	end (input);
+	buttonInput_t& state = inputs[input];
+	state.pin = pin;
+	state.callback = callback;
+	state.debounceTime = debounceTime;
+	state.repeatTime = repeatTime;
+	state.pressed = false;
+	state.settling = false;
+	state.ready = false;
+	state.resetCount = true;
+	state.count = 0;
+	state.lastChange = millis () - debounceTime;
+	state.pressStart = 0;
+	state.length = 0;
+	if (pin == NO_INPUT_PIN) {
+		return;
+	}
+	pinMode (pin, INPUT_PULLUP);
+	attachInterruptArg (digitalPinToInterrupt (pin), onEdge, &state, CHANGE);
+}
+
+void ButtonCapture::end (uint8_t input) {
+	if (input < count && inputs[input].pin != NO_INPUT_PIN) {
+		detachInterrupt (digitalPinToInterrupt (inputs[input].pin));
+		inputs[input].pin = NO_INPUT_PIN;
+	}
+}
+
+void IRAM_ATTR ButtonCapture::onEdge (void* arg) {
+	buttonInput_t* input = (buttonInput_t*)arg;
+	ButtonCapture* capture = input->capture;
+	uint8_t next = (capture->head + 1) & (BUTTON_EDGE_QUEUE_SIZE - 1);
+	if (next == capture->tail) {
+		capture->overflow = true;
+		return;
+	}
+	buttonEdge_t& edge = capture->edges[capture->head];
+	edge.time = millis ();
+	edge.input = input - capture->inputs;
+	edge.level = digitalRead (input->pin);
+	capture->head = next; // Edge is visible to loop only after it is complete
+}
+
+void ButtonCapture::loop () {
+	while (tail != head) {
+		const buttonEdge_t& edge = edges[tail];
+		buttonInput_t& input = inputs[edge.input];
+		checkRelease (input, edge.time);
+		if (edge.time - input.lastChange < input.debounceTime) {
+			input.settling = true; // Bounce. Level is checked again when it settles
+		} else {
+			change (input, edge.level == LOW, edge.time);
+		}
+		tail = (tail + 1) & (BUTTON_EDGE_QUEUE_SIZE - 1);
+	}
+
+	uint32_t now = millis ();
+	bool resync = overflow;
+	overflow = false;
+	for (uint8_t i = 0; i < count; i++) {
+		buttonInput_t& input = inputs[i];
+		if (input.pin == NO_INPUT_PIN) {
+			continue;
+		}
+		if ((input.settling && now - input.lastChange >= input.debounceTime) || resync) {
+			input.settling = false;
+			change (input, digitalRead (input.pin) == LOW, now);
+		}
+		checkRelease (input, now);
+	}
+}
+
+void ButtonCapture::change (buttonInput_t& input, bool pressed, uint32_t time) {
+	if (pressed == input.pressed) {
+		return;
+	}
+	input.pressed = pressed;
+	input.lastChange = time;
+	input.settling = true; // Bounces may leave pin on a different level
+	if (pressed) {
+		input.pressStart = time;
+		input.length = 0;
+		if (input.resetCount) {
+			input.count = 1;
+			input.resetCount = false;
+		} else {
+			input.count++;
+		}
+		input.ready = false;
+		if (input.callback) {
+			input.callback (input.pin, EVENT_PRESSED, input.count, input.length);
+		}
+	} else {
+		input.length = time - input.pressStart;
+		input.ready = true;
+	}
+}
+
+void ButtonCapture::checkRelease (buttonInput_t& input, uint32_t time) {
+	if (input.ready && time - input.pressStart > input.repeatTime) {
+		input.ready = false;
+		input.resetCount = true;
+		if (input.callback) {
+			input.callback (input.pin, EVENT_RELEASED, input.count, input.length);
+		}
+	}
+}
+
+bool ButtonCapture::active () {
+	if (tail != head || overflow) {
+		return true;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		if (inputs[i].pressed || inputs[i].settling || inputs[i].ready) {
+			return true;
+		}
+	}
+	return false;
+}
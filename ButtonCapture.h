@@ -0,0 +1,98 @@
+// ButtonCapture.h
+
+#ifndef _BUTTONCAPTURE_h
+#define _BUTTONCAPTURE_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+
+#include <DebounceEvent.h>
+
+constexpr auto BUTTON_EDGE_QUEUE_SIZE = 32; ///< @brief Edges waiting to be processed. Must be a power of 2
+
+/**
+  * @brief Pin change captured by interrupt handler
+  */
+struct buttonEdge_t {
+	uint32_t time; ///< @brief `millis ()` when edge happened
+	uint8_t input; ///< @brief Input index
+	uint8_t level; ///< @brief Pin level after edge
+};
+
+class ButtonCapture;
+
+/**
+  * @brief State of a button input. Debounce and press counting work the same as `DebounceEvent` push buttons
+  */
+struct buttonInput_t {
+	ButtonCapture* capture;
+	uint8_t pin; ///< @brief `NO_BUTTON` if input is not used
+	TDebounceEventCallback callback;
+	uint32_t debounceTime; ///< @brief Edges closer than this to last accepted change are bounces
+	uint32_t repeatTime; ///< @brief Press that comes before this time since last one increments press count
+	bool pressed; ///< @brief Debounced state
+	bool settling; ///< @brief Pin level has to be checked when debounce time ends
+	bool ready; ///< @brief Button was released and release event is waiting for repeat time
+	bool resetCount; ///< @brief Next press starts counting again
+	uint8_t count; ///< @brief Number of presses in a row
+	uint32_t lastChange; ///< @brief Time of last accepted change
+	uint32_t pressStart; ///< @brief Time of last press
+	uint16_t length; ///< @brief Duration of last press
+};
+
+/**
+  * @brief Captures button edges from GPIO interrupts
+  *
+  * Interrupt handler only stores edge time and pin level on a queue. `loop` debounces and counts presses using
+  * those times, so a slow pass through main loop does not delay or merge presses. Callbacks get the same events
+  * as with `DebounceEvent`: `EVENT_PRESSED` on every press and `EVENT_RELEASED` once repeat time has passed.
+  *
+  * Queue has one writer, interrupt handler, and one reader, `loop`. Each index is written by one side only, so
+  * no lock is needed as long as both run on the same core. If queue overflows every input is read again.
+  */
+class ButtonCapture {
+public:
+	/**
+	  * @param inputs Storage for input state. Every input is identified by its index
+	  * @param count Number of inputs
+	  */
+	ButtonCapture (buttonInput_t* inputs, uint8_t count);
+	~ButtonCapture ();
+
+	/**
+	  * @brief Configures a button pin, pulled up and active low, and attaches its interrupt handler
+	  */
+	void begin (uint8_t input, uint8_t pin, TDebounceEventCallback callback, uint32_t debounceTime, uint32_t repeatTime);
+
+	/**
+	  * @brief Detaches interrupt handler of an input
+	  */
+	void end (uint8_t input);
+
+	/**
+	  * @brief Processes captured edges and generates events
+	  */
+	void loop ();
+
+	/**
+	  * @brief Checks if any button is pressed or has events left to be generated
+	  */
+	bool active ();
+
+protected:
+	buttonInput_t* inputs;
+	uint8_t count;
+	buttonEdge_t edges[BUTTON_EDGE_QUEUE_SIZE];
+	volatile uint8_t head = 0; ///< @brief Next edge to be written. Only changed by interrupt handler
+	volatile uint8_t tail = 0; ///< @brief Next edge to be read. Only changed by `loop`
+	volatile bool overflow = false;
+
+	static void onEdge (void* arg);
+	void change (buttonInput_t& input, bool pressed, uint32_t time);
+	void checkRelease (buttonInput_t& input, uint32_t time);
+};
+
+#endif
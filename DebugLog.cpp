@@ -0,0 +1,81 @@
+//
+//
+//
+
+#include "debug.h"
+
+#if DEBUG_BINARY_LOG
+
+DebugLog debugLog;
+
+void DebugLog::header (logRecord_t& record, char level, uint32_t id, uint16_t line) {
+	uint32_t now = millis ();
+	record.data[0] = DEBUG_LOG_START;
+	record.data[2] = level;
+	memcpy (record.data + 3, &now, sizeof (now));
+	memcpy (record.data + 7, &id, sizeof (id));
+	memcpy (record.data + 11, &line, sizeof (line));
+	record.length = 13;
+	record.full = false;
+}
+
+void DebugLog::push (logRecord_t& record) {
+	uint8_t checksum = 0;
+	for (size_t i = 2; i < record.length; i++) {
+		checksum += record.data[i];
+	}
+	record.data[1] = record.length - 2;
+	record.data[record.length++] = checksum;
+
+	if (lost) {
+		logRecord_t lostRecord;
+		header (lostRecord, 'W', DEBUG_LOG_LOST_ID, 0);
+		encode (lostRecord, lost);
+		if (used + lostRecord.length + 1 + record.length > DEBUG_LOG_SIZE) {
+			lost++;
+			return;
+		}
+		lost = 0;
+		push (lostRecord);
+	}
+	if (used + record.length > DEBUG_LOG_SIZE) {
+		lost++;
+		return;
+	}
+	copyIn (record.data, record.length);
+}
+
+void DebugLog::copyIn (const uint8_t* data, size_t length) {
+	size_t tail = (head + used) % DEBUG_LOG_SIZE;
+	size_t first = tail + length > DEBUG_LOG_SIZE ? DEBUG_LOG_SIZE - tail : length;
+	memcpy (buffer + tail, data, first);
+	memcpy (buffer, data + first, length - first);
+	used += length;
+}
+
+void DebugLog::drain (HardwareSerial& port) {
+	while (used) {
+		size_t room = port.availableForWrite ();
+		if (!room) {
+			return;
+		}
+		size_t chunk = head + used > DEBUG_LOG_SIZE ? DEBUG_LOG_SIZE - head : used;
+		if (chunk > room) {
+			chunk = room;
+		}
+		port.write (buffer + head, chunk);
+		head = (head + chunk) % DEBUG_LOG_SIZE;
+		used -= chunk;
+	}
+}
+
+void DebugLog::dump (Print& port) {
+	while (used) {
+		size_t chunk = head + used > DEBUG_LOG_SIZE ? DEBUG_LOG_SIZE - head : used;
+		port.write (buffer + head, chunk);
+		head = (head + chunk) % DEBUG_LOG_SIZE;
+		used -= chunk;
+	}
+}
+
+#endif // DEBUG_BINARY_LOG
@@ -0,0 +1,171 @@
+// DebugLog.h
+
+#ifndef _DEBUGLOG_h
+#define _DEBUGLOG_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+#include <type_traits>
+
+#ifndef DEBUG_LOG_SIZE
+#define DEBUG_LOG_SIZE 1024 ///< @brief RAM used to keep records until they are sent
+#endif
+
+constexpr auto DEBUG_LOG_START = 0xFE; ///< @brief First byte of every record. Never found on UTF-8 text
+constexpr auto DEBUG_LOG_RECORD_SIZE = 96; ///< @brief Maximum record size. Arguments that do not fit are left out
+constexpr auto DEBUG_LOG_MAX_STRING = 32; ///< @brief Longer string arguments are truncated
+constexpr auto DEBUG_LOG_LOST_ID = 0; ///< @brief Format id of record that tells how many records did not fit in buffer
+
+/**
+  * @brief Argument types on a record. Every argument is a type byte followed by its value
+  */
+typedef enum {
+	LOG_ARG_INT32 = 'i', ///< @brief 4 bytes. Signedness is taken from format string
+	LOG_ARG_INT64 = 'I', ///< @brief 8 bytes
+	LOG_ARG_FLOAT = 'f', ///< @brief 4 bytes
+	LOG_ARG_STRING = 's' ///< @brief Length byte and characters, without terminating null
+} logArgType_t;
+
+/**
+  * @brief Debug messages stored as compact binary records instead of being formatted and printed when they happen
+  *
+  * A record holds message level, `millis ()`, a hash of format string calculated on compile time, source line and
+  * arguments. Format strings are not stored on the device. Records wait on a RAM ring buffer and are sent by `drain`,
+  * which only writes what serial port can take without blocking. `blind_logdecode` host tool rebuilds text messages
+  * from source files.
+  *
+  * Record layout, little endian: `DEBUG_LOG_START`, length of following bytes up to checksum, level letter,
+  * time (4 bytes), format id (4 bytes), line (2 bytes), arguments and checksum, sum of bytes from level to last argument.
+  *
+  * Records that do not fit in buffer are counted and reported by a `DEBUG_LOG_LOST_ID` record once there is room.
+  * `write` is not safe to be called from interrupts.
+  */
+class DebugLog {
+public:
+	/**
+	  * @brief FNV-1a hash of a format string. Used as format id
+	  */
+	static constexpr uint32_t hash (const char* text, uint32_t value = 2166136261u) {
+		return *text ? hash (text + 1, (value ^ (uint8_t)*text) * 16777619u) : value;
+	}
+
+	/**
+	  * @brief Stores a record
+	  * @param level Level letter, as shown by text debug output
+	  * @param id Format id calculated by `hash`
+	  * @param line Source line
+	  */
+	template <typename... Args>
+	void write (char level, uint32_t id, uint16_t line, Args... args) {
+		logRecord_t record;
+		header (record, level, id, line);
+		encode (record, args...);
+		push (record);
+	}
+
+	/**
+	  * @brief Sends as many stored bytes as `port` can take without blocking. Meant to be called on idle time
+	  */
+	void drain (HardwareSerial& port);
+
+	/**
+	  * @brief Sends every stored record, waiting for port if needed
+	  */
+	void dump (Print& port);
+
+	/**
+	  * @brief Number of bytes waiting to be sent
+	  */
+	size_t pending () {
+		return used;
+	}
+
+protected:
+	struct logRecord_t {
+		uint8_t data[DEBUG_LOG_RECORD_SIZE];
+		size_t length;
+		bool full; ///< @brief An argument did not fit. Following ones are left out too so that order is kept
+	};
+
+	uint8_t buffer[DEBUG_LOG_SIZE];
+	size_t head = 0; ///< @brief Index of first byte to be sent
+	size_t used = 0; ///< @brief Bytes waiting to be sent
+	uint32_t lost = 0; ///< @brief Records that did not fit since last lost records report
+
+	void header (logRecord_t& record, char level, uint32_t id, uint16_t line);
+	void push (logRecord_t& record);
+	void copyIn (const uint8_t* data, size_t length);
+
+	static bool reserve (logRecord_t& record, size_t size) {
+		record.full = record.full || record.length + size > DEBUG_LOG_RECORD_SIZE - 1; // Keeps room for checksum
+		return !record.full;
+	}
+
+	static void put (logRecord_t& record, uint8_t type, const void* value, size_t size) {
+		if (reserve (record, 1 + size)) {
+			record.data[record.length++] = type;
+			memcpy (record.data + record.length, value, size);
+			record.length += size;
+		}
+	}
+
+	static void encode (logRecord_t&) {}
+
+	template <typename T, typename... Args>
+	static void encode (logRecord_t& record, T value, Args... args) {
+		encodeArg (record, value);
+		encode (record, args...);
+	}
+
+	template <typename T>
+	static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+		encodeArg (logRecord_t& record, T value) {
+		if (sizeof (T) <= 4) {
+			int32_t data = (int32_t)value;
+			put (record, LOG_ARG_INT32, &data, sizeof (data));
+		} else {
+			int64_t data = (int64_t)value;
+			put (record, LOG_ARG_INT64, &data, sizeof (data));
+		}
+	}
+
+	static void encodeArg (logRecord_t& record, double value) {
+		float data = value;
+		put (record, LOG_ARG_FLOAT, &data, sizeof (data));
+	}
+
+	static void encodeArg (logRecord_t& record, const char* value) {
+		uint8_t size = 0;
+		while (value && size < DEBUG_LOG_MAX_STRING && value[size]) {
+			size++;
+		}
+		if (reserve (record, 2 + size)) {
+			record.data[record.length++] = LOG_ARG_STRING;
+			record.data[record.length++] = size;
+			memcpy (record.data + record.length, value, size);
+			record.length += size;
+		}
+	}
+
+	static void encodeArg (logRecord_t& record, const void* value) {
+		encodeArg (record, (uintptr_t)value);
+	}
+};
+
+extern DebugLog debugLog;
+
+/**
+  * @brief Never called. Lets compiler check arguments against format string, which is not stored
+  */
+static inline void debugLogFormatCheck (const char* format, ...) __attribute__ ((format (printf, 1, 2)));
+static inline void debugLogFormatCheck (const char*, ...) {}
+
+#define DEBUG_LOG_RECORD(level,text,...) do { \
+	if (0) debugLogFormatCheck (text, ##__VA_ARGS__); \
+	debugLog.write (level, std::integral_constant<uint32_t, DebugLog::hash (text)>::value, __LINE__, ##__VA_ARGS__); \
+} while (0)
+
+#endif
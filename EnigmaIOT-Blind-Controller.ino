@@ -13,6 +13,7 @@
 #include <EnigmaIOTjsonController.h>
 #include <FailSafe.h>
 #include "BlindController.h"
+#include "DebugLog.h"
 
 #include <EnigmaIOTNode.h>
 #include <espnow_hal.h>
@@ -57,10 +58,47 @@ EnigmaIOTjsonController* controller;
 const auto fullTravelTime = 30000;
 #define RESET_PIN 13
 
+#if BLIND_CHANNELS > 1
+// Wiring of every blind: up relay, down relay, up button, down button. Adjust to your board
+const int blindPins[BLIND_MAX_CHANNELS][4] = {
+	{ 14, 12, 5, 4 },
+	{ 27, 26, 25, 33 },
+	{ 16, 17, NO_BUTTON, NO_BUTTON },
+	{ 18, 19, NO_BUTTON, NO_BUTTON },
+	{ 21, 22, NO_BUTTON, NO_BUTTON },
+	{ 23, 32, NO_BUTTON, NO_BUTTON },
+	{ NO_PIN, NO_PIN, NO_BUTTON, NO_BUTTON },
+	{ NO_PIN, NO_PIN, NO_BUTTON, NO_BUTTON }
+};
+
+/**
+  * @brief Builds hardware description of every blind. Only first blind has a default wiring in controller,
+  * so pins of the rest have to be given to `setup`. Travel time and settings shared by all blinds, taken from
+  * first element, are only used until a configuration is stored
+  */
+void blindHardware (blindControlerHw_t (&hw)[BLIND_CHANNELS]) {
+	memset (hw, 0, sizeof (hw));
+	for (int channel = 0; channel < BLIND_CHANNELS; channel++) {
+		hw[channel].upRelayPin = blindPins[channel][0];
+		hw[channel].downRelayPin = blindPins[channel][1];
+		hw[channel].upButton = blindPins[channel][2];
+		hw[channel].downButton = blindPins[channel][3];
+		hw[channel].fullTravellingTime = fullTravelTime;
+	}
+	hw[0].ON_STATE = HIGH;
+	hw[0].telemetryEncoding = TELEMETRY_MSGPACK;
+	hw[0].curveProfile = CURVE_AWNING;
+	hw[0].reportStep = 20;
+	hw[0].reportMinInterval = 2000;
+	hw[0].reportMaxInterval = 600000;
+}
+#endif // BLIND_CHANNELS > 1
+
 const time_t BOOT_FLAG_TIMEOUT = 10000; // Time in ms to reset flag
 const int MAX_CONSECUTIVE_BOOT = 3; // Number of rapid boot cycles before enabling fail safe mode
 const int LED = LED_BUILTIN; // Number of rapid boot cycles before enabling fail safe mode
 const int FAILSAFE_RTC_ADDRESS = 0; // If you use RTC memory adjust offset to not overwrite other data
+static_assert (FAILSAFE_RTC_ADDRESS + 16 <= POSITION_RTC_LOWEST_ADDRESS, "FailSafe RTC data overlaps blind position"); // FailSafe uses less than 16 blocks
 
 void connectEventHandler () {
     controller->connectInform ();
@@ -111,15 +149,13 @@ void setup () {
 	EnigmaIOTNode.onConnected (connectEventHandler);
 	EnigmaIOTNode.onDisconnected (disconnectEventHandler);
 	EnigmaIOTNode.onDataRx (processRxData);
-	EnigmaIOTNode.enableClockSync (false);
+	EnigmaIOTNode.enableClockSync (false); // Controller enables it if clockSync is configured or schedule has entries
 	EnigmaIOTNode.onWiFiManagerStarted (wifiManagerStarted);
 	EnigmaIOTNode.onWiFiManagerExit (wifiManagerExit);
 	EnigmaIOTNode.enableBroadcast ();
 
 	if (!controller->loadConfig ()) {
-		DEBUG_WARN ("Error reading config file");
-		if (SPIFFS.format ())
-			DEBUG_WARN ("SPIFFS Formatted");
+		DEBUG_WARN ("Error reading config file. Using defaults");
 	}
 
 	EnigmaIOTNode.begin (&Espnow_hal, NULL, NULL, true, false);
@@ -139,7 +175,13 @@ void setup () {
 	}
 
 	controller->sendDataCallback (sendUplinkData);
+#if BLIND_CHANNELS > 1
+	static blindControlerHw_t hw[BLIND_CHANNELS];
+	blindHardware (hw);
+	controller->setup (&EnigmaIOTNode, hw);
+#else
 	controller->setup (&EnigmaIOTNode);
+#endif
 
 	DEBUG_DBG ("END setup");
 }
@@ -153,4 +195,11 @@ void loop () {
 
     controller->loop ();
 	EnigmaIOTNode.handle ();
+
+#if DEBUG_BINARY_LOG
+	debugLog.drain (Serial); // Sends stored debug records that fit on serial buffer
+#endif
+
+	// Let system and radio tasks run until controller has something to do
+	delay (((CONTROLLER_CLASS_NAME*)controller)->idleTime ());
 }
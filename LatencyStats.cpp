@@ -0,0 +1,40 @@
+//
+//
+//
+
+#include "LatencyStats.h"
+
+void LatencyHistogram::add (uint32_t startCycles) {
+	uint32_t us = (ESP.getCycleCount () - startCycles) / ESP.getCpuFreqMHz ();
+	uint32_t range = us >> 4;
+	uint8_t bucket = 0;
+
+	while (range && bucket < LATENCY_BUCKETS - 1) {
+		range >>= 3;
+		bucket++;
+	}
+	count[bucket]++;
+	if (us > max) {
+		max = us;
+	}
+}
+
+void HeapStats::sample () {
+	uint32_t freeHeap = ESP.getFreeHeap ();
+	uint32_t block = maxFreeBlock ();
+
+	if (freeHeap < minFree) {
+		minFree = freeHeap;
+	}
+	if (block < minBlock) {
+		minBlock = block;
+	}
+}
+
+uint32_t HeapStats::maxFreeBlock () {
+#ifdef ESP32
+	return ESP.getMaxAllocHeap ();
+#else
+	return ESP.getMaxFreeBlockSize ();
+#endif
+}
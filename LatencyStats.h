@@ -0,0 +1,68 @@
+// LatencyStats.h
+
+#ifndef _LATENCYSTATS_h
+#define _LATENCYSTATS_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+
+constexpr auto LATENCY_BUCKETS = 6; ///< @brief Bucket `n` holds durations below `16 * 8^n` us. Last one holds longer ones
+
+/**
+  * @brief Duration histogram with logarithmic buckets
+  *
+  * Time is taken from CPU cycle counter, which is cheap enough to be read on every loop. Durations must be
+  * shorter than cycle counter period, about 53 s at 80 MHz.
+  */
+class LatencyHistogram {
+public:
+	/**
+	  * @brief Gets a timestamp to be passed later to `add`
+	  */
+	static uint32_t start () {
+		return ESP.getCycleCount ();
+	}
+
+	/**
+	  * @brief Adds time elapsed since `startCycles`
+	  * @param startCycles Value returned by `start`
+	  */
+	void add (uint32_t startCycles);
+
+	void clear () {
+		memset (count, 0, sizeof (count));
+		max = 0;
+	}
+
+	uint32_t count[LATENCY_BUCKETS] = {}; ///< @brief Number of durations on every bucket
+	uint32_t max = 0; ///< @brief Longest duration in us
+};
+
+/**
+  * @brief Lowest free heap and lowest largest free block seen since last `clear`
+  */
+class HeapStats {
+public:
+	/**
+	  * @brief Reads current heap state and updates minimums
+	  */
+	void sample ();
+
+	void clear () {
+		minFree = UINT32_MAX;
+		minBlock = UINT32_MAX;
+	}
+
+	/**
+	  * @brief Gets size of largest block that may be allocated
+	  */
+	static uint32_t maxFreeBlock ();
+
+	uint32_t minFree = UINT32_MAX;
+	uint32_t minBlock = UINT32_MAX;
+};
+
+#endif
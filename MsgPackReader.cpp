@@ -0,0 +1,287 @@
+//
+//
+//
+
+#include "MsgPackReader.h"
+
+constexpr auto MAX_NESTING_LEVEL = 8;
+
+bool MsgPackReader::readBigEndian (uint8_t bytes, uint64_t& value) {
+	if (end - data < bytes) {
+		return false;
+	}
+	value = 0;
+	for (uint8_t i = 0; i < bytes; i++) {
+		value = (value << 8) | *data++;
+	}
+	return true;
+}
+
+bool MsgPackReader::skipBytes (size_t length) {
+	if ((size_t)(end - data) < length) {
+		return false;
+	}
+	data += length;
+	return true;
+}
+
+bool MsgPackReader::readMapSize (size_t& size) {
+	uint64_t value;
+
+	if (atEnd ()) {
+		return false;
+	}
+	uint8_t type = *data;
+	if ((type & 0xF0) == 0x80) { // fixmap
+		data++;
+		size = type & 0x0F;
+		return true;
+	}
+	if (type == 0xDE || type == 0xDF) { // map 16, map 32
+		data++;
+		if (!readBigEndian (type == 0xDE ? 2 : 4, value)) {
+			return false;
+		}
+		size = value;
+		return true;
+	}
+	return false;
+}
+
+bool MsgPackReader::readArraySize (size_t& size) {
+	uint64_t value;
+
+	if (atEnd ()) {
+		return false;
+	}
+	uint8_t type = *data;
+	if ((type & 0xF0) == 0x90) { // fixarray
+		data++;
+		size = type & 0x0F;
+		return true;
+	}
+	if (type == 0xDC || type == 0xDD) { // array 16, array 32
+		data++;
+		if (!readBigEndian (type == 0xDC ? 2 : 4, value)) {
+			return false;
+		}
+		size = value;
+		return true;
+	}
+	return false;
+}
+
+bool MsgPackReader::readString (const char*& str, size_t& len) {
+	uint64_t value;
+	const uint8_t* start = data;
+
+	if (atEnd ()) {
+		return false;
+	}
+	uint8_t type = *data;
+	if ((type & 0xE0) == 0xA0) { // fixstr
+		data++;
+		len = type & 0x1F;
+	} else if (type >= 0xD9 && type <= 0xDB) { // str 8, str 16, str 32
+		data++;
+		if (!readBigEndian (1 << (type - 0xD9), value)) {
+			data = start;
+			return false;
+		}
+		len = value;
+	} else {
+		return false;
+	}
+	str = (const char*)data;
+	if (!skipBytes (len)) {
+		data = start;
+		return false;
+	}
+	return true;
+}
+
+/**
+  * @brief Converts a received float to integer. Out of range values saturate, as unsigned integers do
+  * @return Returns `false` if number is NaN
+  */
+static bool floatToInt64 (double number, int64_t& value) {
+	if (number != number) {
+		return false;
+	}
+	if (number >= 9223372036854775808.0) { // 2^63
+		value = INT64_MAX;
+	} else if (number < -9223372036854775808.0) {
+		value = INT64_MIN;
+	} else {
+		value = (int64_t)number;
+	}
+	return true;
+}
+
+bool MsgPackReader::readInt64 (int64_t& value) {
+	uint64_t raw;
+	const uint8_t* start = data;
+
+	if (atEnd ()) {
+		return false;
+	}
+	uint8_t type = *data++;
+	if (type <= 0x7F) { // positive fixint
+		value = type;
+		return true;
+	}
+	if (type >= 0xE0) { // negative fixint
+		value = (int8_t)type;
+		return true;
+	}
+	switch (type) {
+	case 0xCC: // uint 8 .. uint 64
+	case 0xCD:
+	case 0xCE:
+	case 0xCF:
+		if (!readBigEndian (1 << (type - 0xCC), raw)) {
+			break;
+		}
+		value = raw > INT64_MAX ? INT64_MAX : (int64_t)raw;
+		return true;
+	case 0xD0: // int 8 .. int 64
+	case 0xD1:
+	case 0xD2:
+	case 0xD3: {
+		uint8_t bytes = 1 << (type - 0xD0);
+		if (!readBigEndian (bytes, raw)) {
+			break;
+		}
+		uint8_t shift = 64 - 8 * bytes;
+		value = (int64_t)(raw << shift) >> shift;
+		return true;
+	}
+	case 0xCA: { // float 32
+		if (!readBigEndian (4, raw)) {
+			break;
+		}
+		uint32_t bits = raw;
+		float number;
+		memcpy (&number, &bits, sizeof (number));
+		if (!floatToInt64 (number, value)) {
+			break;
+		}
+		return true;
+	}
+	case 0xCB: { // float 64
+		if (!readBigEndian (8, raw)) {
+			break;
+		}
+		double number;
+		memcpy (&number, &raw, sizeof (number));
+		if (!floatToInt64 (number, value)) {
+			break;
+		}
+		return true;
+	}
+	}
+	data = start;
+	return false;
+}
+
+bool MsgPackReader::readInt (int32_t& value) {
+	int64_t number;
+
+	if (!readInt64 (number)) {
+		return false;
+	}
+	value = number > INT32_MAX ? INT32_MAX : (number < INT32_MIN ? INT32_MIN : (int32_t)number);
+	return true;
+}
+
+bool MsgPackReader::readBool (bool& value) {
+	int32_t number;
+
+	if (atEnd ()) {
+		return false;
+	}
+	if (*data == 0xC2 || *data == 0xC3) {
+		value = *data++ == 0xC3;
+		return true;
+	}
+	if (readInt (number)) {
+		value = number != 0;
+		return true;
+	}
+	return false;
+}
+
+bool MsgPackReader::skip () {
+	return skip (0);
+}
+
+bool MsgPackReader::skip (uint8_t depth) {
+	uint64_t value;
+	size_t size;
+	const char* str;
+
+	if (atEnd () || depth > MAX_NESTING_LEVEL) {
+		return false;
+	}
+	uint8_t type = *data;
+	if (readMapSize (size)) {
+		for (size_t i = 0; i < 2 * size; i++) {
+			if (!skip (depth + 1)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	if (readArraySize (size)) {
+		for (size_t i = 0; i < size; i++) {
+			if (!skip (depth + 1)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	if (readString (str, size)) {
+		return true;
+	}
+	if (type <= 0x7F || type >= 0xE0) { // fixint
+		data++;
+		return true;
+	}
+	data++;
+	switch (type) {
+	case 0xC0: // nil, false, true
+	case 0xC2:
+	case 0xC3:
+		return true;
+	case 0xCC: // uint 8 .. uint 64
+	case 0xCD:
+	case 0xCE:
+	case 0xCF:
+		return skipBytes (1 << (type - 0xCC));
+	case 0xD0: // int 8 .. int 64
+	case 0xD1:
+	case 0xD2:
+	case 0xD3:
+		return skipBytes (1 << (type - 0xD0));
+	case 0xCA: // float 32
+		return skipBytes (4);
+	case 0xCB: // float 64
+		return skipBytes (8);
+	case 0xC4: // bin 8, bin 16, bin 32
+	case 0xC5:
+	case 0xC6:
+		return readBigEndian (1 << (type - 0xC4), value) && skipBytes (value);
+	case 0xD4: // fixext 1 .. fixext 16
+	case 0xD5:
+	case 0xD6:
+	case 0xD7:
+	case 0xD8:
+		return skipBytes (1 + (1 << (type - 0xD4)));
+	case 0xC7: // ext 8, ext 16, ext 32
+	case 0xC8:
+	case 0xC9:
+		return readBigEndian (1 << (type - 0xC7), value) && skipBytes (1 + value);
+	default:
+		return false;
+	}
+}
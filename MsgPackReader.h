@@ -0,0 +1,87 @@
+// MsgPackReader.h
+
+#ifndef _MSGPACKREADER_h
+#define _MSGPACKREADER_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/**
+  * @brief Forward only MsgPack decoder that reads directly from a received buffer
+  *
+  * It does not copy data or use heap. Strings are returned as pointer and length into the original buffer,
+  * so they are not null terminated.
+  */
+class MsgPackReader {
+public:
+	MsgPackReader (const uint8_t* data, size_t length) : data (data), end (data + length) {}
+
+	/**
+	  * @brief Reads a map header
+	  * @param size Number of key/value pairs that follow
+	  * @return Returns `false` if next element is not a map
+	  */
+	bool readMapSize (size_t& size);
+
+	/**
+	  * @brief Reads an array header
+	  * @param size Number of elements that follow
+	  * @return Returns `false` if next element is not an array
+	  */
+	bool readArraySize (size_t& size);
+
+	/**
+	  * @brief Reads a string without copying it
+	  * @param str Pointer to first string character inside input buffer
+	  * @param len String length
+	  * @return Returns `false` if next element is not a string
+	  */
+	bool readString (const char*& str, size_t& len);
+
+	/**
+	  * @brief Reads any number. Floats are truncated and values out of range are saturated
+	  * @return Returns `false` if next element is not a number
+	  */
+	bool readInt (int32_t& value);
+
+	/**
+	  * @brief Reads any number as a 64 bit integer. Used for timestamps
+	  * @return Returns `false` if next element is not a number
+	  */
+	bool readInt64 (int64_t& value);
+
+	/**
+	  * @brief Reads a boolean. Numbers are accepted as `value != 0`
+	  * @return Returns `false` if next element is not a boolean or number
+	  */
+	bool readBool (bool& value);
+
+	/**
+	  * @brief Skips next element, including nested maps and arrays
+	  * @return Returns `false` if data is malformed
+	  */
+	bool skip ();
+
+	bool atEnd () const {
+		return data >= end;
+	}
+
+	/**
+	  * @brief Compares a string read with `readString` with a null terminated one. Received string may hold null
+	  * characters, so it is not used to find where `value` ends
+	  */
+	static bool equals (const char* str, size_t len, const char* value) {
+		return strlen (value) == len && !memcmp (str, value, len);
+	}
+
+protected:
+	const uint8_t* data;
+	const uint8_t* end;
+
+	bool readBigEndian (uint8_t bytes, uint64_t& value);
+	bool skipBytes (size_t length);
+	bool skip (uint8_t depth);
+};
+
+#endif
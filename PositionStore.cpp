@@ -0,0 +1,162 @@
+//
+//
+//
+
+#include "PositionStore.h"
+#include "RecordFile.h"
+#include "debug.h"
+#include <FS.h>
+#ifdef ESP32
+#include <SPIFFS.h>
+
+RTC_NOINIT_ATTR static positionRecord_t rtcMemoryRecord[POSITION_MAX_CHANNELS];
+#endif
+
+static uint16_t recordCrc (const positionRecord_t& record) {
+	return crc16 ((const uint8_t*)&record, offsetof (positionRecord_t, crc));
+}
+
+bool PositionStore::valid (const positionRecord_t& record) {
+	return record.crc == recordCrc (record) && record.position >= 0 && record.position <= 100;
+}
+
+void PositionStore::fill (positionRecord_t& record, int8_t position, uint8_t state) {
+	record.sequence = sequence;
+	record.position = position;
+	record.state = state;
+	record.crc = recordCrc (record);
+}
+
+bool PositionStore::readRtc (positionRecord_t& record) {
+#ifdef ESP8266
+	if (!ESP.rtcUserMemoryRead (POSITION_RTC_ADDRESS - channel * POSITION_RTC_BLOCKS, (uint32_t*)&record, sizeof (record))) {
+		return false;
+	}
+#elif defined ESP32
+	record = rtcMemoryRecord[channel];
+#endif
+	return valid (record);
+}
+
+void PositionStore::writeRtc (positionRecord_t& record) {
+#ifdef ESP8266
+	ESP.rtcUserMemoryWrite (POSITION_RTC_ADDRESS - channel * POSITION_RTC_BLOCKS, (uint32_t*)&record, sizeof (record));
+#elif defined ESP32
+	rtcMemoryRecord[channel] = record;
+#endif
+	rtcRecord = record;
+}
+
+void PositionStore::begin (uint8_t channel) {
+	positionRecord_t record;
+
+	this->channel = channel < POSITION_MAX_CHANNELS ? channel : POSITION_MAX_CHANNELS - 1;
+	if (this->channel) {
+		snprintf (journalFile, sizeof (journalFile), "/blindpos%u.bin", this->channel);
+	} else {
+		strncpy (journalFile, POSITION_JOURNAL_FILE, sizeof (journalFile));
+	}
+
+	memset (&journalRecord, 0, sizeof (journalRecord));
+	memset (&rtcRecord, 0, sizeof (rtcRecord));
+	rtcRecord.position = -1;
+	sequence = 0;
+	nextSlot = 0;
+
+	File journal = SPIFFS.open (journalFile, "r");
+	if (!journal) {
+		DEBUG_INFO ("No position journal");
+		return;
+	}
+	for (uint8_t slot = 0; slot < POSITION_JOURNAL_SLOTS; slot++) {
+		if (journal.read ((uint8_t*)&record, sizeof (record)) != sizeof (record)) {
+			break;
+		}
+		if (valid (record) && record.sequence >= journalRecord.sequence) {
+			journalRecord = record;
+			sequence = record.sequence;
+			nextSlot = (slot + 1) % POSITION_JOURNAL_SLOTS;
+		}
+	}
+	journal.close ();
+	if (readRtc (record) && record.sequence > sequence) {
+		sequence = record.sequence;
+	}
+	DEBUG_DBG ("Position journal sequence %u. Next slot %d", sequence, nextSlot);
+}
+
+bool PositionStore::restore (int8_t& position, uint8_t& state) {
+	positionRecord_t record;
+
+	if (readRtc (record)) {
+		DEBUG_INFO ("Position %d restored from RTC memory", record.position);
+	} else if (valid (journalRecord)) {
+		record = journalRecord;
+		DEBUG_INFO ("Position %d restored from journal", record.position);
+	} else {
+		return false;
+	}
+	position = record.position;
+	state = record.state;
+	rtcRecord = record;
+	return true;
+}
+
+void PositionStore::update (int8_t position, uint8_t state) {
+	if (position < 0 || (rtcRecord.position == position && rtcRecord.state == state)) { // Unknown or not changed
+		return;
+	}
+	sequence++;
+	positionRecord_t record;
+	fill (record, position, state);
+	writeRtc (record);
+}
+
+bool PositionStore::start (int8_t position, uint8_t state) {
+	update (position, state);
+	if (position < 0 || (journalRecord.state == state && valid (journalRecord))) { // Already marked for this movement
+		return true;
+	}
+	return writeJournal (position, state);
+}
+
+bool PositionStore::commit (int8_t position, uint8_t state) {
+	update (position, state);
+	if (position < 0 || (journalRecord.position == position && journalRecord.state == state && valid (journalRecord))) {
+		return true;
+	}
+	return writeJournal (position, state);
+}
+
+bool PositionStore::writeJournal (int8_t position, uint8_t state) {
+	if (!SPIFFS.exists (journalFile)) {
+		File journal = SPIFFS.open (journalFile, "w");
+		if (!journal) {
+			DEBUG_WARN ("Error creating position journal");
+			return false;
+		}
+		positionRecord_t empty;
+		memset (&empty, 0, sizeof (empty));
+		for (uint8_t slot = 0; slot < POSITION_JOURNAL_SLOTS; slot++) {
+			journal.write ((uint8_t*)&empty, sizeof (empty));
+		}
+		journal.close ();
+		nextSlot = 0;
+	}
+
+	File journal = SPIFFS.open (journalFile, "r+");
+	if (!journal || !journal.seek (nextSlot * sizeof (positionRecord_t))) {
+		DEBUG_WARN ("Error opening position journal");
+		return false;
+	}
+	positionRecord_t record;
+	fill (record, position, state);
+	bool result = journal.write ((uint8_t*)&record, sizeof (record)) == sizeof (record);
+	journal.close ();
+	if (result) {
+		DEBUG_DBG ("Position %d saved on journal slot %d", position, nextSlot);
+		journalRecord = record;
+		nextSlot = (nextSlot + 1) % POSITION_JOURNAL_SLOTS;
+	}
+	return result;
+}
@@ -0,0 +1,85 @@
+// PositionStore.h
+
+#ifndef _POSITIONSTORE_h
+#define _POSITIONSTORE_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+
+constexpr auto POSITION_RTC_ADDRESS = 126; ///< @brief RTC user memory block (4 bytes each) for last position. Last 8 bytes of user memory, away from FailSafe data at start
+constexpr auto POSITION_RTC_BLOCKS = 2; ///< @brief RTC user memory blocks used by every channel. Next channels go below previous ones
+constexpr auto POSITION_MAX_CHANNELS = 8; ///< @brief Number of blinds whose position may be stored
+constexpr auto POSITION_RTC_LOWEST_ADDRESS = POSITION_RTC_ADDRESS - (POSITION_MAX_CHANNELS - 1) * POSITION_RTC_BLOCKS; ///< @brief First RTC block used by last channel
+constexpr auto POSITION_JOURNAL_FILE = "/blindpos.bin"; ///< @brief Flash journal file name. Other channels add channel number before extension
+constexpr auto POSITION_JOURNAL_SLOTS = 32; ///< @brief Number of records in journal. Every save goes to next slot
+
+/**
+  * @brief Saved position record. Same layout is used in RTC memory and flash journal
+  */
+struct positionRecord_t {
+	uint32_t sequence; ///< @brief Save counter. Newest journal record has the highest value
+	int8_t position; ///< @brief Linear position 0-100
+	uint8_t state; ///< @brief Blind state when position was saved
+	uint16_t crc; ///< @brief CRC of previous fields
+};
+
+/**
+  * @brief Keeps last known blind position across reboots
+  *
+  * Position is updated in RTC memory while blind moves, which survives resets but not power loss, and is
+  * written to a flash journal when blind starts moving and when it stops. Journal records are written round
+  * robin on a fixed set of slots to spread flash wear.
+  */
+class PositionStore {
+public:
+	/**
+	  * @brief Finds newest journal record. Filesystem has to be mounted
+	  * @param channel Blind number. Every channel uses its own RTC memory blocks and journal file
+	  */
+	void begin (uint8_t channel = 0);
+
+	/**
+	  * @brief Gets last saved position. RTC memory is preferred over journal as it is more recent
+	  * @param position Restored linear position
+	  * @param state Blind state when position was saved
+	  * @return Returns `false` if there is no valid saved position
+	  */
+	bool restore (int8_t& position, uint8_t& state);
+
+	/**
+	  * @brief Saves position in RTC memory only. Used while blind is moving
+	  */
+	void update (int8_t position, uint8_t state);
+
+	/**
+	  * @brief Saves position in RTC memory and, once per movement, in next journal slot. Used while blind is moving,
+	  * so that after a power cut journal does not hold an old position as a stopped one
+	  * @return Returns `false` if journal could not be written
+	  */
+	bool start (int8_t position, uint8_t state);
+
+	/**
+	  * @brief Saves position in RTC memory and, if it or state have changed, in next journal slot. Used when blind stops
+	  * @return Returns `false` if journal could not be written
+	  */
+	bool commit (int8_t position, uint8_t state);
+
+protected:
+	uint8_t channel = 0;
+	char journalFile[16]; ///< @brief Journal file name for this channel
+	uint32_t sequence = 0; ///< @brief Sequence number of last written record
+	uint8_t nextSlot = 0; ///< @brief Journal slot for next write
+	positionRecord_t rtcRecord; ///< @brief Copy of last record written to RTC memory
+	positionRecord_t journalRecord; ///< @brief Copy of last record written to journal
+
+	static bool valid (const positionRecord_t& record);
+	void fill (positionRecord_t& record, int8_t position, uint8_t state);
+	bool readRtc (positionRecord_t& record);
+	void writeRtc (positionRecord_t& record);
+	bool writeJournal (int8_t position, uint8_t state);
+};
+
+#endif
@@ -0,0 +1,120 @@
+//
+//
+//
+
+#include "RecordFile.h"
+#include "debug.h"
+#include <FS.h>
+#ifdef ESP32
+#include <SPIFFS.h>
+#endif
+
+constexpr auto MAX_PATH_LENGTH = 32; ///< @brief SPIFFS file name limit including terminator
+constexpr auto TEMP_SUFFIX = ".tmp";
+
+uint16_t crc16 (const uint8_t* data, size_t length, uint16_t crc) {
+	for (size_t i = 0; i < length; i++) {
+		crc ^= (uint16_t)data[i] << 8;
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+}
+
+void RecordFile::tempPath (const char* path, char* temp, size_t size) {
+	snprintf (temp, size, "%s%s", path, TEMP_SUFFIX);
+}
+
+bool RecordFile::readFile (const char* path, uint32_t magic, void* payload, size_t size, uint16_t& version, const uint16_t* lengths, uint16_t versions) {
+	recordHeader_t header;
+
+	File file = SPIFFS.open (path, "r");
+	if (!file) {
+		return false;
+	}
+	if (file.read ((uint8_t*)&header, sizeof (header)) != sizeof (header)
+		|| header.headerCrc != crc16 ((uint8_t*)&header, offsetof (recordHeader_t, headerCrc))
+		|| header.magic != magic || file.size () != sizeof (header) + header.length) {
+		DEBUG_WARN ("Wrong header on %s", path);
+		file.close ();
+		return false;
+	}
+
+	// Payload is checked before it is copied so that a corrupt record does not change anything
+	uint16_t crc = CRC16_SEED;
+	uint8_t buffer[16];
+	size_t remaining = header.length;
+	while (remaining) {
+		size_t chunk = file.read (buffer, remaining < sizeof (buffer) ? remaining : sizeof (buffer));
+		if (!chunk) {
+			break;
+		}
+		crc = crc16 (buffer, chunk, crc);
+		remaining -= chunk;
+	}
+	if (remaining || crc != header.crc) {
+		DEBUG_WARN ("Wrong CRC on %s", path);
+		file.close ();
+		return false;
+	}
+
+	file.seek (sizeof (header));
+	size_t length = header.length < size ? header.length : size;
+	if (lengths && header.version >= 1 && header.version <= versions && lengths[header.version - 1] < length) {
+		length = lengths[header.version - 1]; // Leaves out padding stored after last field
+	}
+	file.read ((uint8_t*)payload, length);
+	file.close ();
+	version = header.version;
+	return true;
+}
+
+bool RecordFile::read (const char* path, uint32_t magic, void* payload, size_t size, uint16_t& version, const uint16_t* lengths, uint16_t versions) {
+	char temp[MAX_PATH_LENGTH];
+
+	if (readFile (path, magic, payload, size, version, lengths, versions)) {
+		return true;
+	}
+	// Power may have been lost after old file was removed and before new one was renamed
+	tempPath (path, temp, sizeof (temp));
+	if (!SPIFFS.exists (path) && readFile (temp, magic, payload, size, version, lengths, versions)) {
+		DEBUG_WARN ("Recovered %s from temporary file", path);
+		SPIFFS.rename (temp, path);
+		return true;
+	}
+	return false;
+}
+
+bool RecordFile::write (const char* path, uint32_t magic, uint16_t version, const void* payload, size_t size) {
+	char temp[MAX_PATH_LENGTH];
+	recordHeader_t header;
+
+	header.magic = magic;
+	header.version = version;
+	header.length = size;
+	header.crc = crc16 ((const uint8_t*)payload, size);
+	header.headerCrc = crc16 ((uint8_t*)&header, offsetof (recordHeader_t, headerCrc));
+
+	tempPath (path, temp, sizeof (temp));
+	File file = SPIFFS.open (temp, "w");
+	if (!file) {
+		DEBUG_WARN ("Failed to open %s for writing", temp);
+		return false;
+	}
+	bool result = file.write ((uint8_t*)&header, sizeof (header)) == sizeof (header)
+		&& file.write ((const uint8_t*)payload, size) == size;
+	file.close ();
+	if (!result) {
+		DEBUG_ERROR ("Failed to write %s", temp);
+		SPIFFS.remove (temp);
+		return false;
+	}
+
+	SPIFFS.remove (path);
+	if (!SPIFFS.rename (temp, path)) {
+		DEBUG_ERROR ("Failed to rename %s", temp);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,76 @@
+// RecordFile.h
+
+#ifndef _RECORDFILE_h
+#define _RECORDFILE_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+
+constexpr auto CRC16_SEED = 0xB11D; ///< @brief Not zero, so that cleared memory is not a valid record
+
+/**
+  * @brief CRC-16/CCITT polynomial with a custom seed
+  * @param data Data to check
+  * @param length Data length
+  * @param crc Initial value. Used to continue a previous calculation
+  */
+uint16_t crc16 (const uint8_t* data, size_t length, uint16_t crc = CRC16_SEED);
+
+/**
+  * @brief File header for binary records
+  */
+struct recordHeader_t {
+	uint32_t magic; ///< @brief Identifies record type
+	uint16_t version; ///< @brief Record layout version
+	uint16_t length; ///< @brief Payload length
+	uint16_t crc; ///< @brief CRC of payload
+	uint16_t headerCrc; ///< @brief CRC of previous header fields
+};
+
+/**
+  * @brief Reads and writes a binary record on a file with a versioned header and a CRC
+  *
+  * Records are written to a temporary file that replaces the original one when it is complete, so a
+  * power cut while saving leaves either the old or the new record. New record versions may only append
+  * fields. Readers load the fields they know, and fields missing in older records keep the value the
+  * payload had before reading.
+  *
+  * Structure size includes padding after last field, which a later version may use for a new field. Writers
+  * pass the length up to last field, and readers pass that length for every version, so that padding stored
+  * by older writers is not copied over new fields.
+  */
+class RecordFile {
+public:
+	/**
+	  * @brief Reads a record
+	  * @param path File name
+	  * @param magic Expected record type
+	  * @param payload Buffer for record
+	  * @param size Payload buffer size
+	  * @param version Version of stored record
+	  * @param lengths Length of every record version, starting at version 1, up to its last field. `NULL` to copy whole stored payload
+	  * @param versions Number of elements in `lengths`
+	  * @return Returns `false` if file does not exist, is corrupt or holds another record type
+	  */
+	static bool read (const char* path, uint32_t magic, void* payload, size_t size, uint16_t& version, const uint16_t* lengths = NULL, uint16_t versions = 0);
+
+	/**
+	  * @brief Writes a record atomically
+	  * @param path File name
+	  * @param magic Record type
+	  * @param version Record layout version
+	  * @param payload Record
+	  * @param size Record length up to its last field
+	  * @return Returns `true` if record was written
+	  */
+	static bool write (const char* path, uint32_t magic, uint16_t version, const void* payload, size_t size);
+
+protected:
+	static bool readFile (const char* path, uint32_t magic, void* payload, size_t size, uint16_t& version, const uint16_t* lengths, uint16_t versions);
+	static void tempPath (const char* path, char* temp, size_t size);
+};
+
+#endif
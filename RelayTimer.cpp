@@ -0,0 +1,23 @@
+//
+//
+//
+
+#include "RelayTimer.h"
+
+void RelayTimer::arm (uint32_t delay, int pin, int offLevel) {
+	ticker.detach ();
+	this->pin = pin;
+	this->offLevel = offLevel;
+	pending = true;
+	ticker.once_ms (delay, onTimer, this);
+}
+
+void RelayTimer::disarm () {
+	ticker.detach ();
+	pending = false;
+}
+
+void RelayTimer::onTimer (RelayTimer* timer) {
+	digitalWrite (timer->pin, timer->offLevel);
+	timer->pending = false;
+}
@@ -0,0 +1,51 @@
+// RelayTimer.h
+
+#ifndef _RELAYTIMER_h
+#define _RELAYTIMER_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+
+#include <Ticker.h>
+
+/**
+  * @brief Switches a relay off on a deadline from a timer callback
+  *
+  * Main loop may be delayed by radio or serial work, so a movement that ends when `loop` notices it runs
+  * longer than planned. This switches the relay off on time and leaves state bookkeeping to `loop`.
+  */
+class RelayTimer {
+public:
+	/**
+	  * @brief Schedules relay switch off. A previous schedule is replaced
+	  * @param delay Time until relay has to be switched off, in ms
+	  * @param pin Relay pin
+	  * @param offLevel Pin level that switches relay off
+	  */
+	void arm (uint32_t delay, int pin, int offLevel);
+
+	/**
+	  * @brief Cancels scheduled switch off
+	  */
+	void disarm ();
+
+	/**
+	  * @brief Checks if relay is still waiting to be switched off. `false` once timer has fired
+	  */
+	bool armed () {
+		return pending;
+	}
+
+protected:
+	Ticker ticker;
+	int pin;
+	int offLevel;
+	volatile bool pending = false; ///< @brief Cleared by timer callback. Does not depend on how `Ticker` reports a finished one shot timer
+
+	static void onTimer (RelayTimer* timer);
+};
+
+#endif
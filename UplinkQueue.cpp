@@ -0,0 +1,122 @@
+//
+//
+//
+
+#include "UplinkQueue.h"
+#include "debug.h"
+
+bool UplinkQueue::send (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, uplinkPriority_t priority, sendData_cb& sender, uint8_t slot) {
+	if (!sender || length > frameSize (priority) || (priority == UPLINK_LOW && slot >= lowSlots)) {
+		DEBUG_WARN ("Cannot send %u bytes frame", (unsigned)length);
+		return false;
+	}
+
+	bool attempted = false;
+	if (!highCount) { // Nothing with higher or same priority is waiting
+		if (transmit (data, length, encoding, sender)) {
+			if (priority == UPLINK_LOW) {
+				lowUsed &= ~(1 << slot); // Waiting position is outdated
+			}
+			return true;
+		}
+		attempted = true;
+	}
+
+	if (priority == UPLINK_HIGH) {
+		if (length > UPLINK_FRAME_SIZE && longUsed) {
+			DEBUG_WARN ("Another long frame is waiting. Dropping frame");
+			droppedFrames++;
+			return false;
+		}
+		if (highCount == UPLINK_HIGH_LANE_SIZE) {
+			DEBUG_WARN ("Uplink queue full. Dropping oldest frame");
+			popHigh ();
+			droppedFrames++;
+		}
+		store (high[(highHead + highCount) % UPLINK_HIGH_LANE_SIZE], data, length, encoding, attempted);
+		highCount++;
+	} else {
+		store (low[slot], data, length, encoding, attempted);
+		lowUsed |= 1 << slot;
+	}
+	DEBUG_DBG ("Frame queued. Priority %d", priority);
+	return true;
+}
+
+void UplinkQueue::store (uplinkFrame_t& frame, const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, bool attempted) {
+	if (length > UPLINK_FRAME_SIZE) { // Only high priority frames may be this long
+		memmove (longFrame, data, length);
+		longUsed = true;
+	} else {
+		memmove (frame.data, data, length);
+	}
+	frame.length = length;
+	frame.encoding = encoding;
+	frame.retries = 0;
+	frame.nextAttempt = millis () + (attempted ? UPLINK_RETRY_PERIOD : 0);
+}
+
+void UplinkQueue::popHigh () {
+	if (high[highHead].length > UPLINK_FRAME_SIZE) {
+		longUsed = false;
+	}
+	highHead = (highHead + 1) % UPLINK_HIGH_LANE_SIZE;
+	highCount--;
+}
+
+bool UplinkQueue::attempt (uplinkFrame_t& frame, sendData_cb& sender) {
+	const uint8_t* data = frame.length > UPLINK_FRAME_SIZE ? longFrame : frame.data;
+	if (sender && transmit (data, frame.length, frame.encoding, sender)) {
+		return true;
+	}
+	if (++frame.retries > UPLINK_MAX_RETRIES) {
+		DEBUG_WARN ("Frame dropped after %d retries", UPLINK_MAX_RETRIES);
+		droppedFrames++;
+		return true;
+	}
+	frame.nextAttempt = millis () + (UPLINK_RETRY_PERIOD << frame.retries);
+	return false;
+}
+
+bool UplinkQueue::transmit (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, sendData_cb& sender) {
+	uint32_t started = LatencyHistogram::start ();
+	bool result = sender (data, length, encoding);
+	sendLatency.add (started);
+	if (!result) {
+		sendFailures++;
+	}
+	return result;
+}
+
+void UplinkQueue::loop (sendData_cb& sender) {
+	clock_t now = millis ();
+
+	while (highCount) {
+		uplinkFrame_t& frame = high[highHead];
+		if ((long)(now - frame.nextAttempt) < 0 || !attempt (frame, sender)) {
+			return;
+		}
+		popHigh ();
+	}
+
+	for (uint8_t slot = 0; slot < lowSlots; slot++) {
+		if ((lowUsed & (1 << slot)) && (long)(now - low[slot].nextAttempt) >= 0 && attempt (low[slot], sender)) {
+			lowUsed &= ~(1 << slot);
+		}
+	}
+}
+
+clock_t UplinkQueue::nextAttempt () {
+	if (highCount) {
+		return high[highHead].nextAttempt;
+	}
+	clock_t next = 0;
+	bool found = false;
+	for (uint8_t slot = 0; slot < lowSlots; slot++) {
+		if ((lowUsed & (1 << slot)) && (!found || (long)(low[slot].nextAttempt - next) < 0)) {
+			next = low[slot].nextAttempt;
+			found = true;
+		}
+	}
+	return next;
+}
@@ -0,0 +1,166 @@
+// UplinkQueue.h
+
+#ifndef _UPLINKQUEUE_h
+#define _UPLINKQUEUE_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+	#include "arduino.h"
+#else
+	#include "WProgram.h"
+#endif
+
+#include <EnigmaIOTjsonController.h>
+#include "LatencyStats.h"
+
+constexpr auto UPLINK_FRAME_SIZE = 64; ///< @brief Maximum size of a queued frame, except for the long one
+constexpr auto UPLINK_LONG_FRAME_SIZE = 214; ///< @brief Maximum size of a high priority frame. Largest data payload of EnigmaIOT. Only one such frame may wait
+constexpr auto UPLINK_HIGH_LANE_SIZE = 4; ///< @brief Number of high priority frames that may wait for retry
+constexpr auto UPLINK_MAX_RETRIES = 5; ///< @brief Frame is dropped after this number of failed retries
+constexpr auto UPLINK_RETRY_PERIOD = 200; ///< @brief Time to first retry in ms. It doubles on every failed retry
+constexpr auto UPLINK_LOW_LANE_MAX = 8; ///< @brief Maximum number of low priority slots
+
+/**
+  * @brief Uplink message priority
+  */
+typedef enum {
+	UPLINK_HIGH = 0, ///< @brief Command responses, state changes and button events. Kept in order until sent
+	UPLINK_LOW = 1 ///< @brief Periodic position. Only the newest frame of every slot is kept
+} uplinkPriority_t;
+
+struct uplinkFrame_t {
+	uint8_t data[UPLINK_FRAME_SIZE]; ///< @brief Not used if frame is longer. Its content is on long frame buffer then
+	uint8_t length;
+	nodePayloadEncoding_t encoding;
+	uint8_t retries; ///< @brief Failed send attempts
+	clock_t nextAttempt; ///< @brief Time of next retry
+};
+
+/**
+  * @brief Fixed size outbound queue with two priority lanes
+  *
+  * Frames are sent immediately when nothing is waiting. A frame that cannot be sent is kept and retried
+  * from `loop` with exponential backoff. Low priority frames are only sent when high priority lane is empty.
+  * Low priority lane has one slot per source, so that positions of different blinds do not replace each other.
+  * Long command responses, like stats or a full schedule, keep their place on high priority lane but their content
+  * goes to a single long frame buffer, so a second one cannot wait at the same time.
+  */
+class UplinkQueue {
+public:
+	/**
+	  * @param lowLane Storage for low priority slots, owned by caller
+	  * @param lowSlots Number of low priority slots. Up to `UPLINK_LOW_LANE_MAX`
+	  */
+	UplinkQueue (uplinkFrame_t* lowLane, uint8_t lowSlots) : low (lowLane), lowSlots (lowSlots) {}
+
+	/**
+	  * @brief Sends a frame or queues it if it cannot be sent now
+	  * @param data Frame content. It is copied if frame has to be queued
+	  * @param length Frame length
+	  * @param encoding Payload encoding
+	  * @param priority Frame priority
+	  * @param sender Function that sends data to gateway
+	  * @param slot Low priority slot replaced by this frame. Not used for high priority frames
+	  * @return Returns `true` if frame was sent or queued. `false` if it is too long, no sender is defined or
+	  * another long frame is waiting
+	  */
+	bool send (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, uplinkPriority_t priority, sendData_cb& sender, uint8_t slot = 0);
+
+	/**
+	  * @brief Gets a buffer to serialize a frame in place, avoiding a copy
+	  *
+	  * Content is taken by a later call to `send` with `data` pointing to this buffer.
+	  * @return Buffer of `UPLINK_LONG_FRAME_SIZE` bytes
+	  */
+	uint8_t* buffer () {
+		return scratch;
+	}
+
+	/**
+	  * @brief Gets maximum length of a frame with given priority
+	  */
+	static size_t frameSize (uplinkPriority_t priority) {
+		return priority == UPLINK_HIGH ? UPLINK_LONG_FRAME_SIZE : UPLINK_FRAME_SIZE;
+	}
+
+	/**
+	  * @brief Retries waiting frames whose backoff time has elapsed
+	  * @param sender Function that sends data to gateway
+	  */
+	void loop (sendData_cb& sender);
+
+	/**
+	  * @brief Checks if any frame is waiting for retry
+	  */
+	bool pending () {
+		return highCount || lowUsed;
+	}
+
+	/**
+	  * @brief Gets time of next retry. Only valid if `pending` returns `true`
+	  */
+	clock_t nextAttempt ();
+
+	/**
+	  * @brief Number of frames dropped after too many retries or because high priority lane or long frame buffer was full
+	  */
+	uint32_t dropped () {
+		return droppedFrames;
+	}
+
+	/**
+	  * @brief Number of send attempts that failed, including those that were retried later
+	  */
+	uint32_t failures () {
+		return sendFailures;
+	}
+
+	/**
+	  * @brief Time taken by every call to send function
+	  */
+	const LatencyHistogram& latency () {
+		return sendLatency;
+	}
+
+	/**
+	  * @brief Clears dropped frames, failures and latency counters
+	  */
+	void clearStats () {
+		droppedFrames = 0;
+		sendFailures = 0;
+		sendLatency.clear ();
+	}
+
+protected:
+	uplinkFrame_t high[UPLINK_HIGH_LANE_SIZE]; ///< @brief High priority lane. Circular buffer
+	uint8_t highHead = 0; ///< @brief Index of oldest high priority frame
+	uint8_t highCount = 0; ///< @brief Number of high priority frames waiting
+	uplinkFrame_t* low; ///< @brief Low priority lane. Newer frames replace the waiting one on the same slot
+	uint8_t lowSlots;
+	uint8_t lowUsed = 0; ///< @brief Bit mask of low priority slots waiting
+	uint8_t longFrame[UPLINK_LONG_FRAME_SIZE]; ///< @brief Content of the high priority frame longer than `UPLINK_FRAME_SIZE`
+	bool longUsed = false; ///< @brief A long frame is waiting on high priority lane
+	uint8_t scratch[UPLINK_LONG_FRAME_SIZE]; ///< @brief Serialization buffer for messages that are sent immediately
+	uint32_t droppedFrames = 0;
+	uint32_t sendFailures = 0;
+	LatencyHistogram sendLatency = {};
+
+	void store (uplinkFrame_t& frame, const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, bool sent);
+
+	/**
+	  * @brief Removes oldest high priority frame
+	  */
+	void popHigh ();
+
+	/**
+	  * @brief Tries to send a waiting frame
+	  * @return Returns `true` if frame does not need to be kept anymore
+	  */
+	bool attempt (uplinkFrame_t& frame, sendData_cb& sender);
+
+	/**
+	  * @brief Calls send function measuring its duration
+	  */
+	bool transmit (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding, sendData_cb& sender);
+};
+
+#endif
@@ -6,6 +6,9 @@
   *
   * If `DEBUG_ESP_PORT` is not defined library will give no debug output at all
   *
+  * With `DEBUG_BINARY_LOG` set to 1 messages are not formatted on the device. They are stored as binary records
+  * and sent on idle time. See DebugLog.h
+  *
   * @file debug.h
   * @version 0.8.3
   * @date 05/05/2020
@@ -32,6 +35,10 @@
 #define DEBUG_LEVEL WARN ///< @brief Possible values VERBOSE, DBG, INFO, WARN, ERROR, NONE
 #endif //DEBUG_LEVEL
 
+#ifndef DEBUG_BINARY_LOG
+#define DEBUG_BINARY_LOG 0 ///< @brief Store messages as binary records that are sent on idle time instead of printing them
+#endif
+
 
 #ifdef ESP8266
 #define DEBUG_LINE_PREFIX() DEBUG_ESP_PORT.printf_P (PSTR("[%lu] %lu free (%s:%d) "),millis(),(unsigned long)ESP.getFreeHeap(),__FUNCTION__,__LINE__)
@@ -39,7 +46,39 @@
 
 #ifdef DEBUG_ESP_PORT
 
-#ifdef ESP8266
+#if DEBUG_BINARY_LOG
+#include "DebugLog.h"
+
+#if DEBUG_LEVEL >= VERBOSE
+#define DEBUG_VERBOSE(text,...) DEBUG_LOG_RECORD('V',text,##__VA_ARGS__)
+#else
+#define DEBUG_VERBOSE(...)
+#endif
+
+#if DEBUG_LEVEL >= DBG
+#define DEBUG_DBG(text,...) DEBUG_LOG_RECORD('D',text,##__VA_ARGS__)
+#else
+#define DEBUG_DBG(...)
+#endif
+
+#if DEBUG_LEVEL >= INFO
+#define DEBUG_INFO(text,...) DEBUG_LOG_RECORD('I',text,##__VA_ARGS__)
+#else
+#define DEBUG_INFO(...)
+#endif
+
+#if DEBUG_LEVEL >= WARN
+#define DEBUG_WARN(text,...) DEBUG_LOG_RECORD('W',text,##__VA_ARGS__)
+#else
+#define DEBUG_WARN(...)
+#endif
+
+#if DEBUG_LEVEL >= ERROR
+#define DEBUG_ERROR(text,...) DEBUG_LOG_RECORD('E',text,##__VA_ARGS__)
+#else
+#define DEBUG_ERROR(...)
+#endif
+#elif defined ESP8266
 #if DEBUG_LEVEL >= VERBOSE
 #define DEBUG_VERBOSE(text,...) DEBUG_ESP_PORT.print("V ");DEBUG_LINE_PREFIX();DEBUG_ESP_PORT.printf_P(PSTR(text),##__VA_ARGS__);DEBUG_ESP_PORT.println()
 #else
@@ -86,6 +125,5 @@
 #endif
 
 
-
 #endif
 
@@ -0,0 +1,352 @@
+/**
+  * @brief Micro-benchmarks for BlindController hot paths on a Linux host
+  *
+  * Reports wall time per iteration together with heap allocations, relay writes and uplink
+  * traffic per iteration. Time seen by the controller is simulated and advanced explicitly, so
+  * only the CPU cost of the controller code is measured.
+  *
+  * Usage: blind_bench [--quick] [--filter <text>]
+  *
+  * @file BlindControllerBench.cpp
+  */
+
+#include <BlindController.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+class BenchController : public BlindController {
+public:
+	using BlindController::gotoPosition;
+	using BlindController::fullRollup;
+	using BlindController::processBlindEvent;
+	using BlindController::sendGetStatus;
+	using BlindController::getState;
+	using BlindController::getPosition;
+	using BlindController::loadConfig;
+	using BlindController::saveConfig;
+	using BlindController::idleTime;
+
+	void setTelemetryEncoding (telemetryEncoding_t encoding) {
+		config.telemetryEncoding = encoding;
+	}
+
+	void setReportStep (uint8_t step) {
+		config.reportStep = step;
+	}
+
+	bool uplinkPending () {
+		return uplink.pending ();
+	}
+
+	void setSendData (sendData_cb cb) {
+		((::EnigmaIOTjsonController*)this)->sendDataCallback (cb);
+	}
+};
+
+// Four blinds on one node
+class BenchMultiController : public MultiBlindController<4> {
+public:
+	using MultiBlindController<4>::gotoPosition;
+	using MultiBlindController<4>::fullRollup;
+	using MultiBlindController<4>::getState;
+
+	void setSendData (sendData_cb cb) {
+		((::EnigmaIOTjsonController*)this)->sendDataCallback (cb);
+	}
+};
+
+struct uplinkStats_t {
+	unsigned long frames;
+	unsigned long bytes;
+};
+
+static uplinkStats_t uplink;
+
+static bool countUplink (const uint8_t*, size_t len, nodePayloadEncoding_t) {
+	uplink.frames++;
+	uplink.bytes += len;
+	return true;
+}
+
+// Radio busy on every other attempt. Only delivered frames are counted
+static bool lossyUplink (const uint8_t* data, size_t len, nodePayloadEncoding_t payloadEncoding) {
+	static bool busy;
+	busy = !busy;
+	return busy ? false : countUplink (data, len, payloadEncoding);
+}
+
+struct benchResult_t {
+	std::string name;
+	unsigned long iterations;
+	double nsPerIteration;
+	double allocsPerIteration;
+	long peakHeap;
+	double writesPerIteration;
+	double framesPerIteration;
+	double bytesPerFrame;
+};
+
+template <typename F>
+static benchResult_t runBench (const char* name, unsigned long iterations, F&& body) {
+	uplink = { 0, 0 };
+	hostResetCounters ();
+	auto start = std::chrono::steady_clock::now ();
+	for (unsigned long i = 0; i < iterations; i++) {
+		body (i);
+	}
+	auto end = std::chrono::steady_clock::now ();
+	hostHeapStats_t heap = hostHeapStats ();
+
+	benchResult_t result;
+	result.name = name;
+	result.iterations = iterations;
+	result.nsPerIteration = std::chrono::duration<double, std::nano> (end - start).count () / iterations;
+	result.allocsPerIteration = (double)heap.allocations / iterations;
+	result.peakHeap = heap.peakBytes;
+	result.writesPerIteration = (double)hostDigitalWriteCount () / iterations;
+	result.framesPerIteration = (double)uplink.frames / iterations;
+	result.bytesPerFrame = uplink.frames ? (double)uplink.bytes / uplink.frames : 0;
+	return result;
+}
+
+static std::vector<uint8_t> encodeCommand (const char* cmd, const char* key = nullptr, int value = 0) {
+	DynamicJsonDocument doc (JSON_OBJECT_SIZE (2));
+	doc["cmd"] = cmd;
+	if (key) {
+		doc[key] = value;
+	}
+	std::vector<uint8_t> buffer (measureMsgPack (doc));
+	serializeMsgPack (doc, buffer.data (), buffer.size ());
+	return buffer;
+}
+
+static BenchMultiController* newMultiController () {
+	static const int relayPins[4][2] = { { 14, 12 }, { 16, 17 }, { 18, 19 }, { 25, 26 } };
+	blindControlerHw_t hw[4];
+	memset (hw, 0, sizeof (hw));
+	for (int channel = 0; channel < 4; channel++) {
+		hw[channel].upRelayPin = relayPins[channel][0];
+		hw[channel].downRelayPin = relayPins[channel][1];
+		hw[channel].upButton = NO_BUTTON;
+		hw[channel].downButton = NO_BUTTON;
+		hw[channel].ON_STATE = HIGH;
+		hw[channel].curveProfile = CURVE_AWNING;
+		hw[channel].reportStep = 20;
+		hw[channel].reportMinInterval = 2000;
+		hw[channel].reportMaxInterval = 600000;
+	}
+	BenchMultiController* controller = new BenchMultiController ();
+	controller->setSendData (countUplink);
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, hw);
+	return controller;
+}
+
+static BenchController* newController () {
+	BenchController* controller = new BenchController ();
+	controller->setSendData (countUplink);
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode);
+	return controller;
+}
+
+// Runs loop with simulated time until the blind stops
+static void runUntilStopped (BenchController* controller) {
+	do {
+		hostAdvanceMillis (1);
+		controller->loop ();
+	} while (controller->getState () != stopped);
+}
+
+int main (int argc, char** argv) {
+	unsigned long scale = 1;
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp (argv[i], "--quick")) {
+			scale = 0;
+		} else if (!strcmp (argv[i], "--filter") && i + 1 < argc) {
+			filter = argv[++i];
+		} else {
+			fprintf (stderr, "Usage: %s [--quick] [--filter <text>]\n", argv[0]);
+			return 2;
+		}
+	}
+	const unsigned long loopIterations = scale ? 2000000 : 20000;
+	const unsigned long commandIterations = scale ? 200000 : 2000;
+
+	hostResetCounters ();
+	hostSetMillis (1000);
+	BenchController* controller = newController ();
+	controller->fullRollup ();
+	runUntilStopped (controller);
+	if (controller->getPosition () != 100) {
+		fprintf (stderr, "Calibration failed. Position = %d\n", controller->getPosition ());
+		return 1;
+	}
+
+	std::vector<benchResult_t> results;
+	auto enabled = [filter] (const char* name) {
+		return !filter || strstr (name, filter);
+	};
+
+	if (enabled ("boot/load_config")) {
+		controller->saveConfig ();
+		results.push_back (runBench ("boot/load_config", commandIterations, [&] (unsigned long) {
+			controller->loadConfig ();
+		}));
+	}
+
+	if (enabled ("loop/idle")) {
+		results.push_back (runBench ("loop/idle", loopIterations, [&] (unsigned long) {
+			hostAdvanceMillis (1);
+			controller->loop ();
+		}));
+	}
+
+	if (enabled ("loop/idle_second")) {
+		// Main loop as in sketch: sleeps as long as controller allows. Every iteration is one simulated second
+		results.push_back (runBench ("loop/idle_second", loopIterations / 1000, [&] (unsigned long) {
+			unsigned long end = millis () + 1000;
+			while ((long)(millis () - end) < 0) {
+				controller->loop ();
+				uint32_t idle = controller->idleTime ();
+				hostAdvanceMillis (idle ? idle : 1);
+			}
+		}));
+	}
+
+	// One simulated hour with a movement at the start of it, comparing both notification modes
+	const struct {
+		const char* name;
+		uint8_t reportStep;
+	} uplinkModes[] = {
+		{ "uplink/periodic", 0 },
+		{ "uplink/on_change", 20 },
+	};
+	for (const auto& mode : uplinkModes) {
+		if (!enabled (mode.name)) {
+			continue;
+		}
+		controller->setReportStep (mode.reportStep);
+		bool goingDown = true;
+		results.push_back (runBench (mode.name, 24, [&] (unsigned long) {
+			controller->gotoPosition (goingDown ? 20 : 80);
+			goingDown = !goingDown;
+			unsigned long end = millis () + 3600000;
+			while ((long)(millis () - end) < 0) {
+				controller->loop ();
+				uint32_t idle = controller->idleTime ();
+				hostAdvanceMillis (idle ? idle : 1);
+			}
+		}));
+		controller->setReportStep (20);
+	}
+
+	if (enabled ("loop/moving")) {
+		bool goingDown = true;
+		results.push_back (runBench ("loop/moving", loopIterations, [&] (unsigned long) {
+			if (controller->getState () == stopped) {
+				controller->gotoPosition (goingDown ? 20 : 80);
+				goingDown = !goingDown;
+			}
+			hostAdvanceMillis (1);
+			controller->loop ();
+		}));
+		runUntilStopped (controller);
+	}
+
+	if (enabled ("loop/moving_4ch")) {
+		// Same movement on four blinds driven by one controller
+		BenchMultiController* multi = newMultiController ();
+		bool goingDown = true;
+		results.push_back (runBench ("loop/moving_4ch", loopIterations, [&] (unsigned long) {
+			if (multi->getState (0) == stopped) {
+				for (uint8_t channel = 0; channel < 4; channel++) {
+					if (goingDown) {
+						multi->gotoPosition (20, channel);
+					} else {
+						multi->fullRollup (channel);
+					}
+				}
+				goingDown = !goingDown;
+			}
+			hostAdvanceMillis (1);
+			multi->loop ();
+		}));
+		delete multi;
+	}
+
+	struct command_t {
+		const char* name;
+		nodeMessageType_t type;
+		std::vector<uint8_t> payload;
+	};
+	const command_t commands[] = {
+		{ "rx/get_pos", DOWNSTREAM_DATA_GET, encodeCommand ("pos") },
+		{ "rx/get_state", DOWNSTREAM_DATA_GET, encodeCommand ("state") },
+		{ "rx/get_time", DOWNSTREAM_DATA_GET, encodeCommand ("time") },
+		{ "rx/set_go", DOWNSTREAM_DATA_SET, encodeCommand ("go", "pos", 50) },
+		{ "rx/set_stop", DOWNSTREAM_DATA_SET, encodeCommand ("stop") },
+		{ "rx/get_fields", DOWNSTREAM_DATA_GET, encodeCommand ("get") },
+		{ "rx/get_sched", DOWNSTREAM_DATA_GET, encodeCommand ("sched") },
+		{ "rx/get_stats", DOWNSTREAM_DATA_GET, encodeCommand ("stats") },
+		{ "rx/set_stop_grp", DOWNSTREAM_DATA_SET, encodeCommand ("stop", "grp", 0) },
+	};
+	for (const command_t& command : commands) {
+		if (!enabled (command.name)) {
+			continue;
+		}
+		bool ok = true;
+		results.push_back (runBench (command.name, commandIterations, [&] (unsigned long) {
+			ok &= controller->processRxCommand (nullptr, command.payload.data (), command.payload.size (), command.type, MSG_PACK);
+		}));
+		if (!ok) {
+			fprintf (stderr, "Command %s failed\n", command.name);
+			return 1;
+		}
+		controller->loop ();
+	}
+
+	if (enabled ("tx/blind_event")) {
+		results.push_back (runBench ("tx/blind_event", commandIterations, [&] (unsigned long) {
+			controller->processBlindEvent (0, controller->getState (), controller->getPosition ());
+		}));
+	}
+
+	if (enabled ("tx/get_status")) {
+		results.push_back (runBench ("tx/get_status", commandIterations, [&] (unsigned long) {
+			controller->sendGetStatus ();
+		}));
+	}
+
+	if (enabled ("tx/blind_event_lpp")) {
+		controller->setTelemetryEncoding (TELEMETRY_CAYENNELPP);
+		results.push_back (runBench ("tx/blind_event_lpp", commandIterations, [&] (unsigned long) {
+			controller->processBlindEvent (0, controller->getState (), controller->getPosition ());
+		}));
+		controller->setTelemetryEncoding (TELEMETRY_MSGPACK);
+	}
+
+	if (enabled ("tx/event_lossy")) {
+		controller->setSendData (lossyUplink);
+		results.push_back (runBench ("tx/event_lossy", commandIterations, [&] (unsigned long) {
+			controller->processBlindEvent (0, controller->getState (), controller->getPosition ());
+			while (controller->uplinkPending ()) { // Run loop until retry succeeds
+				uint32_t idle = controller->idleTime ();
+				hostAdvanceMillis (idle ? idle : 1);
+				controller->loop ();
+			}
+		}));
+		controller->setSendData (countUplink);
+	}
+
+	printf ("%-18s %10s %10s %10s %10s %10s %10s %10s\n", "benchmark", "iters", "ns/iter", "allocs/it", "peak heap", "writes/it", "frames/it", "B/frame");
+	for (const benchResult_t& r : results) {
+		printf ("%-18s %10lu %10.1f %10.3f %10ld %10.3f %10.4f %10.1f\n", r.name.c_str (), r.iterations, r.nsPerIteration,
+				r.allocsPerIteration, r.peakHeap, r.writesPerIteration, r.framesPerIteration, r.bytesPerFrame);
+	}
+
+	delete controller;
+	return 0;
+}
@@ -0,0 +1,204 @@
+/**
+  * @brief Minimal Arduino core stand-in used to build BlindController on a Linux host
+  *
+  * Time, GPIO and heap are simulated so that code under test runs deterministically.
+  * Simulated state is controlled through the `host*` functions declared at the end of this file.
+  *
+  * @file Arduino.h
+  */
+
+#ifndef _HOST_ARDUINO_h
+#define _HOST_ARDUINO_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <algorithm>
+#include <functional>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT             0x00
+#define INPUT_PULLUP      0x02
+#define OUTPUT            0x01
+
+#define RISING            0x01
+#define FALLING           0x02
+#define CHANGE            0x03
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define PSTR(s) (s)
+#define F(s) (s)
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+unsigned long millis ();
+unsigned long micros ();
+void delay (unsigned long ms);
+void yield ();
+
+// Pin numbers are wider than on boards so that a fleet simulation may give every blind its own relays
+void pinMode (uint16_t pin, uint8_t mode);
+void digitalWrite (uint16_t pin, uint8_t val);
+int digitalRead (uint16_t pin);
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterruptArg (uint16_t pin, void (*handler) (void*), void* arg, int mode);
+void detachInterrupt (uint16_t pin);
+
+char* itoa (int value, char* str, int base);
+
+// Pseudo random sequence. It repeats on every run unless `randomSeed` is called
+long random (long max);
+long random (long min, long max);
+void randomSeed (unsigned long seed);
+
+class Print {
+public:
+	virtual ~Print () {}
+	virtual size_t write (uint8_t c) = 0;
+	virtual size_t write (const uint8_t* buffer, size_t size) {
+		size_t n = 0;
+		while (size--) {
+			n += write (*buffer++);
+		}
+		return n;
+	}
+	size_t print (const char* str) {
+		return write ((const uint8_t*)str, strlen (str));
+	}
+	size_t print (int value) {
+		char buf[12];
+		snprintf (buf, sizeof (buf), "%d", value);
+		return print (buf);
+	}
+	size_t println (const char* str = "") {
+		return print (str) + print ("\n");
+	}
+	size_t printf (const char* format, ...) __attribute__ ((format (printf, 2, 3)));
+	size_t printf_P (const char* format, ...) __attribute__ ((format (printf, 2, 3)));
+protected:
+	size_t vprintf (const char* format, va_list args);
+};
+
+class Stream : public Print {
+public:
+	virtual int available () = 0;
+	virtual int read () = 0;
+	virtual int peek () = 0;
+	virtual size_t readBytes (uint8_t* buffer, size_t length) {
+		size_t n = 0;
+		int c;
+		while (n < length && (c = read ()) >= 0) {
+			buffer[n++] = (uint8_t)c;
+		}
+		return n;
+	}
+};
+
+class HardwareSerial : public Stream {
+public:
+	void begin (unsigned long) {}
+	size_t write (uint8_t c) override;
+	size_t write (const uint8_t* buffer, size_t size) override;
+	int available () override { return 0; }
+	int read () override { return -1; }
+	int peek () override { return -1; }
+	int availableForWrite () { return 128; } ///< @brief Same as UART FIFO. Host writes never block
+	using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+class String {
+public:
+	String (const char* str = "");
+	String (int value);
+	String (const String& other);
+	String& operator= (const String& other);
+	~String ();
+	const char* c_str () const { return buffer; }
+	size_t length () const { return len; }
+	bool operator== (const char* other) const { return !strcmp (buffer, other); }
+	String& operator+= (const char* other);
+private:
+	char* buffer;
+	size_t len;
+};
+
+class EspClass {
+public:
+	uint32_t getFreeHeap ();
+	uint32_t getCycleCount ();
+	uint8_t getCpuFreqMHz () { return 80; }
+	uint32_t getMaxFreeBlockSize () { return getFreeHeap (); }
+	uint32_t getChipId () { return 0x00C0FFEE; }
+	bool rtcUserMemoryRead (uint32_t offset, uint32_t* data, size_t size);
+	bool rtcUserMemoryWrite (uint32_t offset, uint32_t* data, size_t size);
+	void restart () {}
+};
+
+extern EspClass ESP;
+
+// ---- Host simulation controls ----
+
+/**
+  * @brief Simulated clock. `millis()` and `micros()` only move when these are called or on `delay()`
+  */
+void hostSetMillis (unsigned long ms);
+void hostAdvanceMillis (unsigned long ms);
+
+/**
+  * @brief Current level of an output pin as last written by `digitalWrite`
+  */
+int hostPinLevel (uint16_t pin);
+/**
+  * @brief Sets the level that `digitalRead` returns for an input pin. Attached interrupt handler runs on level change
+  */
+void hostSetPinInput (uint16_t pin, int level);
+/**
+  * @brief Number of `digitalWrite` calls since last reset
+  */
+unsigned long hostDigitalWriteCount ();
+/**
+  * @brief Sets a function that is called on every `digitalWrite`, after pin level is updated. `nullptr` removes it
+  */
+void hostOnDigitalWrite (void (*hook) (uint16_t pin, uint8_t val));
+
+/**
+  * @brief Clears RTC user memory, as a power loss does. It survives `ESP.restart ()`
+  */
+void hostClearRtcMemory ();
+/**
+  * @brief Number of `ESP.rtcUserMemoryWrite` calls since last reset
+  */
+unsigned long hostRtcWriteCount ();
+
+struct hostHeapStats_t {
+	unsigned long allocations; ///< @brief Number of allocations since last reset
+	unsigned long frees; ///< @brief Number of frees since last reset
+	long liveBytes; ///< @brief Bytes currently allocated since last reset
+	long peakBytes; ///< @brief Peak of `liveBytes` since last reset
+};
+
+/**
+  * @brief Heap counters, updated by the malloc hooks in HostShim.cpp
+  */
+hostHeapStats_t hostHeapStats ();
+void hostResetCounters ();
+
+#endif // _HOST_ARDUINO_h
@@ -0,0 +1,460 @@
+/**
+  * @brief Reduced ArduinoJson 6 stand-in for host builds
+  *
+  * Implements the subset of the ArduinoJson 6 API used by EnigmaIOT controllers: documents with a
+  * fixed memory pool, objects, arrays, scalar values, and JSON / MsgPack serialization and parsing.
+  * Like the original library, `const char*` keys and values are stored by reference and
+  * `char*` or `String` ones are copied into the document pool.
+  *
+  * @file ArduinoJson.h
+  */
+
+#ifndef _HOST_ARDUINOJSON_h
+#define _HOST_ARDUINOJSON_h
+
+#include <Arduino.h>
+#include <type_traits>
+
+struct JsonSlot;
+class JsonPool;
+
+#define JSON_SLOT_SIZE 40
+#define JSON_OBJECT_SIZE(n) ((n) * JSON_SLOT_SIZE)
+#define JSON_ARRAY_SIZE(n) ((n) * JSON_SLOT_SIZE)
+#define JSON_STRING_SIZE(n) ((n) + 1)
+
+enum jsonType_t : uint8_t {
+	JSON_NULL,
+	JSON_BOOL,
+	JSON_INT,
+	JSON_UINT,
+	JSON_FLOAT,
+	JSON_STRING,
+	JSON_ARRAY,
+	JSON_OBJECT
+};
+
+struct JsonSlot {
+	const char* key;
+	JsonSlot* next;
+	union {
+		bool asBool;
+		int64_t asInt;
+		uint64_t asUint;
+		double asFloat;
+		const char* asString;
+		struct {
+			JsonSlot* head;
+			JsonSlot* tail;
+		} asCollection;
+	} value;
+	jsonType_t type;
+};
+
+static_assert (sizeof (JsonSlot) <= JSON_SLOT_SIZE, "JSON_SLOT_SIZE too small");
+
+class JsonPool {
+public:
+	JsonPool (char* buffer, size_t capacity) : begin (buffer), left (buffer), right (buffer + capacity), end (buffer + capacity) {}
+	JsonSlot* allocSlot ();
+	const char* saveString (const char* str, size_t len);
+	void clear () {
+		left = begin;
+		right = end;
+		overflow = false;
+	}
+	size_t size () const { return (left - begin) + (end - right); }
+	size_t capacity () const { return end - begin; }
+	bool overflowed () const { return overflow; }
+private:
+	char* begin;
+	char* left;
+	char* right;
+	char* end;
+	bool overflow = false;
+};
+
+class JsonString {
+public:
+	JsonString (const char* str = nullptr) : str (str) {}
+	const char* c_str () const { return str; }
+	bool isNull () const { return !str; }
+private:
+	const char* str;
+};
+
+class JsonArray;
+class JsonObject;
+class MemberProxy;
+
+class JsonVariant {
+public:
+	JsonVariant () : slot (nullptr), pool (nullptr) {}
+	JsonVariant (JsonSlot* slot, JsonPool* pool) : slot (slot), pool (pool) {}
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, bool>::type set (T value) {
+		if (!slot) return false;
+		if (std::is_signed<T>::value) {
+			slot->type = JSON_INT;
+			slot->value.asInt = (int64_t)value;
+		} else {
+			slot->type = JSON_UINT;
+			slot->value.asUint = (uint64_t)value;
+		}
+		return true;
+	}
+	template <typename T>
+	typename std::enable_if<std::is_enum<T>::value, bool>::type set (T value) {
+		return set ((int)value);
+	}
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value, bool>::type set (T value) {
+		if (!slot) return false;
+		slot->type = JSON_FLOAT;
+		slot->value.asFloat = value;
+		return true;
+	}
+	bool set (bool value);
+	bool set (const char* value);
+	bool set (char* value);
+	bool set (const String& value);
+	bool set (std::nullptr_t);
+	bool set (JsonVariant value);
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, T>::type as () const {
+		if (!slot) return 0;
+		switch (slot->type) {
+		case JSON_INT: return (T)slot->value.asInt;
+		case JSON_UINT: return (T)slot->value.asUint;
+		case JSON_FLOAT: return (T)slot->value.asFloat;
+		case JSON_BOOL: return (T)slot->value.asBool;
+		default: return 0;
+		}
+	}
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value, T>::type as () const {
+		if (!slot) return 0;
+		switch (slot->type) {
+		case JSON_INT: return (T)slot->value.asInt;
+		case JSON_UINT: return (T)slot->value.asUint;
+		case JSON_FLOAT: return (T)slot->value.asFloat;
+		default: return 0;
+		}
+	}
+	template <typename T>
+	typename std::enable_if<std::is_same<T, bool>::value, T>::type as () const {
+		if (!slot) return false;
+		switch (slot->type) {
+		case JSON_BOOL: return slot->value.asBool;
+		case JSON_INT: return slot->value.asInt != 0;
+		case JSON_UINT: return slot->value.asUint != 0;
+		case JSON_FLOAT: return slot->value.asFloat != 0;
+		default: return false;
+		}
+	}
+	template <typename T>
+	typename std::enable_if<std::is_same<T, const char*>::value, T>::type as () const {
+		return (slot && slot->type == JSON_STRING) ? slot->value.asString : nullptr;
+	}
+	template <typename T>
+	typename std::enable_if<std::is_same<T, String>::value, T>::type as () const {
+		const char* str = as<const char*> ();
+		return String (str ? str : "");
+	}
+	template <typename T>
+	typename std::enable_if<std::is_base_of<JsonVariant, T>::value, T>::type as () const;
+
+	template <typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, bool>::type is () const {
+		return slot && (slot->type == JSON_INT || slot->type == JSON_UINT);
+	}
+	template <typename T>
+	typename std::enable_if<std::is_floating_point<T>::value, bool>::type is () const {
+		return slot && (slot->type == JSON_INT || slot->type == JSON_UINT || slot->type == JSON_FLOAT);
+	}
+	template <typename T>
+	typename std::enable_if<std::is_same<T, bool>::value, bool>::type is () const {
+		return slot && slot->type == JSON_BOOL;
+	}
+	template <typename T>
+	typename std::enable_if<std::is_same<T, const char*>::value || std::is_same<T, char*>::value, bool>::type is () const {
+		return slot && slot->type == JSON_STRING;
+	}
+	template <typename T>
+	typename std::enable_if<std::is_same<T, JsonArray>::value, bool>::type is () const {
+		return slot && slot->type == JSON_ARRAY;
+	}
+	template <typename T>
+	typename std::enable_if<std::is_same<T, JsonObject>::value, bool>::type is () const {
+		return slot && slot->type == JSON_OBJECT;
+	}
+
+	template <typename T>
+	operator T () const {
+		return as<T> ();
+	}
+
+	template <typename T>
+	JsonVariant& operator= (T value) {
+		set (value);
+		return *this;
+	}
+	JsonVariant& operator= (const JsonVariant&) = default;
+	JsonVariant (const JsonVariant&) = default;
+
+	bool isNull () const { return !slot || slot->type == JSON_NULL; }
+	size_t size () const;
+	bool containsKey (const char* key) const { return !getMember (key).isNull (); }
+
+	MemberProxy operator[] (const char* key);
+	MemberProxy operator[] (char* key);
+	JsonVariant operator[] (size_t index) const { return getElement (index); }
+	JsonVariant operator[] (int index) const { return getElement ((size_t)index); }
+
+	JsonVariant getMember (const char* key) const;
+	JsonVariant getOrAddMember (const char* key, bool copyKey);
+	JsonVariant getElement (size_t index) const;
+	JsonVariant addElement ();
+	template <typename T>
+	bool add (T value) {
+		return addElement ().set (value);
+	}
+	JsonArray createNestedArray ();
+	JsonArray createNestedArray (const char* key);
+	JsonObject createNestedObject ();
+	JsonObject createNestedObject (const char* key);
+	void remove (const char* key);
+	void clear ();
+
+	JsonSlot* getSlot () const { return slot; }
+	JsonPool* getPool () const { return pool; }
+
+protected:
+	JsonSlot* slot;
+	JsonPool* pool;
+};
+
+class MemberProxy {
+public:
+	MemberProxy (JsonVariant parent, const char* key, bool copyKey) : parent (parent), key (key), copyKey (copyKey) {}
+
+	template <typename T>
+	MemberProxy& operator= (T value) {
+		parent.getOrAddMember (key, copyKey).set (value);
+		return *this;
+	}
+	MemberProxy& operator= (const MemberProxy& src) {
+		parent.getOrAddMember (key, copyKey).set (src.get ());
+		return *this;
+	}
+	MemberProxy (const MemberProxy&) = default;
+
+	JsonVariant get () const { return parent.getMember (key); }
+
+	template <typename T>
+	T as () const { return get ().as<T> (); }
+	template <typename T>
+	bool is () const { return get ().is<T> (); }
+	template <typename T>
+	operator T () const { return get ().as<T> (); }
+
+	bool isNull () const { return get ().isNull (); }
+	size_t size () const { return get ().size (); }
+	bool containsKey (const char* childKey) const { return get ().containsKey (childKey); }
+	JsonVariant operator[] (const char* childKey) const { return get ().getMember (childKey); }
+	JsonVariant operator[] (size_t index) const { return get ().getElement (index); }
+	JsonVariant operator[] (int index) const { return get ().getElement ((size_t)index); }
+	template <typename T>
+	bool add (T value) {
+		return parent.getOrAddMember (key, copyKey).add (value);
+	}
+	JsonArray createNestedArray ();
+	JsonObject createNestedObject ();
+
+private:
+	JsonVariant parent;
+	const char* key;
+	bool copyKey;
+};
+
+class JsonPair {
+public:
+	JsonPair (JsonSlot* slot, JsonPool* pool) : k (slot ? slot->key : nullptr), v (slot, pool) {}
+	JsonString key () const { return k; }
+	JsonVariant value () const { return v; }
+private:
+	JsonString k;
+	JsonVariant v;
+};
+
+template <typename TValue>
+class JsonIterator {
+public:
+	JsonIterator (JsonSlot* slot, JsonPool* pool) : slot (slot), pool (pool) {}
+	TValue operator* () const { return TValue (slot, pool); }
+	JsonIterator& operator++ () {
+		slot = slot->next;
+		return *this;
+	}
+	bool operator!= (const JsonIterator& other) const { return slot != other.slot; }
+private:
+	JsonSlot* slot;
+	JsonPool* pool;
+};
+
+class JsonArray : public JsonVariant {
+public:
+	JsonArray () {}
+	JsonArray (JsonSlot* slot, JsonPool* pool) : JsonVariant ((slot && slot->type == JSON_ARRAY) ? slot : nullptr, pool) {}
+	JsonIterator<JsonVariant> begin () const {
+		return JsonIterator<JsonVariant> (slot ? slot->value.asCollection.head : nullptr, pool);
+	}
+	JsonIterator<JsonVariant> end () const {
+		return JsonIterator<JsonVariant> (nullptr, pool);
+	}
+};
+
+class JsonObject : public JsonVariant {
+public:
+	JsonObject () {}
+	JsonObject (JsonSlot* slot, JsonPool* pool) : JsonVariant ((slot && slot->type == JSON_OBJECT) ? slot : nullptr, pool) {}
+	JsonIterator<JsonPair> begin () const {
+		return JsonIterator<JsonPair> (slot ? slot->value.asCollection.head : nullptr, pool);
+	}
+	JsonIterator<JsonPair> end () const {
+		return JsonIterator<JsonPair> (nullptr, pool);
+	}
+};
+
+template <typename T>
+typename std::enable_if<std::is_base_of<JsonVariant, T>::value, T>::type JsonVariant::as () const {
+	return T (slot, pool);
+}
+
+class JsonDocument {
+public:
+	JsonDocument (const JsonDocument&) = delete;
+	JsonDocument& operator= (const JsonDocument&) = delete;
+
+	MemberProxy operator[] (const char* key) { return getVariant ()[key]; }
+	MemberProxy operator[] (char* key) { return getVariant ()[key]; }
+	JsonVariant operator[] (size_t index) { return getVariant ().getElement (index); }
+	JsonVariant operator[] (int index) { return getVariant ().getElement ((size_t)index); }
+
+	bool containsKey (const char* key) { return getVariant ().containsKey (key); }
+	bool isNull () { return getVariant ().isNull (); }
+	size_t size () { return getVariant ().size (); }
+	template <typename T>
+	bool add (T value) { return getVariant ().add (value); }
+	JsonArray createNestedArray (const char* key) { return getVariant ().createNestedArray (key); }
+	JsonObject createNestedObject (const char* key) { return getVariant ().createNestedObject (key); }
+	void remove (const char* key) { getVariant ().remove (key); }
+
+	template <typename T>
+	T as () { return getVariant ().as<T> (); }
+	template <typename T>
+	bool is () { return getVariant ().is<T> (); }
+	template <typename T>
+	T to () {
+		clear ();
+		if (std::is_same<T, JsonArray>::value) {
+			root.type = JSON_ARRAY;
+		} else if (std::is_same<T, JsonObject>::value) {
+			root.type = JSON_OBJECT;
+		}
+		return getVariant ().as<T> ();
+	}
+
+	void clear () {
+		pool.clear ();
+		memset (&root, 0, sizeof (root));
+	}
+	size_t memoryUsage () const { return pool.size (); }
+	size_t capacity () const { return pool.capacity (); }
+	bool overflowed () const { return pool.overflowed (); }
+
+	JsonVariant getVariant () { return JsonVariant (&root, &pool); }
+	const JsonSlot* getRoot () const { return &root; }
+
+protected:
+	JsonDocument (char* buffer, size_t capacity) : pool (buffer, capacity) {
+		memset (&root, 0, sizeof (root));
+	}
+
+	JsonPool pool;
+	JsonSlot root;
+};
+
+class JsonHeapBuffer {
+protected:
+	explicit JsonHeapBuffer (size_t capacity) : heapBuffer ((char*)malloc (capacity ? capacity : 1)) {}
+	~JsonHeapBuffer () {
+		free (heapBuffer);
+	}
+	char* heapBuffer;
+};
+
+class DynamicJsonDocument : private JsonHeapBuffer, public JsonDocument {
+public:
+	explicit DynamicJsonDocument (size_t capacity) : JsonHeapBuffer (capacity), JsonDocument (heapBuffer, capacity) {}
+};
+
+template <size_t N>
+class StaticJsonDocument : public JsonDocument {
+public:
+	StaticJsonDocument () : JsonDocument (buffer, N) {}
+private:
+	alignas (8) char buffer[N];
+};
+
+class DeserializationError {
+public:
+	enum Code {
+		Ok,
+		EmptyInput,
+		IncompleteInput,
+		InvalidInput,
+		NoMemory,
+		NotSupported,
+		TooDeep
+	};
+
+	DeserializationError (Code code = Ok) : _code (code) {}
+	Code code () const { return _code; }
+	const char* c_str () const;
+	explicit operator bool () const { return _code != Ok; }
+	bool operator== (Code code) const { return _code == code; }
+	bool operator!= (Code code) const { return _code != code; }
+	bool operator== (const DeserializationError& other) const { return _code == other._code; }
+	bool operator!= (const DeserializationError& other) const { return _code != other._code; }
+
+private:
+	Code _code;
+};
+
+DeserializationError deserializeJson (JsonDocument& doc, Stream& input);
+DeserializationError deserializeJson (JsonDocument& doc, const char* input);
+DeserializationError deserializeJson (JsonDocument& doc, const char* input, size_t size);
+DeserializationError deserializeMsgPack (JsonDocument& doc, Stream& input);
+DeserializationError deserializeMsgPack (JsonDocument& doc, const uint8_t* input, size_t size);
+inline DeserializationError deserializeMsgPack (JsonDocument& doc, const char* input, size_t size) {
+	return deserializeMsgPack (doc, (const uint8_t*)input, size);
+}
+
+size_t serializeJson (const JsonDocument& doc, char* output, size_t size);
+size_t serializeJson (const JsonDocument& doc, Print& output);
+size_t serializeJsonPretty (const JsonDocument& doc, char* output, size_t size);
+size_t serializeJsonPretty (const JsonDocument& doc, Print& output);
+size_t measureJson (const JsonDocument& doc);
+size_t measureJsonPretty (const JsonDocument& doc);
+
+size_t serializeMsgPack (const JsonDocument& doc, uint8_t* output, size_t size);
+inline size_t serializeMsgPack (const JsonDocument& doc, char* output, size_t size) {
+	return serializeMsgPack (doc, (uint8_t*)output, size);
+}
+size_t serializeMsgPack (const JsonDocument& doc, Print& output);
+size_t measureMsgPack (const JsonDocument& doc);
+
+#endif // _HOST_ARDUINOJSON_h
@@ -0,0 +1,67 @@
+/**
+  * @brief CayenneLPP library stand-in for host builds. Only the data types used by controllers are provided
+  *
+  * @file CayenneLPP.h
+  */
+
+#ifndef _HOST_CAYENNELPP_h
+#define _HOST_CAYENNELPP_h
+
+#include <Arduino.h>
+
+#define LPP_DIGITAL_INPUT 0
+#define LPP_DIGITAL_OUTPUT 1
+#define LPP_ANALOG_INPUT 2
+#define LPP_ANALOG_OUTPUT 3
+
+#define LPP_DIGITAL_INPUT_SIZE 1
+#define LPP_DIGITAL_OUTPUT_SIZE 1
+#define LPP_ANALOG_INPUT_SIZE 2
+#define LPP_ANALOG_OUTPUT_SIZE 2
+
+class CayenneLPP {
+public:
+	CayenneLPP (uint8_t size) : _maxsize (size), _cursor (0) {
+		_buffer = (uint8_t*)malloc (size);
+	}
+	~CayenneLPP () {
+		free (_buffer);
+	}
+
+	void reset () { _cursor = 0; }
+	uint8_t getSize () { return _cursor; }
+	uint8_t* getBuffer () { return _buffer; }
+
+	uint8_t addDigitalInput (uint8_t channel, uint8_t value) {
+		return add (channel, LPP_DIGITAL_INPUT, (uint16_t)value, LPP_DIGITAL_INPUT_SIZE);
+	}
+	uint8_t addDigitalOutput (uint8_t channel, uint8_t value) {
+		return add (channel, LPP_DIGITAL_OUTPUT, (uint16_t)value, LPP_DIGITAL_OUTPUT_SIZE);
+	}
+	uint8_t addAnalogInput (uint8_t channel, float value) {
+		return add (channel, LPP_ANALOG_INPUT, (uint16_t)(int16_t)(value * 100), LPP_ANALOG_INPUT_SIZE);
+	}
+	uint8_t addAnalogOutput (uint8_t channel, float value) {
+		return add (channel, LPP_ANALOG_OUTPUT, (uint16_t)(int16_t)(value * 100), LPP_ANALOG_OUTPUT_SIZE);
+	}
+
+private:
+	uint8_t add (uint8_t channel, uint8_t type, uint16_t value, uint8_t size) {
+		if ((_cursor + size + 2) > _maxsize) {
+			return 0;
+		}
+		_buffer[_cursor++] = channel;
+		_buffer[_cursor++] = type;
+		if (size == 2) {
+			_buffer[_cursor++] = value >> 8;
+		}
+		_buffer[_cursor++] = value;
+		return _cursor;
+	}
+
+	uint8_t* _buffer;
+	uint8_t _maxsize;
+	uint8_t _cursor;
+};
+
+#endif // _HOST_CAYENNELPP_h
@@ -0,0 +1,102 @@
+/**
+  * @brief DebounceEvent library stand-in for host builds
+  *
+  * Mirrors the polling behaviour of the original library, including the blocking debounce
+  * delay, on top of the simulated clock and GPIO.
+  *
+  * @file DebounceEvent.h
+  */
+
+#ifndef _HOST_DEBOUNCE_EVENT_h
+#define _HOST_DEBOUNCE_EVENT_h
+
+#include <Arduino.h>
+#include <functional>
+
+#define BUTTON_PUSHBUTTON       0
+#define BUTTON_SWITCH           1
+#define BUTTON_DEFAULT_HIGH     2
+#define BUTTON_SET_PULLUP       4
+
+#define EVENT_NONE              0
+#define EVENT_CHANGED           1
+#define EVENT_PRESSED           2
+#define EVENT_RELEASED          3
+
+#define DEBOUNCE_DELAY          50
+#define REPEAT_DELAY            500
+
+typedef std::function<void (uint8_t pin, uint8_t event, uint8_t count, uint16_t length)> TDebounceEventCallback;
+
+class DebounceEvent {
+public:
+	DebounceEvent (uint8_t pin, TDebounceEventCallback callback, uint8_t mode = BUTTON_PUSHBUTTON | BUTTON_DEFAULT_HIGH, unsigned long delay = DEBOUNCE_DELAY, unsigned long repeat = REPEAT_DELAY)
+		: _pin (pin), _mode (mode & 0x01), _delay (delay), _repeat (repeat), _callback (callback) {
+		_defaultStatus = ((mode & BUTTON_DEFAULT_HIGH) > 0);
+		_status = _defaultStatus;
+		pinMode (_pin, (mode & BUTTON_SET_PULLUP) ? INPUT_PULLUP : INPUT);
+		hostSetPinInput (_pin, _defaultStatus ? HIGH : LOW);
+	}
+
+	unsigned char loop () {
+		unsigned char event = EVENT_NONE;
+
+		if ((bool)digitalRead (_pin) != _status) {
+			unsigned long start = millis ();
+			while (millis () - start < _delay) delay (1);
+
+			if ((bool)digitalRead (_pin) != _status) {
+				_status = !_status;
+				if (_mode == BUTTON_SWITCH) {
+					event = EVENT_CHANGED;
+				} else if (_status == _defaultStatus) { // released
+					_event_length = millis () - _event_start;
+					_ready = true;
+				} else { // pressed
+					event = EVENT_PRESSED;
+					_event_start = millis ();
+					_event_length = 0;
+					if (_reset_count) {
+						_event_count = 1;
+						_reset_count = false;
+					} else {
+						++_event_count;
+					}
+					_ready = false;
+				}
+			}
+		}
+
+		if (_ready && (millis () - _event_start > _repeat)) {
+			_ready = false;
+			_reset_count = true;
+			event = EVENT_RELEASED;
+		}
+
+		if (event != EVENT_NONE && _callback) {
+			_callback (_pin, event, _event_count, _event_length);
+		}
+		return event;
+	}
+
+	bool pressed () { return (_status != _defaultStatus); }
+	unsigned long getEventLength () { return _event_length; }
+	unsigned long getEventCount () { return _event_count; }
+
+private:
+	uint8_t _pin;
+	uint8_t _mode;
+	bool _status;
+	bool _defaultStatus;
+	unsigned long _delay;
+	unsigned long _repeat;
+	TDebounceEventCallback _callback;
+
+	unsigned long _event_start = 0;
+	unsigned long _event_length = 0;
+	unsigned char _event_count = 0;
+	bool _ready = false;
+	bool _reset_count = true;
+};
+
+#endif // _HOST_DEBOUNCE_EVENT_h
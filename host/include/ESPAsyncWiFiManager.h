@@ -0,0 +1,42 @@
+/**
+  * @brief ESPAsyncWiFiManager stand-in for host builds. Only configuration parameters are provided
+  *
+  * @file ESPAsyncWiFiManager.h
+  */
+
+#ifndef _HOST_ESPASYNCWIFIMANAGER_h
+#define _HOST_ESPASYNCWIFIMANAGER_h
+
+#include <Arduino.h>
+
+class AsyncWiFiManagerParameter {
+public:
+	AsyncWiFiManagerParameter (const char* id, const char* placeholder, const char* defaultValue, int length, const char* custom = "")
+		: _id (id), _placeholder (placeholder), _length (length), _customHTML (custom) {
+		_value = new char[length + 1];
+		memset (_value, 0, length + 1);
+		if (defaultValue) {
+			snprintf (_value, length + 1, "%s", defaultValue);
+		}
+	}
+	~AsyncWiFiManagerParameter () {
+		delete[] _value;
+	}
+	const char* getID () { return _id; }
+	const char* getValue () { return _value; }
+	const char* getPlaceholder () { return _placeholder; }
+	int getValueLength () { return _length; }
+	const char* getCustomHTML () { return _customHTML; }
+
+	// ---- Host simulation controls ----
+	void hostSetValue (const char* value) { strncpy (_value, value, _length); }
+
+private:
+	const char* _id;
+	const char* _placeholder;
+	char* _value;
+	int _length;
+	const char* _customHTML;
+};
+
+#endif // _HOST_ESPASYNCWIFIMANAGER_h
@@ -0,0 +1,111 @@
+/**
+  * @brief EnigmaIOT node stand-in for host builds
+  *
+  * Only the types, constants and node methods used by controllers are provided.
+  * Uplink data is delivered to an optional transport hook instead of a radio.
+  *
+  * @file EnigmaIOTNode.h
+  */
+
+#ifndef _HOST_ENIGMAIOTNODE_h
+#define _HOST_ENIGMAIOTNODE_h
+
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+
+#define ENIGMAIOT_ADDR_LEN 6
+#define MAX_MESSAGE_LENGTH 250
+
+static const uint8_t ENIGMAIOT_PROT_VERS[] = { 0, 9, 3 };
+
+enum nodeMessageType {
+	SENSOR_DATA = 0x01,
+	UNENCRYPTED_NODE_DATA = 0x11,
+	DOWNSTREAM_DATA_SET = 0x12,
+	DOWNSTREAM_DATA_GET = 0x13,
+	CONTROL_DATA = 0x03,
+	DOWNSTREAM_CTRL_DATA = 0x04,
+	CLOCK_REQUEST = 0x05,
+	CLOCK_RESPONSE = 0x06,
+	NODE_NAME_SET = 0x07,
+	NODE_NAME_RESULT = 0x17,
+	BROADCAST_KEY_REQUEST = 0x08,
+	BROADCAST_KEY_RESPONSE = 0x18,
+	HA_DISC_MESSAGE = 0x14
+};
+
+typedef enum nodeMessageType nodeMessageType_t;
+
+typedef enum {
+	RAW = 0x00,
+	CAYENNELPP = 0x81,
+	PROT_BUF = 0x82,
+	MSG_PACK = 0x83,
+	BSON = 0x84,
+	CBOR = 0x85,
+	SMILE = 0x86,
+	ENIGMAIOT = 0xFF
+} nodePayloadEncoding_t;
+
+typedef enum {
+	UNKNOWN_ERROR = 0x00,
+	WRONG_CLIENT_HELLO = 0x01
+} nodeInvalidateReason_t;
+
+class AsyncWiFiManagerParameter;
+
+typedef std::function<bool (const uint8_t* data, size_t len, nodePayloadEncoding_t payloadEncoding)> hostTransport_cb;
+
+class EnigmaIOTNodeClass {
+public:
+	void handle () {}
+	bool sendData (const uint8_t* data, size_t len, nodePayloadEncoding_t payloadEncoding) {
+		return transport ? transport (data, len, payloadEncoding) : false;
+	}
+	bool setNodeAddress (uint8_t address[ENIGMAIOT_ADDR_LEN]) {
+		memcpy (nodeAddress, address, ENIGMAIOT_ADDR_LEN);
+		return true;
+	}
+	const uint8_t* getNodeAddress () const {
+		return nodeAddress;
+	}
+	void enableClockSync (bool clockSync = true) {
+		clockSyncEnabled = clockSync;
+	}
+	void enableBroadcast (bool broadcast = true) {
+		broadcastEnabled = broadcast;
+	}
+	bool hasClockSync () {
+		return clockSyncEnabled;
+	}
+	int64_t clock () {
+		return (int64_t)millis () + clockOffset;
+	}
+	bool addWiFiManagerParameter (AsyncWiFiManagerParameter* p) {
+		return p != nullptr;
+	}
+
+	// ---- Host simulation controls ----
+	void hostSetTransport (hostTransport_cb cb) { transport = cb; }
+	void hostSetClockOffset (int64_t offset) { clockOffset = offset; }
+
+private:
+	uint8_t nodeAddress[ENIGMAIOT_ADDR_LEN] = { 0 };
+	bool clockSyncEnabled = true;
+	bool broadcastEnabled = false;
+	int64_t clockOffset = 0;
+	hostTransport_cb transport;
+};
+
+extern EnigmaIOTNodeClass EnigmaIOTNode;
+
+inline char* mac2str (const uint8_t* mac, char* buffer) {
+	if (mac && buffer) {
+		snprintf (buffer, ENIGMAIOT_ADDR_LEN * 3, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+		return buffer;
+	}
+	return NULL;
+}
+
+#endif // _HOST_ENIGMAIOTNODE_h
@@ -0,0 +1,62 @@
+/**
+  * @brief EnigmaIOT JSON controller base class stand-in for host builds
+  *
+  * `sendJson` follows the library implementation: the document is serialized into a heap buffer
+  * as MsgPack and handed to the data callback registered with `sendDataCallback`.
+  *
+  * @file EnigmaIOTjsonController.h
+  */
+
+#ifndef _HOST_ENIGMAIOTJSONCONTROLLER_h
+#define _HOST_ENIGMAIOTJSONCONTROLLER_h
+
+#include <Arduino.h>
+#include <EnigmaIOTNode.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWiFiManager.h>
+
+typedef std::function<bool (const uint8_t* data, size_t len, nodePayloadEncoding_t payloadEncoding)> sendData_cb;
+
+class EnigmaIOTjsonController {
+protected:
+	EnigmaIOTNodeClass* enigmaIotNode;
+	sendData_cb sendData;
+
+public:
+	virtual ~EnigmaIOTjsonController () {}
+	virtual void setup (EnigmaIOTNodeClass* node, void* data = NULL) = 0;
+	virtual void loop () = 0;
+	virtual bool processRxCommand (const uint8_t* mac, const uint8_t* buffer, uint8_t length, nodeMessageType_t command, nodePayloadEncoding_t payloadEncoding) = 0;
+	virtual void configManagerStart () = 0;
+	virtual void configManagerExit (bool status) = 0;
+	virtual bool loadConfig () = 0;
+	virtual void connectInform () {}
+
+	void sendDataCallback (sendData_cb cb) {
+		sendData = cb;
+	}
+
+protected:
+	virtual bool saveConfig () = 0;
+
+	bool sendJson (DynamicJsonDocument& json) {
+		int len = measureMsgPack (json) + 1;
+		uint8_t* buffer = (uint8_t*)malloc (len);
+		len = serializeMsgPack (json, (char*)buffer, len);
+
+		size_t strLen = measureJson (json) + 1;
+		char* strBuffer = (char*)malloc (strLen);
+		serializeJson (json, strBuffer, strLen);
+
+		bool result = false;
+		if (sendData) {
+			result = sendData (buffer, len, MSG_PACK);
+		}
+
+		free (buffer);
+		free (strBuffer);
+		return result;
+	}
+};
+
+#endif // _HOST_ENIGMAIOTJSONCONTROLLER_h
@@ -0,0 +1,89 @@
+/**
+  * @brief In-memory SPIFFS stand-in for host builds
+  *
+  * @file FS.h
+  */
+
+#ifndef _HOST_FS_h
+#define _HOST_FS_h
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+typedef std::vector<uint8_t> FileData;
+
+class File : public Stream {
+public:
+	File () : data (nullptr), pos (0), writable (false) {}
+	File (FileData* data, bool writable) : data (data), pos (0), writable (writable) {}
+
+	size_t write (uint8_t c) override {
+		return write (&c, 1);
+	}
+	size_t write (const uint8_t* buffer, size_t size) override;
+	int available () override {
+		return data ? (int)(data->size () - pos) : 0;
+	}
+	int read () override {
+		return available () > 0 ? (*data)[pos++] : -1;
+	}
+	int peek () override {
+		return available () > 0 ? (*data)[pos] : -1;
+	}
+	size_t read (uint8_t* buffer, size_t size) {
+		return readBytes (buffer, size);
+	}
+	bool seek (uint32_t position) {
+		if (!data || position > data->size ()) {
+			return false;
+		}
+		pos = position;
+		return true;
+	}
+	size_t position () const { return pos; }
+	size_t size () const { return data ? data->size () : 0; }
+	void flush () {}
+	void close () { data = nullptr; }
+	operator bool () const { return data != nullptr; }
+	using Print::write;
+
+private:
+	FileData* data;
+	size_t pos;
+	bool writable;
+};
+
+class FS {
+public:
+	bool begin ();
+	void end () { mounted = false; }
+	bool format ();
+	bool exists (const char* path);
+	File open (const char* path, const char* mode);
+	bool remove (const char* path);
+	bool rename (const char* pathFrom, const char* pathTo);
+
+	// ---- Host simulation controls ----
+	void hostSetMountFails (bool fails) { mountFails = fails; }
+	unsigned long hostFormatCount () const { return formats; }
+	FileData* hostFile (const char* path);
+
+private:
+	std::map<std::string, FileData> files;
+	bool mounted = false;
+	bool mountFails = false;
+	unsigned long formats = 0;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
+
+extern fs::FS SPIFFS;
+
+#endif // _HOST_FS_h
@@ -0,0 +1,51 @@
+/**
+  * @brief Ticker library stand-in for host builds
+  *
+  * Timers run on the simulated clock. Callbacks are called from `hostAdvanceMillis`, `hostSetMillis` and
+  * `delay` with `millis ()` set to their exact deadline, so code that relies on them being punctual may be tested.
+  *
+  * @file Ticker.h
+  */
+
+#ifndef _HOST_TICKER_h
+#define _HOST_TICKER_h
+
+#include <Arduino.h>
+
+class Ticker {
+public:
+	typedef void (*callback_t) (void* arg);
+
+	Ticker ();
+	~Ticker ();
+
+	template <typename TArg>
+	void once_ms (uint32_t milliseconds, void (*callback) (TArg), TArg arg) {
+		attach (milliseconds, (callback_t)callback, (void*)arg);
+	}
+
+	void detach () {
+		armed = false;
+	}
+
+	bool active () const {
+		return armed;
+	}
+
+	/**
+	  * @brief Runs every timer whose deadline is not after `targetMicros`, in deadline order
+	  */
+	static void runDue (unsigned long& simulatedMicros, unsigned long targetMicros);
+
+protected:
+	callback_t callback = nullptr;
+	void* arg = nullptr;
+	unsigned long deadline = 0; ///< @brief Simulated time in us
+	bool armed = false;
+	Ticker* next; ///< @brief Every existing timer is linked on a list
+	static Ticker* first;
+
+	void attach (uint32_t milliseconds, callback_t cb, void* cbArg);
+};
+
+#endif
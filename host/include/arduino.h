@@ -0,0 +1,2 @@
+// Lower case alias. BlindController.h includes "arduino.h", which only resolves on case insensitive filesystems
+#include "Arduino.h"
@@ -0,0 +1,460 @@
+/**
+  * @brief Discrete event simulation of a fleet of blind controllers on a Linux host
+  *
+  * Every blind is a `BlindController` instance with its own relay pins. Simulated time jumps from one
+  * deadline to the next, so a day of a whole building runs in seconds. Relay writes drive a motor model
+  * whose travel time differs slightly from configured one, and uplink messages go to an in-process gateway
+  * that counts them. Report shows message rates, bytes on air and error between position calculated by
+  * controller and actual blind position every time a blind stops.
+  *
+  * Usage: blind_fleet [--quick] [--blinds <n>] [--hours <h>] [--rate <commands per blind and hour>]
+  *                    [--broadcast <minutes>] [--workload <file>] [--travel <ms>] [--spread <%>]
+  *                    [--start-delay <ms>] [--run-on <ms>] [--uncompensated] [--report-step <%>]
+  *                    [--report-min <ms>] [--report-max <ms>] [--merged] [--loss <%>] [--overhead <bytes>] [--seed <n>]
+  *
+  * Workload file has one command per line: `<time in ms> <blind number or *> <JSON command>`. `*` sends
+  * command to every blind at the same time, as a broadcast does. Lines starting with `#` are ignored.
+  *
+  * @file FleetSimulator.cpp
+  */
+
+#include <BlindController.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const uint16_t PIN_BASE = 100; ///< @brief Blind `n` uses pins `PIN_BASE + 2n` (up) and `PIN_BASE + 2n + 1` (down)
+static const uint16_t MAX_BLINDS = (16384 - PIN_BASE) / 2;
+static const unsigned long START_TIME = 1000; ///< @brief Simulated `millis ()` when simulation starts
+static const int SAME_TIME_LOOPS = 8; ///< @brief `loop` calls allowed on the same ms before forcing time to go on
+static const unsigned long AIR_SLOT = 10; ///< @brief Frames closer than this, in ms, are likely to collide at gateway
+
+class SimController : public BlindController {
+public:
+	using BlindController::getPosition;
+	using BlindController::getState;
+
+	clock_t wakeTime () {
+		return nextTask;
+	}
+
+	void setSendData (sendData_cb cb) {
+		((::EnigmaIOTjsonController*)this)->sendDataCallback (cb);
+	}
+
+	// Uses default configuration with timing of hardware data, as it would come from a configuration file
+	void begin (blindControlerHw_t* hw) {
+		defaultConfig ();
+		channelConfig[0].fullTravellingTime = hw->fullTravellingTime;
+		setup (&EnigmaIOTNode, hw);
+	}
+};
+
+/**
+  * @brief Actual blind movement as result of relay writes
+  */
+struct motor_t {
+	double position; ///< @brief Linear position 0-100 when relay was last switched
+	int direction; ///< @brief 1 rolling up, -1 rolling down, 0 relays off
+	unsigned long relayOn; ///< @brief Time when relay was switched on
+	double upTime; ///< @brief Actual full travel time, in ms
+	double downTime;
+	bool settling; ///< @brief Relay was switched off and controller has not reported stop yet
+};
+
+struct options_t {
+	int blinds = 500;
+	double hours = 24;
+	double rate = 2; ///< @brief Go commands per blind and hour
+	double broadcastMinutes = 0; ///< @brief Period of full up / full down broadcasts. 0 for none
+	const char* workload = nullptr;
+	int travel = 30000;
+	double spread = 2; ///< @brief Maximum difference between actual and configured travel time, in %
+	int startDelay = 300;
+	int runOn = 200;
+	bool compensated = true; ///< @brief Configure controller with actual start delay and run on time
+	bool merged = false; ///< @brief Command responses carry resulting state
+	int reportStep = 20;
+	int reportMin = 2000;
+	int reportMax = 600000;
+	double loss = 0; ///< @brief Probability of a failed send, in %
+	int overhead = 32; ///< @brief EnigmaIOT header and authentication tag added to every payload
+	unsigned seed = 1;
+};
+
+struct command_t {
+	unsigned long time;
+	int blind; ///< @brief -1 for every blind
+	std::vector<uint8_t> payload; ///< @brief MsgPack encoded command
+	nodeMessageType_t type;
+};
+
+static options_t options;
+static std::vector<SimController*> fleet;
+static std::vector<motor_t> motors;
+static std::mt19937 rng;
+
+// Gateway counters
+static unsigned long frames;
+static unsigned long payloadBytes;
+static unsigned long failedSends;
+static std::vector<unsigned long> framesPerSecond;
+static std::vector<unsigned long> frameSlots; ///< @brief `AIR_SLOT` number of every delivered frame, in order
+static std::vector<double> positionErrors;
+
+static void onRelayWrite (uint16_t pin, uint8_t val) {
+	if (pin < PIN_BASE || pin >= PIN_BASE + 2 * motors.size ()) {
+		return;
+	}
+	motor_t& motor = motors[(pin - PIN_BASE) / 2];
+	int direction = (pin - PIN_BASE) % 2 ? -1 : 1;
+	unsigned long now = millis ();
+
+	if (val == HIGH && motor.direction != direction) {
+		motor.direction = direction;
+		motor.relayOn = now;
+	} else if (val == LOW && motor.direction == direction) {
+		// Motor starts after start delay and keeps moving during run on time
+		double moving = (double)now + options.runOn - (motor.relayOn + options.startDelay);
+		if (moving > 0) {
+			motor.position += direction * moving * 100 / (direction > 0 ? motor.upTime : motor.downTime);
+			motor.position = std::min (100.0, std::max (0.0, motor.position));
+		}
+		motor.direction = 0;
+		motor.settling = true;
+	}
+}
+
+static bool deliver (int, const uint8_t*, size_t length) {
+	if (options.loss > 0 && std::uniform_real_distribution<double> (0, 100) (rng) < options.loss) {
+		failedSends++;
+		return false;
+	}
+	frames++;
+	payloadBytes += length;
+	unsigned long second = (millis () - START_TIME) / 1000;
+	if (second < framesPerSecond.size ()) {
+		framesPerSecond[second]++;
+	}
+	frameSlots.push_back ((millis () - START_TIME) / AIR_SLOT);
+	return true;
+}
+
+static std::vector<uint8_t> encodeJson (const std::string& json) {
+	DynamicJsonDocument doc (1024);
+	if (deserializeJson (doc, json.c_str ())) {
+		return std::vector<uint8_t> ();
+	}
+	std::vector<uint8_t> buffer (measureMsgPack (doc));
+	serializeMsgPack (doc, buffer.data (), buffer.size ());
+	return buffer;
+}
+
+static command_t makeCommand (unsigned long time, int blind, const std::string& json, nodeMessageType_t type = DOWNSTREAM_DATA_SET) {
+	command_t command;
+	command.time = time;
+	command.blind = blind;
+	command.payload = encodeJson (json);
+	command.type = type;
+	return command;
+}
+
+static bool loadWorkload (const char* fileName, std::vector<command_t>& commands) {
+	std::ifstream file (fileName);
+	if (!file) {
+		fprintf (stderr, "Cannot open %s\n", fileName);
+		return false;
+	}
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline (file, line)) {
+		lineNumber++;
+		if (line.empty () || line[0] == '#') {
+			continue;
+		}
+		std::istringstream fields (line);
+		unsigned long time;
+		std::string target, json;
+		if (!(fields >> time >> target) || !std::getline (fields >> std::ws, json)) {
+			fprintf (stderr, "%s:%d: wrong line\n", fileName, lineNumber);
+			return false;
+		}
+		int blind = target == "*" ? -1 : atoi (target.c_str ());
+		command_t command = makeCommand (START_TIME + time, blind, json);
+		if (command.payload.empty () || blind >= options.blinds) {
+			fprintf (stderr, "%s:%d: wrong command\n", fileName, lineNumber);
+			return false;
+		}
+		commands.push_back (command);
+	}
+	return true;
+}
+
+static void generateWorkload (unsigned long end, std::vector<command_t>& commands) {
+	// Every blind is calibrated first, as installer would do
+	commands.push_back (makeCommand (START_TIME, -1, "{\"cmd\":\"dd\",\"grp\":0}"));
+	unsigned long start = START_TIME + (unsigned long)(options.travel * 1.2);
+
+	if (options.rate > 0) {
+		std::exponential_distribution<double> interval (options.rate / 3600000.0);
+		std::uniform_int_distribution<int> position (0, 100);
+		for (int blind = 0; blind < options.blinds; blind++) {
+			for (double time = start + interval (rng); time < end; time += interval (rng)) {
+				char json[40];
+				snprintf (json, sizeof (json), "{\"cmd\":\"go\",\"pos\":%d}", position (rng));
+				commands.push_back (makeCommand ((unsigned long)time, blind, json));
+			}
+		}
+	}
+
+	if (options.broadcastMinutes > 0) {
+		bool up = true;
+		for (double time = start; time < end; time += options.broadcastMinutes * 60000) {
+			commands.push_back (makeCommand ((unsigned long)time, -1, up ? "{\"cmd\":\"uu\",\"grp\":0}" : "{\"cmd\":\"dd\",\"grp\":0}"));
+			up = !up;
+		}
+	}
+}
+
+static void createFleet () {
+	std::uniform_real_distribution<double> spread (-options.spread / 100, options.spread / 100);
+	motors.resize (options.blinds);
+	fleet.resize (options.blinds);
+	for (int blind = 0; blind < options.blinds; blind++) {
+		motor_t& motor = motors[blind];
+		motor.position = std::uniform_real_distribution<double> (0, 100) (rng);
+		motor.upTime = options.travel * (1 + spread (rng));
+		motor.downTime = options.travel * (1 + spread (rng));
+
+		blindControlerHw_t hw;
+		memset (&hw, 0, sizeof (hw));
+		hw.upRelayPin = PIN_BASE + 2 * blind;
+		hw.downRelayPin = PIN_BASE + 2 * blind + 1;
+		hw.upButton = NO_BUTTON;
+		hw.downButton = NO_BUTTON;
+		hw.fullTravellingTime = options.travel;
+		hw.startDelay = options.compensated ? options.startDelay : 0;
+		hw.runOnTime = options.compensated ? options.runOn : 0;
+		hw.ON_STATE = HIGH;
+		hw.curveProfile = CURVE_LINEAR;
+		hw.reportStep = options.reportStep;
+		hw.reportMinInterval = options.reportMin;
+		hw.reportMaxInterval = options.reportMax;
+		hw.mergedResponse = options.merged;
+
+		SimController* controller = new SimController ();
+		controller->setSendData ([blind] (const uint8_t* data, size_t length, nodePayloadEncoding_t) {
+			return deliver (blind, data, length);
+		});
+		hostClearRtcMemory (); // Every blind boots without a stored position
+		uint8_t address[ENIGMAIOT_ADDR_LEN] = { 0x5C, 0xCF, 0x7F, 0, (uint8_t)(blind >> 8), (uint8_t)blind };
+		EnigmaIOTNode.setNodeAddress (address); // Every blind is a different node
+		controller->begin (&hw);
+		fleet[blind] = controller;
+	}
+}
+
+static double percentile (std::vector<double>& values, double p) {
+	if (values.empty ()) {
+		return 0;
+	}
+	size_t index = std::min (values.size () - 1, (size_t)(p / 100 * values.size ()));
+	return values[index];
+}
+
+static void report (double wallSeconds, size_t commandCount) {
+	double seconds = options.hours * 3600;
+	unsigned long peak = framesPerSecond.empty () ? 0 : *std::max_element (framesPerSecond.begin (), framesPerSecond.end ());
+	unsigned long airBytes = payloadBytes + frames * options.overhead;
+
+	printf ("Simulated %d blinds for %.1f h in %.2f s (%.0fx real time)\n", options.blinds, options.hours, wallSeconds, seconds / wallSeconds);
+	printf ("Commands:          %zu\n", commandCount);
+	printf ("Uplink frames:     %lu. %.3f/s average, %lu in busiest second\n", frames, frames / seconds, peak);
+	size_t crowded = 0;
+	for (size_t i = 0; i < frameSlots.size (); i++) {
+		if ((i > 0 && frameSlots[i - 1] == frameSlots[i]) || (i + 1 < frameSlots.size () && frameSlots[i + 1] == frameSlots[i])) {
+			crowded++;
+		}
+	}
+	printf ("Crowded frames:    %zu (%.1f %%) share a %lu ms slot with other frames\n", crowded, frames ? 100.0 * crowded / frames : 0, AIR_SLOT);
+	printf ("Failed sends:      %lu\n", failedSends);
+	printf ("Bytes on air:      %lu (%.1f B/s). Payload %lu, overhead %d per frame\n", airBytes, airBytes / seconds, payloadBytes, options.overhead);
+
+	std::vector<double> absErrors;
+	double sum = 0;
+	for (double error : positionErrors) {
+		absErrors.push_back (fabs (error));
+		sum += error;
+	}
+	std::sort (absErrors.begin (), absErrors.end ());
+	printf ("Position error:    %zu stops. Mean %+.2f %%, |error| p50 %.2f %%, p95 %.2f %%, max %.2f %%\n", absErrors.size (),
+			absErrors.empty () ? 0 : sum / absErrors.size (), percentile (absErrors, 50), percentile (absErrors, 95),
+			absErrors.empty () ? 0 : absErrors.back ());
+
+	static const double limits[] = { 1, 2, 5, 10 };
+	size_t below = 0;
+	for (double limit : limits) {
+		size_t count = std::lower_bound (absErrors.begin (), absErrors.end (), limit) - absErrors.begin ();
+		printf ("  |error| < %4.0f %%: %5.1f %%\n", limit, absErrors.empty () ? 0 : 100.0 * count / absErrors.size ());
+		below = count;
+	}
+	printf ("  |error| >= %3.0f %%: %5.1f %%\n", limits[3], absErrors.empty () ? 0 : 100.0 * (absErrors.size () - below) / absErrors.size ());
+}
+
+static int usage (const char* name) {
+	fprintf (stderr, "Usage: %s [--quick] [--blinds <n>] [--hours <h>] [--rate <commands per blind and hour>]\n"
+			 "       [--broadcast <minutes>] [--workload <file>] [--travel <ms>] [--spread <%%>]\n"
+			 "       [--start-delay <ms>] [--run-on <ms>] [--uncompensated] [--report-step <%%>]\n"
+			 "       [--report-min <ms>] [--report-max <ms>] [--merged] [--loss <%%>] [--overhead <bytes>] [--seed <n>]\n", name);
+	return 2;
+}
+
+int main (int argc, char** argv) {
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!strcmp (arg, "--quick")) {
+			options.blinds = 20;
+			options.hours = 1;
+			options.rate = 10;
+			continue;
+		} else if (!strcmp (arg, "--uncompensated")) {
+			options.compensated = false;
+			continue;
+		} else if (!strcmp (arg, "--merged")) {
+			options.merged = true;
+			continue;
+		} else if (!value) {
+			return usage (argv[0]);
+		} else if (!strcmp (arg, "--blinds")) {
+			options.blinds = atoi (value);
+		} else if (!strcmp (arg, "--hours")) {
+			options.hours = atof (value);
+		} else if (!strcmp (arg, "--rate")) {
+			options.rate = atof (value);
+		} else if (!strcmp (arg, "--broadcast")) {
+			options.broadcastMinutes = atof (value);
+		} else if (!strcmp (arg, "--workload")) {
+			options.workload = value;
+		} else if (!strcmp (arg, "--travel")) {
+			options.travel = atoi (value);
+		} else if (!strcmp (arg, "--spread")) {
+			options.spread = atof (value);
+		} else if (!strcmp (arg, "--start-delay")) {
+			options.startDelay = atoi (value);
+		} else if (!strcmp (arg, "--run-on")) {
+			options.runOn = atoi (value);
+		} else if (!strcmp (arg, "--report-step")) {
+			options.reportStep = atoi (value);
+		} else if (!strcmp (arg, "--report-min")) {
+			options.reportMin = atoi (value);
+		} else if (!strcmp (arg, "--report-max")) {
+			options.reportMax = atoi (value);
+		} else if (!strcmp (arg, "--loss")) {
+			options.loss = atof (value);
+		} else if (!strcmp (arg, "--overhead")) {
+			options.overhead = atoi (value);
+		} else if (!strcmp (arg, "--seed")) {
+			options.seed = atoi (value);
+		} else {
+			return usage (argv[0]);
+		}
+		i++;
+	}
+	if (options.blinds < 1 || options.blinds > MAX_BLINDS || options.hours <= 0 || options.travel <= 0) {
+		return usage (argv[0]);
+	}
+
+	rng.seed (options.seed);
+	hostSetMillis (START_TIME);
+	hostOnDigitalWrite (onRelayWrite);
+	createFleet ();
+
+	unsigned long end = START_TIME + (unsigned long)(options.hours * 3600000);
+	framesPerSecond.assign ((size_t)(options.hours * 3600) + 1, 0);
+	std::vector<command_t> commands;
+	if (options.workload ? !loadWorkload (options.workload, commands) : (generateWorkload (end, commands), false)) {
+		return 1;
+	}
+	std::stable_sort (commands.begin (), commands.end (), [] (const command_t& a, const command_t& b) {
+		return a.time < b.time;
+	});
+
+	// Next loop call of every blind. Entries made outdated by a command are skipped when popped
+	typedef std::pair<unsigned long, int> wake_t;
+	std::priority_queue<wake_t, std::vector<wake_t>, std::greater<wake_t>> wakeups;
+	for (int blind = 0; blind < options.blinds; blind++) {
+		wakeups.push (wake_t (START_TIME, blind));
+	}
+	std::vector<unsigned long> lastLoop (options.blinds, 0);
+	std::vector<int> sameTimeLoops (options.blinds, 0);
+
+	auto schedule = [&] (int blind) {
+		unsigned long now = millis ();
+		unsigned long wake = fleet[blind]->wakeTime ();
+		if ((long)(wake - now) <= 0) {
+			wake = sameTimeLoops[blind] < SAME_TIME_LOOPS ? now : now + 1;
+		}
+		wakeups.push (wake_t (wake, blind));
+	};
+
+	auto started = std::chrono::steady_clock::now ();
+	size_t nextCommand = 0;
+	while (!wakeups.empty ()) {
+		bool commandDue = nextCommand < commands.size () && commands[nextCommand].time <= wakeups.top ().first;
+		unsigned long time = commandDue ? commands[nextCommand].time : wakeups.top ().first;
+		if (time >= end) {
+			break;
+		}
+		if (time > millis ()) {
+			hostSetMillis (time); // Relay timers run on their exact deadlines
+		}
+
+		if (commandDue) {
+			const command_t& command = commands[nextCommand++];
+			for (int blind = command.blind < 0 ? 0 : command.blind; blind < options.blinds; blind++) {
+				fleet[blind]->processRxCommand (nullptr, command.payload.data (), command.payload.size (), command.type, MSG_PACK);
+				schedule (blind);
+				if (command.blind >= 0) {
+					break;
+				}
+			}
+			continue;
+		}
+
+		int blind = wakeups.top ().second;
+		unsigned long wake = wakeups.top ().first;
+		wakeups.pop ();
+		SimController* controller = fleet[blind];
+		unsigned long expected = (long)(controller->wakeTime () - millis ()) <= 0 ? millis () : controller->wakeTime ();
+		if (wake != expected && !(wake == millis () + 1 && sameTimeLoops[blind] >= SAME_TIME_LOOPS)) {
+			continue; // Outdated entry
+		}
+
+		sameTimeLoops[blind] = lastLoop[blind] == millis () ? sameTimeLoops[blind] + 1 : 0;
+		lastLoop[blind] = millis ();
+		controller->loop ();
+
+		motor_t& motor = motors[blind];
+		if (motor.settling && controller->getState () == stopped) {
+			motor.settling = false;
+			if (controller->getPosition () != -1) {
+				positionErrors.push_back (controller->getPosition () - motor.position);
+			}
+		}
+		schedule (blind);
+	}
+	if (millis () < end) {
+		hostSetMillis (end);
+	}
+	double wallSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - started).count ();
+
+	report (wallSeconds, commands.size ());
+	return 0;
+}
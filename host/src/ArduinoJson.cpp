@@ -0,0 +1,1011 @@
+/**
+  * @brief Reduced ArduinoJson 6 stand-in for host builds. Serializers and parsers
+  *
+  * @file ArduinoJson.cpp
+  */
+
+#include <ArduinoJson.h>
+#include <ctype.h>
+
+static const int JSON_NESTING_LIMIT = 10;
+
+// ---- Pool ----
+
+JsonSlot* JsonPool::allocSlot () {
+	uintptr_t p = ((uintptr_t)left + alignof (JsonSlot) - 1) & ~(uintptr_t)(alignof (JsonSlot) - 1);
+	if ((char*)p + JSON_SLOT_SIZE > right) {
+		overflow = true;
+		return nullptr;
+	}
+	left = (char*)p + JSON_SLOT_SIZE;
+	JsonSlot* slot = (JsonSlot*)p;
+	memset (slot, 0, sizeof (JsonSlot));
+	return slot;
+}
+
+const char* JsonPool::saveString (const char* str, size_t len) {
+	if (left + len + 1 > right) {
+		overflow = true;
+		return nullptr;
+	}
+	right -= len + 1;
+	memcpy (right, str, len);
+	right[len] = '\0';
+	return right;
+}
+
+// ---- Variant ----
+
+bool JsonVariant::set (bool value) {
+	if (!slot) return false;
+	slot->type = JSON_BOOL;
+	slot->value.asBool = value;
+	return true;
+}
+
+bool JsonVariant::set (const char* value) {
+	if (!slot) return false;
+	if (!value) {
+		slot->type = JSON_NULL;
+		return true;
+	}
+	slot->type = JSON_STRING;
+	slot->value.asString = value;
+	return true;
+}
+
+bool JsonVariant::set (char* value) {
+	if (!slot) return false;
+	if (!value) {
+		slot->type = JSON_NULL;
+		return true;
+	}
+	const char* copy = pool->saveString (value, strlen (value));
+	if (!copy) {
+		slot->type = JSON_NULL;
+		return false;
+	}
+	slot->type = JSON_STRING;
+	slot->value.asString = copy;
+	return true;
+}
+
+bool JsonVariant::set (const String& value) {
+	return set ((char*)value.c_str ());
+}
+
+bool JsonVariant::set (std::nullptr_t) {
+	if (!slot) return false;
+	slot->type = JSON_NULL;
+	return true;
+}
+
+bool JsonVariant::set (JsonVariant value) {
+	if (!slot) return false;
+	JsonSlot* src = value.slot;
+	if (!src) {
+		slot->type = JSON_NULL;
+		return true;
+	}
+	switch (src->type) {
+	case JSON_STRING:
+		return set ((char*)src->value.asString);
+	case JSON_ARRAY:
+	case JSON_OBJECT:
+		slot->type = src->type;
+		slot->value.asCollection.head = nullptr;
+		slot->value.asCollection.tail = nullptr;
+		for (JsonSlot* child = src->value.asCollection.head; child; child = child->next) {
+			JsonVariant dst = src->type == JSON_ARRAY ? addElement () : getOrAddMember (child->key, true);
+			if (!dst.set (JsonVariant (child, value.pool))) {
+				return false;
+			}
+		}
+		return true;
+	default:
+		slot->type = src->type;
+		slot->value = src->value;
+		return true;
+	}
+}
+
+size_t JsonVariant::size () const {
+	if (!slot || (slot->type != JSON_ARRAY && slot->type != JSON_OBJECT)) {
+		return 0;
+	}
+	size_t n = 0;
+	for (JsonSlot* child = slot->value.asCollection.head; child; child = child->next) {
+		n++;
+	}
+	return n;
+}
+
+MemberProxy JsonVariant::operator[] (const char* key) {
+	return MemberProxy (*this, key, false);
+}
+
+MemberProxy JsonVariant::operator[] (char* key) {
+	return MemberProxy (*this, key, true);
+}
+
+JsonVariant JsonVariant::getMember (const char* key) const {
+	if (!slot || slot->type != JSON_OBJECT || !key) {
+		return JsonVariant ();
+	}
+	for (JsonSlot* child = slot->value.asCollection.head; child; child = child->next) {
+		if (!strcmp (child->key, key)) {
+			return JsonVariant (child, pool);
+		}
+	}
+	return JsonVariant ();
+}
+
+static bool appendChild (JsonSlot* parent, JsonSlot* child) {
+	if (parent->value.asCollection.tail) {
+		parent->value.asCollection.tail->next = child;
+	} else {
+		parent->value.asCollection.head = child;
+	}
+	parent->value.asCollection.tail = child;
+	return true;
+}
+
+JsonVariant JsonVariant::getOrAddMember (const char* key, bool copyKey) {
+	if (!slot || !key) {
+		return JsonVariant ();
+	}
+	if (slot->type == JSON_NULL) {
+		slot->type = JSON_OBJECT;
+		slot->value.asCollection.head = nullptr;
+		slot->value.asCollection.tail = nullptr;
+	}
+	if (slot->type != JSON_OBJECT) {
+		return JsonVariant ();
+	}
+	JsonVariant existing = getMember (key);
+	if (!existing.slot) {
+		JsonSlot* child = pool->allocSlot ();
+		if (!child) {
+			return JsonVariant ();
+		}
+		child->key = copyKey ? pool->saveString (key, strlen (key)) : key;
+		if (!child->key) {
+			return JsonVariant ();
+		}
+		appendChild (slot, child);
+		existing = JsonVariant (child, pool);
+	}
+	return existing;
+}
+
+JsonVariant JsonVariant::getElement (size_t index) const {
+	if (!slot || slot->type != JSON_ARRAY) {
+		return JsonVariant ();
+	}
+	for (JsonSlot* child = slot->value.asCollection.head; child; child = child->next) {
+		if (index-- == 0) {
+			return JsonVariant (child, pool);
+		}
+	}
+	return JsonVariant ();
+}
+
+JsonVariant JsonVariant::addElement () {
+	if (!slot) {
+		return JsonVariant ();
+	}
+	if (slot->type == JSON_NULL) {
+		slot->type = JSON_ARRAY;
+		slot->value.asCollection.head = nullptr;
+		slot->value.asCollection.tail = nullptr;
+	}
+	if (slot->type != JSON_ARRAY) {
+		return JsonVariant ();
+	}
+	JsonSlot* child = pool->allocSlot ();
+	if (!child) {
+		return JsonVariant ();
+	}
+	appendChild (slot, child);
+	return JsonVariant (child, pool);
+}
+
+static JsonVariant makeCollection (JsonVariant variant, jsonType_t type) {
+	JsonSlot* slot = variant.getSlot ();
+	if (slot) {
+		slot->type = type;
+		slot->value.asCollection.head = nullptr;
+		slot->value.asCollection.tail = nullptr;
+	}
+	return variant;
+}
+
+JsonArray JsonVariant::createNestedArray () {
+	JsonVariant v = makeCollection (addElement (), JSON_ARRAY);
+	return JsonArray (v.getSlot (), pool);
+}
+
+JsonArray JsonVariant::createNestedArray (const char* key) {
+	JsonVariant v = makeCollection (getOrAddMember (key, false), JSON_ARRAY);
+	return JsonArray (v.getSlot (), pool);
+}
+
+JsonObject JsonVariant::createNestedObject () {
+	JsonVariant v = makeCollection (addElement (), JSON_OBJECT);
+	return JsonObject (v.getSlot (), pool);
+}
+
+JsonObject JsonVariant::createNestedObject (const char* key) {
+	JsonVariant v = makeCollection (getOrAddMember (key, false), JSON_OBJECT);
+	return JsonObject (v.getSlot (), pool);
+}
+
+void JsonVariant::remove (const char* key) {
+	if (!slot || slot->type != JSON_OBJECT) {
+		return;
+	}
+	JsonSlot* prev = nullptr;
+	for (JsonSlot* child = slot->value.asCollection.head; child; prev = child, child = child->next) {
+		if (!strcmp (child->key, key)) {
+			if (prev) {
+				prev->next = child->next;
+			} else {
+				slot->value.asCollection.head = child->next;
+			}
+			if (slot->value.asCollection.tail == child) {
+				slot->value.asCollection.tail = prev;
+			}
+			return;
+		}
+	}
+}
+
+void JsonVariant::clear () {
+	if (slot && (slot->type == JSON_ARRAY || slot->type == JSON_OBJECT)) {
+		slot->value.asCollection.head = nullptr;
+		slot->value.asCollection.tail = nullptr;
+	}
+}
+
+JsonArray MemberProxy::createNestedArray () {
+	return parent.createNestedArray (key);
+}
+
+JsonObject MemberProxy::createNestedObject () {
+	return parent.createNestedObject (key);
+}
+
+const char* DeserializationError::c_str () const {
+	static const char* messages[] = { "Ok", "EmptyInput", "IncompleteInput", "InvalidInput", "NoMemory", "NotSupported", "TooDeep" };
+	return messages[_code];
+}
+
+// ---- Writers ----
+
+namespace {
+
+class Writer {
+public:
+	Writer (uint8_t* buffer, size_t capacity) : buffer (buffer), capacity (capacity), print (nullptr) {}
+	Writer (Print* print) : buffer (nullptr), capacity (0), print (print) {}
+	Writer () : buffer (nullptr), capacity (SIZE_MAX), print (nullptr) {}
+
+	void write (uint8_t c) {
+		if (print) {
+			count += print->write (c);
+		} else if (count < capacity) {
+			if (buffer) {
+				buffer[count] = c;
+			}
+			count++;
+		}
+	}
+	void write (const char* str, size_t len) {
+		for (size_t i = 0; i < len; i++) {
+			write ((uint8_t)str[i]);
+		}
+	}
+	void write (const char* str) {
+		write (str, strlen (str));
+	}
+	size_t count = 0;
+
+private:
+	uint8_t* buffer;
+	size_t capacity;
+	Print* print;
+};
+
+void writeJsonString (Writer& out, const char* str) {
+	out.write ('"');
+	for (; *str; str++) {
+		switch (*str) {
+		case '"': out.write ("\\\""); break;
+		case '\\': out.write ("\\\\"); break;
+		case '\b': out.write ("\\b"); break;
+		case '\f': out.write ("\\f"); break;
+		case '\n': out.write ("\\n"); break;
+		case '\r': out.write ("\\r"); break;
+		case '\t': out.write ("\\t"); break;
+		default: out.write ((uint8_t)*str); break;
+		}
+	}
+	out.write ('"');
+}
+
+void writeIndent (Writer& out, int level) {
+	out.write ("\r\n");
+	for (int i = 0; i < level; i++) {
+		out.write ("  ");
+	}
+}
+
+void writeJson (Writer& out, const JsonSlot* slot, bool pretty, int level) {
+	char number[32];
+	switch (slot->type) {
+	case JSON_NULL:
+		out.write ("null");
+		break;
+	case JSON_BOOL:
+		out.write (slot->value.asBool ? "true" : "false");
+		break;
+	case JSON_INT:
+		snprintf (number, sizeof (number), "%lld", (long long)slot->value.asInt);
+		out.write (number);
+		break;
+	case JSON_UINT:
+		snprintf (number, sizeof (number), "%llu", (unsigned long long)slot->value.asUint);
+		out.write (number);
+		break;
+	case JSON_FLOAT:
+		snprintf (number, sizeof (number), "%.9g", slot->value.asFloat);
+		out.write (number);
+		break;
+	case JSON_STRING:
+		writeJsonString (out, slot->value.asString);
+		break;
+	case JSON_ARRAY:
+	case JSON_OBJECT: {
+		bool isObject = slot->type == JSON_OBJECT;
+		const JsonSlot* child = slot->value.asCollection.head;
+		out.write (isObject ? '{' : '[');
+		if (child) {
+			for (; child; child = child->next) {
+				if (pretty) {
+					writeIndent (out, level + 1);
+				}
+				if (isObject) {
+					writeJsonString (out, child->key);
+					out.write (pretty ? ": " : ":");
+				}
+				writeJson (out, child, pretty, level + 1);
+				if (child->next) {
+					out.write (',');
+				}
+			}
+			if (pretty) {
+				writeIndent (out, level);
+			}
+		}
+		out.write (isObject ? '}' : ']');
+		break;
+	}
+	}
+}
+
+void writeBigEndian (Writer& out, uint64_t value, int bytes) {
+	for (int i = bytes - 1; i >= 0; i--) {
+		out.write ((uint8_t)(value >> (8 * i)));
+	}
+}
+
+void writeMsgPackUint (Writer& out, uint64_t value) {
+	if (value <= 0x7F) {
+		out.write ((uint8_t)value);
+	} else if (value <= 0xFF) {
+		out.write (0xCC);
+		writeBigEndian (out, value, 1);
+	} else if (value <= 0xFFFF) {
+		out.write (0xCD);
+		writeBigEndian (out, value, 2);
+	} else if (value <= 0xFFFFFFFF) {
+		out.write (0xCE);
+		writeBigEndian (out, value, 4);
+	} else {
+		out.write (0xCF);
+		writeBigEndian (out, value, 8);
+	}
+}
+
+void writeMsgPackInt (Writer& out, int64_t value) {
+	if (value >= 0) {
+		writeMsgPackUint (out, (uint64_t)value);
+	} else if (value >= -32) {
+		out.write ((uint8_t)value);
+	} else if (value >= INT8_MIN) {
+		out.write (0xD0);
+		writeBigEndian (out, (uint64_t)value, 1);
+	} else if (value >= INT16_MIN) {
+		out.write (0xD1);
+		writeBigEndian (out, (uint64_t)value, 2);
+	} else if (value >= INT32_MIN) {
+		out.write (0xD2);
+		writeBigEndian (out, (uint64_t)value, 4);
+	} else {
+		out.write (0xD3);
+		writeBigEndian (out, (uint64_t)value, 8);
+	}
+}
+
+void writeMsgPackString (Writer& out, const char* str) {
+	size_t len = strlen (str);
+	if (len < 32) {
+		out.write ((uint8_t)(0xA0 | len));
+	} else if (len <= 0xFF) {
+		out.write (0xD9);
+		writeBigEndian (out, len, 1);
+	} else if (len <= 0xFFFF) {
+		out.write (0xDA);
+		writeBigEndian (out, len, 2);
+	} else {
+		out.write (0xDB);
+		writeBigEndian (out, len, 4);
+	}
+	out.write (str, len);
+}
+
+void writeMsgPack (Writer& out, const JsonSlot* slot) {
+	switch (slot->type) {
+	case JSON_NULL:
+		out.write (0xC0);
+		break;
+	case JSON_BOOL:
+		out.write (slot->value.asBool ? 0xC3 : 0xC2);
+		break;
+	case JSON_INT:
+		writeMsgPackInt (out, slot->value.asInt);
+		break;
+	case JSON_UINT:
+		writeMsgPackUint (out, slot->value.asUint);
+		break;
+	case JSON_FLOAT: {
+		double value = slot->value.asFloat;
+		float single = (float)value;
+		if ((double)single == value) {
+			uint32_t bits;
+			memcpy (&bits, &single, sizeof (bits));
+			out.write (0xCA);
+			writeBigEndian (out, bits, 4);
+		} else {
+			uint64_t bits;
+			memcpy (&bits, &value, sizeof (bits));
+			out.write (0xCB);
+			writeBigEndian (out, bits, 8);
+		}
+		break;
+	}
+	case JSON_STRING:
+		writeMsgPackString (out, slot->value.asString);
+		break;
+	case JSON_ARRAY:
+	case JSON_OBJECT: {
+		bool isObject = slot->type == JSON_OBJECT;
+		size_t n = 0;
+		for (const JsonSlot* child = slot->value.asCollection.head; child; child = child->next) {
+			n++;
+		}
+		if (n < 16) {
+			out.write ((uint8_t)((isObject ? 0x80 : 0x90) | n));
+		} else if (n <= 0xFFFF) {
+			out.write (isObject ? 0xDE : 0xDC);
+			writeBigEndian (out, n, 2);
+		} else {
+			out.write (isObject ? 0xDF : 0xDD);
+			writeBigEndian (out, n, 4);
+		}
+		for (const JsonSlot* child = slot->value.asCollection.head; child; child = child->next) {
+			if (isObject) {
+				writeMsgPackString (out, child->key);
+			}
+			writeMsgPack (out, child);
+		}
+		break;
+	}
+	}
+}
+
+// ---- Readers ----
+
+class Reader {
+public:
+	Reader (const uint8_t* begin, const uint8_t* end) : ptr (begin), end (end), stream (nullptr) {}
+	Reader (Stream* stream) : ptr (nullptr), end (nullptr), stream (stream) {}
+
+	int peek () {
+		if (peeked < 0) {
+			peeked = next ();
+		}
+		return peeked;
+	}
+	int read () {
+		int c = peek ();
+		peeked = -1;
+		return c;
+	}
+	bool readBytes (uint8_t* out, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			int c = read ();
+			if (c < 0) {
+				return false;
+			}
+			out[i] = (uint8_t)c;
+		}
+		return true;
+	}
+
+private:
+	int next () {
+		if (stream) {
+			return stream->read ();
+		}
+		if (ptr < end) {
+			return *ptr++;
+		}
+		return -1;
+	}
+	const uint8_t* ptr;
+	const uint8_t* end;
+	Stream* stream;
+	int peeked = -1;
+};
+
+class JsonParser {
+public:
+	JsonParser (Reader& in, JsonPool* pool) : in (in), pool (pool) {}
+
+	DeserializationError parse (JsonSlot* slot) {
+		skipSpaces ();
+		if (in.peek () < 0) {
+			return DeserializationError::EmptyInput;
+		}
+		return parseValue (slot, 0);
+	}
+
+private:
+	void skipSpaces () {
+		int c;
+		while ((c = in.peek ()) == ' ' || c == '\t' || c == '\r' || c == '\n') {
+			in.read ();
+		}
+	}
+
+	DeserializationError parseValue (JsonSlot* slot, int depth) {
+		skipSpaces ();
+		int c = in.peek ();
+		if (c < 0) {
+			return DeserializationError::IncompleteInput;
+		}
+		if (c == '{' || c == '[') {
+			if (depth >= JSON_NESTING_LIMIT) {
+				return DeserializationError::TooDeep;
+			}
+			return parseCollection (slot, c == '{', depth);
+		}
+		if (c == '"' || c == '\'') {
+			const char* str;
+			DeserializationError err = parseString (&str);
+			if (err) {
+				return err;
+			}
+			slot->type = JSON_STRING;
+			slot->value.asString = str;
+			return DeserializationError::Ok;
+		}
+		return parseLiteral (slot);
+	}
+
+	DeserializationError parseCollection (JsonSlot* slot, bool isObject, int depth) {
+		in.read ();
+		slot->type = isObject ? JSON_OBJECT : JSON_ARRAY;
+		slot->value.asCollection.head = nullptr;
+		slot->value.asCollection.tail = nullptr;
+		const char close = isObject ? '}' : ']';
+		skipSpaces ();
+		if (in.peek () == close) {
+			in.read ();
+			return DeserializationError::Ok;
+		}
+		for (;;) {
+			JsonSlot* child = pool->allocSlot ();
+			if (!child) {
+				return DeserializationError::NoMemory;
+			}
+			if (isObject) {
+				skipSpaces ();
+				DeserializationError err = parseString (&child->key);
+				if (err) {
+					return err;
+				}
+				skipSpaces ();
+				int c = in.read ();
+				if (c < 0) {
+					return DeserializationError::IncompleteInput;
+				}
+				if (c != ':') {
+					return DeserializationError::InvalidInput;
+				}
+			}
+			DeserializationError err = parseValue (child, depth + 1);
+			if (err) {
+				return err;
+			}
+			appendChild (slot, child);
+			skipSpaces ();
+			int c = in.read ();
+			if (c < 0) {
+				return DeserializationError::IncompleteInput;
+			}
+			if (c == close) {
+				return DeserializationError::Ok;
+			}
+			if (c != ',') {
+				return DeserializationError::InvalidInput;
+			}
+		}
+	}
+
+	DeserializationError parseString (const char** result) {
+		char buffer[256];
+		size_t len = 0;
+		int quote = in.read ();
+		if (quote < 0) {
+			return DeserializationError::IncompleteInput;
+		}
+		if (quote != '"' && quote != '\'') {
+			return DeserializationError::InvalidInput;
+		}
+		for (;;) {
+			int c = in.read ();
+			if (c < 0) {
+				return DeserializationError::IncompleteInput;
+			}
+			if (c == quote) {
+				break;
+			}
+			if (c == '\\') {
+				c = in.read ();
+				switch (c) {
+				case -1: return DeserializationError::IncompleteInput;
+				case 'b': c = '\b'; break;
+				case 'f': c = '\f'; break;
+				case 'n': c = '\n'; break;
+				case 'r': c = '\r'; break;
+				case 't': c = '\t'; break;
+				case 'u': return DeserializationError::NotSupported;
+				default: break;
+				}
+			}
+			if (len >= sizeof (buffer) - 1) {
+				return DeserializationError::NoMemory;
+			}
+			buffer[len++] = (char)c;
+		}
+		*result = pool->saveString (buffer, len);
+		return *result ? DeserializationError::Ok : DeserializationError::NoMemory;
+	}
+
+	DeserializationError parseLiteral (JsonSlot* slot) {
+		char buffer[32];
+		size_t len = 0;
+		int c;
+		while ((c = in.peek ()) >= 0 && (isalnum (c) || c == '-' || c == '+' || c == '.')) {
+			if (len >= sizeof (buffer) - 1) {
+				return DeserializationError::InvalidInput;
+			}
+			buffer[len++] = (char)in.read ();
+		}
+		buffer[len] = '\0';
+		if (!len) {
+			return c < 0 ? DeserializationError::IncompleteInput : DeserializationError::InvalidInput;
+		}
+		if (!strcmp (buffer, "null")) {
+			slot->type = JSON_NULL;
+		} else if (!strcmp (buffer, "true") || !strcmp (buffer, "false")) {
+			slot->type = JSON_BOOL;
+			slot->value.asBool = buffer[0] == 't';
+		} else {
+			char* end;
+			if (strpbrk (buffer, ".eE")) {
+				slot->type = JSON_FLOAT;
+				slot->value.asFloat = strtod (buffer, &end);
+			} else if (buffer[0] == '-') {
+				slot->type = JSON_INT;
+				slot->value.asInt = strtoll (buffer, &end, 10);
+			} else {
+				slot->type = JSON_UINT;
+				slot->value.asUint = strtoull (buffer, &end, 10);
+			}
+			if (*end) {
+				return DeserializationError::InvalidInput;
+			}
+		}
+		return DeserializationError::Ok;
+	}
+
+	Reader& in;
+	JsonPool* pool;
+};
+
+class MsgPackParser {
+public:
+	MsgPackParser (Reader& in, JsonPool* pool) : in (in), pool (pool) {}
+
+	DeserializationError parse (JsonSlot* slot) {
+		if (in.peek () < 0) {
+			return DeserializationError::EmptyInput;
+		}
+		return parseValue (slot, 0);
+	}
+
+private:
+	bool readBigEndian (uint64_t* value, int bytes) {
+		uint8_t buffer[8];
+		if (!in.readBytes (buffer, bytes)) {
+			return false;
+		}
+		*value = 0;
+		for (int i = 0; i < bytes; i++) {
+			*value = (*value << 8) | buffer[i];
+		}
+		return true;
+	}
+
+	DeserializationError readString (size_t len, const char** result) {
+		char buffer[256];
+		if (len >= sizeof (buffer)) {
+			return DeserializationError::NoMemory;
+		}
+		if (!in.readBytes ((uint8_t*)buffer, len)) {
+			return DeserializationError::IncompleteInput;
+		}
+		*result = pool->saveString (buffer, len);
+		return *result ? DeserializationError::Ok : DeserializationError::NoMemory;
+	}
+
+	DeserializationError readCollection (JsonSlot* slot, size_t n, bool isObject, int depth) {
+		if (depth >= JSON_NESTING_LIMIT) {
+			return DeserializationError::TooDeep;
+		}
+		slot->type = isObject ? JSON_OBJECT : JSON_ARRAY;
+		slot->value.asCollection.head = nullptr;
+		slot->value.asCollection.tail = nullptr;
+		for (size_t i = 0; i < n; i++) {
+			JsonSlot* child = pool->allocSlot ();
+			if (!child) {
+				return DeserializationError::NoMemory;
+			}
+			if (isObject) {
+				JsonSlot key;
+				DeserializationError err = parseValue (&key, depth + 1);
+				if (err) {
+					return err;
+				}
+				if (key.type != JSON_STRING) {
+					return DeserializationError::InvalidInput;
+				}
+				child->key = key.value.asString;
+			}
+			DeserializationError err = parseValue (child, depth + 1);
+			if (err) {
+				return err;
+			}
+			appendChild (slot, child);
+		}
+		return DeserializationError::Ok;
+	}
+
+	DeserializationError parseValue (JsonSlot* slot, int depth) {
+		int c = in.read ();
+		uint64_t value;
+		if (c < 0) {
+			return DeserializationError::IncompleteInput;
+		}
+		if (c <= 0x7F) {
+			slot->type = JSON_UINT;
+			slot->value.asUint = c;
+			return DeserializationError::Ok;
+		}
+		if (c >= 0xE0) {
+			slot->type = JSON_INT;
+			slot->value.asInt = (int8_t)c;
+			return DeserializationError::Ok;
+		}
+		if ((c & 0xE0) == 0xA0) {
+			slot->type = JSON_STRING;
+			return readString (c & 0x1F, &slot->value.asString);
+		}
+		if ((c & 0xF0) == 0x80) {
+			return readCollection (slot, c & 0x0F, true, depth);
+		}
+		if ((c & 0xF0) == 0x90) {
+			return readCollection (slot, c & 0x0F, false, depth);
+		}
+		switch (c) {
+		case 0xC0:
+			slot->type = JSON_NULL;
+			return DeserializationError::Ok;
+		case 0xC2:
+		case 0xC3:
+			slot->type = JSON_BOOL;
+			slot->value.asBool = c == 0xC3;
+			return DeserializationError::Ok;
+		case 0xCC:
+		case 0xCD:
+		case 0xCE:
+		case 0xCF:
+			if (!readBigEndian (&value, 1 << (c - 0xCC))) {
+				return DeserializationError::IncompleteInput;
+			}
+			slot->type = JSON_UINT;
+			slot->value.asUint = value;
+			return DeserializationError::Ok;
+		case 0xD0:
+		case 0xD1:
+		case 0xD2:
+		case 0xD3: {
+			int bytes = 1 << (c - 0xD0);
+			if (!readBigEndian (&value, bytes)) {
+				return DeserializationError::IncompleteInput;
+			}
+			int shift = 64 - 8 * bytes;
+			slot->type = JSON_INT;
+			slot->value.asInt = (int64_t)(value << shift) >> shift;
+			return DeserializationError::Ok;
+		}
+		case 0xCA: {
+			if (!readBigEndian (&value, 4)) {
+				return DeserializationError::IncompleteInput;
+			}
+			uint32_t bits = (uint32_t)value;
+			float single;
+			memcpy (&single, &bits, sizeof (single));
+			slot->type = JSON_FLOAT;
+			slot->value.asFloat = single;
+			return DeserializationError::Ok;
+		}
+		case 0xCB:
+			if (!readBigEndian (&value, 8)) {
+				return DeserializationError::IncompleteInput;
+			}
+			slot->type = JSON_FLOAT;
+			memcpy (&slot->value.asFloat, &value, sizeof (value));
+			return DeserializationError::Ok;
+		case 0xD9:
+		case 0xDA:
+		case 0xDB:
+			if (!readBigEndian (&value, 1 << (c - 0xD9))) {
+				return DeserializationError::IncompleteInput;
+			}
+			slot->type = JSON_STRING;
+			return readString ((size_t)value, &slot->value.asString);
+		case 0xDC:
+		case 0xDD:
+			if (!readBigEndian (&value, c == 0xDC ? 2 : 4)) {
+				return DeserializationError::IncompleteInput;
+			}
+			return readCollection (slot, (size_t)value, false, depth);
+		case 0xDE:
+		case 0xDF:
+			if (!readBigEndian (&value, c == 0xDE ? 2 : 4)) {
+				return DeserializationError::IncompleteInput;
+			}
+			return readCollection (slot, (size_t)value, true, depth);
+		default:
+			return DeserializationError::NotSupported;
+		}
+	}
+
+	Reader& in;
+	JsonPool* pool;
+};
+
+DeserializationError parseJsonDocument (JsonDocument& doc, Reader& reader) {
+	doc.clear ();
+	JsonVariant root = doc.getVariant ();
+	JsonParser parser (reader, root.getPool ());
+	return parser.parse (root.getSlot ());
+}
+
+DeserializationError parseMsgPackDocument (JsonDocument& doc, Reader& reader) {
+	doc.clear ();
+	JsonVariant root = doc.getVariant ();
+	MsgPackParser parser (reader, root.getPool ());
+	return parser.parse (root.getSlot ());
+}
+
+size_t terminate (Writer& writer, char* output, size_t size) {
+	if (size) {
+		output[writer.count] = '\0';
+	}
+	return writer.count;
+}
+
+} // namespace
+
+DeserializationError deserializeJson (JsonDocument& doc, Stream& input) {
+	Reader reader (&input);
+	return parseJsonDocument (doc, reader);
+}
+
+DeserializationError deserializeJson (JsonDocument& doc, const char* input) {
+	return deserializeJson (doc, input, input ? strlen (input) : 0);
+}
+
+DeserializationError deserializeJson (JsonDocument& doc, const char* input, size_t size) {
+	Reader reader ((const uint8_t*)input, (const uint8_t*)input + size);
+	return parseJsonDocument (doc, reader);
+}
+
+DeserializationError deserializeMsgPack (JsonDocument& doc, Stream& input) {
+	Reader reader (&input);
+	return parseMsgPackDocument (doc, reader);
+}
+
+DeserializationError deserializeMsgPack (JsonDocument& doc, const uint8_t* input, size_t size) {
+	Reader reader (input, input + size);
+	return parseMsgPackDocument (doc, reader);
+}
+
+size_t serializeJson (const JsonDocument& doc, char* output, size_t size) {
+	Writer writer ((uint8_t*)output, size ? size - 1 : 0);
+	writeJson (writer, doc.getRoot (), false, 0);
+	return terminate (writer, output, size);
+}
+
+size_t serializeJson (const JsonDocument& doc, Print& output) {
+	Writer writer (&output);
+	writeJson (writer, doc.getRoot (), false, 0);
+	return writer.count;
+}
+
+size_t serializeJsonPretty (const JsonDocument& doc, char* output, size_t size) {
+	Writer writer ((uint8_t*)output, size ? size - 1 : 0);
+	writeJson (writer, doc.getRoot (), true, 0);
+	return terminate (writer, output, size);
+}
+
+size_t serializeJsonPretty (const JsonDocument& doc, Print& output) {
+	Writer writer (&output);
+	writeJson (writer, doc.getRoot (), true, 0);
+	return writer.count;
+}
+
+size_t measureJson (const JsonDocument& doc) {
+	Writer writer;
+	writeJson (writer, doc.getRoot (), false, 0);
+	return writer.count;
+}
+
+size_t measureJsonPretty (const JsonDocument& doc) {
+	Writer writer;
+	writeJson (writer, doc.getRoot (), true, 0);
+	return writer.count;
+}
+
+size_t serializeMsgPack (const JsonDocument& doc, uint8_t* output, size_t size) {
+	Writer writer (output, size);
+	writeMsgPack (writer, doc.getRoot ());
+	return writer.count;
+}
+
+size_t serializeMsgPack (const JsonDocument& doc, Print& output) {
+	Writer writer (&output);
+	writeMsgPack (writer, doc.getRoot ());
+	return writer.count;
+}
+
+size_t measureMsgPack (const JsonDocument& doc) {
+	Writer writer;
+	writeMsgPack (writer, doc.getRoot ());
+	return writer.count;
+}
@@ -0,0 +1,461 @@
+/**
+  * @brief Simulated Arduino core, filesystem and EnigmaIOT node for host builds
+  *
+  * @file HostShim.cpp
+  */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <EnigmaIOTNode.h>
+#include <Ticker.h>
+#include <malloc.h>
+#include <vector>
+
+static const int HOST_PIN_COUNT = 16384;
+static const uint32_t HOST_HEAP_SIZE = 40960; // Roughly what an esp01_1m has left for user code
+
+static unsigned long simulatedMicros = 0;
+static uint8_t pinLevel[HOST_PIN_COUNT];
+
+struct hostInterrupt_t {
+	uint16_t pin;
+	void (*handler) (void*);
+	void* arg;
+	int mode;
+};
+static std::vector<hostInterrupt_t> interrupts;
+static unsigned long digitalWrites = 0;
+static void (*digitalWriteHook) (uint16_t pin, uint8_t val) = nullptr;
+static unsigned long rtcWrites = 0;
+static hostHeapStats_t heapStats;
+
+HardwareSerial Serial;
+EspClass ESP;
+fs::FS SPIFFS;
+EnigmaIOTNodeClass EnigmaIOTNode;
+
+// ---- Time ----
+
+unsigned long millis () {
+	return simulatedMicros / 1000;
+}
+
+unsigned long micros () {
+	return simulatedMicros;
+}
+
+void delay (unsigned long ms) {
+	Ticker::runDue (simulatedMicros, simulatedMicros + ms * 1000);
+}
+
+void yield () {}
+
+void hostSetMillis (unsigned long ms) {
+	if (ms * 1000 < simulatedMicros) { // Going back does not run timers
+		simulatedMicros = ms * 1000;
+	}
+	Ticker::runDue (simulatedMicros, ms * 1000);
+}
+
+void hostAdvanceMillis (unsigned long ms) {
+	Ticker::runDue (simulatedMicros, simulatedMicros + ms * 1000);
+}
+
+// ---- Random ----
+
+static uint32_t randomState = 1;
+
+long random (long max) {
+	if (max <= 0) {
+		return 0;
+	}
+	// xorshift32
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState % max;
+}
+
+long random (long min, long max) {
+	return max > min ? min + random (max - min) : min;
+}
+
+void randomSeed (unsigned long seed) {
+	randomState = seed ? seed : 1;
+}
+
+// ---- Ticker ----
+
+Ticker* Ticker::first = nullptr;
+
+Ticker::Ticker () {
+	next = first;
+	first = this;
+}
+
+Ticker::~Ticker () {
+	for (Ticker** link = &first; *link; link = &(*link)->next) {
+		if (*link == this) {
+			*link = next;
+			break;
+		}
+	}
+}
+
+void Ticker::attach (uint32_t milliseconds, callback_t cb, void* cbArg) {
+	callback = cb;
+	arg = cbArg;
+	deadline = micros () + milliseconds * 1000UL;
+	armed = true;
+}
+
+void Ticker::runDue (unsigned long& simulatedMicros, unsigned long targetMicros) {
+	for (;;) {
+		Ticker* due = nullptr;
+		for (Ticker* ticker = first; ticker; ticker = ticker->next) {
+			if (ticker->armed && ticker->deadline <= targetMicros && (!due || ticker->deadline < due->deadline)) {
+				due = ticker;
+			}
+		}
+		if (!due) {
+			break;
+		}
+		if (due->deadline > simulatedMicros) {
+			simulatedMicros = due->deadline;
+		}
+		due->armed = false;
+		due->callback (due->arg);
+	}
+	simulatedMicros = targetMicros;
+}
+
+// ---- GPIO ----
+
+void pinMode (uint16_t pin, uint8_t mode) {
+	if (mode == INPUT_PULLUP && pin < HOST_PIN_COUNT) {
+		pinLevel[pin] = HIGH; // Open button
+	}
+}
+
+void digitalWrite (uint16_t pin, uint8_t val) {
+	digitalWrites++;
+	if (pin < HOST_PIN_COUNT) {
+		pinLevel[pin] = val ? HIGH : LOW;
+	}
+	if (digitalWriteHook) {
+		digitalWriteHook (pin, val);
+	}
+}
+
+void hostOnDigitalWrite (void (*hook) (uint16_t pin, uint8_t val)) {
+	digitalWriteHook = hook;
+}
+
+int digitalRead (uint16_t pin) {
+	return pin < HOST_PIN_COUNT ? pinLevel[pin] : LOW;
+}
+
+int hostPinLevel (uint16_t pin) {
+	return digitalRead (pin);
+}
+
+void attachInterruptArg (uint16_t pin, void (*handler) (void*), void* arg, int mode) {
+	detachInterrupt (pin);
+	interrupts.push_back ({ pin, handler, arg, mode });
+}
+
+void detachInterrupt (uint16_t pin) {
+	for (auto it = interrupts.begin (); it != interrupts.end (); ++it) {
+		if (it->pin == pin) {
+			interrupts.erase (it);
+			return;
+		}
+	}
+}
+
+void hostSetPinInput (uint16_t pin, int level) {
+	if (pin >= HOST_PIN_COUNT || pinLevel[pin] == (level ? HIGH : LOW)) {
+		return;
+	}
+	pinLevel[pin] = level ? HIGH : LOW;
+	for (const hostInterrupt_t& interrupt : interrupts) {
+		if (interrupt.pin == pin && (interrupt.mode == CHANGE || interrupt.mode == (level ? RISING : FALLING))) {
+			interrupt.handler (interrupt.arg);
+			return;
+		}
+	}
+}
+
+unsigned long hostDigitalWriteCount () {
+	return digitalWrites;
+}
+
+// ---- Heap ----
+
+#ifdef __GLIBC__
+extern "C" {
+	void* __libc_malloc (size_t size);
+	void* __libc_calloc (size_t n, size_t size);
+	void* __libc_realloc (void* ptr, size_t size);
+	void __libc_free (void* ptr);
+
+	static void accountAlloc (void* ptr) {
+		if (ptr) {
+			heapStats.allocations++;
+			heapStats.liveBytes += malloc_usable_size (ptr);
+			if (heapStats.liveBytes > heapStats.peakBytes) {
+				heapStats.peakBytes = heapStats.liveBytes;
+			}
+		}
+	}
+
+	static void accountFree (void* ptr) {
+		if (ptr) {
+			heapStats.frees++;
+			heapStats.liveBytes -= malloc_usable_size (ptr);
+		}
+	}
+
+	void* malloc (size_t size) {
+		void* ptr = __libc_malloc (size);
+		accountAlloc (ptr);
+		return ptr;
+	}
+
+	void* calloc (size_t n, size_t size) {
+		void* ptr = __libc_calloc (n, size);
+		accountAlloc (ptr);
+		return ptr;
+	}
+
+	void* realloc (void* ptr, size_t size) {
+		accountFree (ptr);
+		void* result = __libc_realloc (ptr, size);
+		accountAlloc (result);
+		return result;
+	}
+
+	void free (void* ptr) {
+		accountFree (ptr);
+		__libc_free (ptr);
+	}
+}
+#endif // __GLIBC__
+
+hostHeapStats_t hostHeapStats () {
+	return heapStats;
+}
+
+void hostResetCounters () {
+	memset (&heapStats, 0, sizeof (heapStats));
+	digitalWrites = 0;
+	rtcWrites = 0;
+}
+
+uint32_t EspClass::getFreeHeap () {
+	long used = heapStats.liveBytes > 0 ? heapStats.liveBytes : 0;
+	return used < (long)HOST_HEAP_SIZE ? HOST_HEAP_SIZE - used : 0;
+}
+
+uint32_t EspClass::getCycleCount () {
+	return (uint32_t)(simulatedMicros * 80); // 80 MHz CPU clock
+}
+
+// ---- RTC memory ----
+
+static const size_t RTC_USER_MEMORY_SIZE = 512;
+static uint8_t rtcMemory[RTC_USER_MEMORY_SIZE];
+
+// Same limits as ESP8266 core: offset in 4 byte blocks, 512 bytes available
+bool EspClass::rtcUserMemoryRead (uint32_t offset, uint32_t* data, size_t size) {
+	if (offset * 4 + size > RTC_USER_MEMORY_SIZE || size % 4) {
+		return false;
+	}
+	memcpy (data, rtcMemory + offset * 4, size);
+	return true;
+}
+
+bool EspClass::rtcUserMemoryWrite (uint32_t offset, uint32_t* data, size_t size) {
+	if (offset * 4 + size > RTC_USER_MEMORY_SIZE || size % 4) {
+		return false;
+	}
+	memcpy (rtcMemory + offset * 4, data, size);
+	rtcWrites++;
+	return true;
+}
+
+void hostClearRtcMemory () {
+	memset (rtcMemory, 0, sizeof (rtcMemory));
+}
+
+unsigned long hostRtcWriteCount () {
+	return rtcWrites;
+}
+
+// ---- Misc core functions ----
+
+char* itoa (int value, char* str, int base) {
+	static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+	char* p = str;
+	unsigned int v = (value < 0 && base == 10) ? -value : value;
+	if (base < 2 || base > 36) {
+		*str = '\0';
+		return str;
+	}
+	do {
+		*p++ = digits[v % base];
+		v /= base;
+	} while (v);
+	if (value < 0 && base == 10) {
+		*p++ = '-';
+	}
+	*p = '\0';
+	for (char *a = str, *b = p - 1; a < b; a++, b--) {
+		char t = *a;
+		*a = *b;
+		*b = t;
+	}
+	return str;
+}
+
+size_t Print::vprintf (const char* format, va_list args) {
+	char buffer[256];
+	int len = vsnprintf (buffer, sizeof (buffer), format, args);
+	if (len < 0) {
+		return 0;
+	}
+	return write ((const uint8_t*)buffer, min ((size_t)len, sizeof (buffer) - 1));
+}
+
+size_t Print::printf (const char* format, ...) {
+	va_list args;
+	va_start (args, format);
+	size_t n = vprintf (format, args);
+	va_end (args);
+	return n;
+}
+
+size_t Print::printf_P (const char* format, ...) {
+	va_list args;
+	va_start (args, format);
+	size_t n = vprintf (format, args);
+	va_end (args);
+	return n;
+}
+
+size_t HardwareSerial::write (uint8_t c) {
+	return fwrite (&c, 1, 1, stderr);
+}
+
+size_t HardwareSerial::write (const uint8_t* buffer, size_t size) {
+	return fwrite (buffer, 1, size, stderr);
+}
+
+String::String (const char* str) {
+	len = str ? strlen (str) : 0;
+	buffer = (char*)malloc (len + 1);
+	memcpy (buffer, str ? str : "", len + 1);
+}
+
+String::String (int value) {
+	char number[12];
+	snprintf (number, sizeof (number), "%d", value);
+	len = strlen (number);
+	buffer = (char*)malloc (len + 1);
+	memcpy (buffer, number, len + 1);
+}
+
+String::String (const String& other) : String (other.buffer) {}
+
+String& String::operator= (const String& other) {
+	if (this != &other) {
+		free (buffer);
+		len = other.len;
+		buffer = (char*)malloc (len + 1);
+		memcpy (buffer, other.buffer, len + 1);
+	}
+	return *this;
+}
+
+String::~String () {
+	free (buffer);
+}
+
+String& String::operator+= (const char* other) {
+	size_t otherLen = strlen (other);
+	buffer = (char*)realloc (buffer, len + otherLen + 1);
+	memcpy (buffer + len, other, otherLen + 1);
+	len += otherLen;
+	return *this;
+}
+
+// ---- Filesystem ----
+
+namespace fs {
+
+size_t File::write (const uint8_t* buffer, size_t size) {
+	if (!data || !writable) {
+		return 0;
+	}
+	if (pos + size > data->size ()) {
+		data->resize (pos + size);
+	}
+	memcpy (data->data () + pos, buffer, size);
+	pos += size;
+	return size;
+}
+
+bool FS::begin () {
+	mounted = !mountFails;
+	return mounted;
+}
+
+bool FS::format () {
+	files.clear ();
+	formats++;
+	return true;
+}
+
+bool FS::exists (const char* path) {
+	return mounted && files.count (path);
+}
+
+File FS::open (const char* path, const char* mode) {
+	if (!mounted) {
+		return File ();
+	}
+	if (mode[0] == 'r') {
+		auto it = files.find (path);
+		return it == files.end () ? File () : File (&it->second, mode[1] == '+');
+	}
+	FileData& data = files[path];
+	if (mode[0] == 'w') {
+		data.clear ();
+	}
+	File file (&data, true);
+	if (mode[0] == 'a') {
+		file.seek (data.size ());
+	}
+	return file;
+}
+
+bool FS::remove (const char* path) {
+	return mounted && files.erase (path);
+}
+
+bool FS::rename (const char* pathFrom, const char* pathTo) {
+	auto it = files.find (pathFrom);
+	if (!mounted || it == files.end ()) {
+		return false;
+	}
+	files[pathTo] = it->second;
+	files.erase (it);
+	return true;
+}
+
+FileData* FS::hostFile (const char* path) {
+	auto it = files.find (path);
+	return it == files.end () ? nullptr : &it->second;
+}
+
+} // namespace fs
@@ -0,0 +1,197 @@
+/**
+  * @brief Checks button edges captured from interrupts: debounce from edge times, presses while `loop` is late and
+  * queue overflow
+  *
+  * Simulated GPIO runs attached interrupt handler when `hostSetPinInput` changes pin level, so edges are captured
+  * at the simulated time they happen, no matter when `loop` runs next. Built with `BLIND_BUTTON_ISR=1`.
+  *
+  * @file ButtonCaptureCheck.cpp
+  */
+
+#include "HostCheck.h"
+
+constexpr auto BUTTON_PIN = 5;
+constexpr auto UP_RELAY = 12;
+constexpr auto DEBOUNCE_TIME = 50;
+constexpr auto REPEAT_TIME = 200;
+
+/**
+  * @brief Event given to button callback
+  */
+struct buttonEvent_t {
+	uint8_t event;
+	uint8_t count;
+	uint16_t length;
+};
+
+static std::vector<buttonEvent_t> buttonEvents;
+
+static void recordButtonEvent (uint8_t, uint8_t event, uint8_t count, uint16_t length) {
+	buttonEvents.push_back ({ event, count, length });
+}
+
+static size_t eventsOf (uint8_t event) {
+	size_t count = 0;
+	for (const buttonEvent_t& buttonEvent : buttonEvents) {
+		if (buttonEvent.event == event) {
+			count++;
+		}
+	}
+	return count;
+}
+
+static void runCapture (ButtonCapture& capture, unsigned long ms) {
+	for (unsigned long i = 0; i < ms; i++) {
+		hostAdvanceMillis (1);
+		capture.loop ();
+	}
+}
+
+/**
+  * @brief Sets button pin level after some time with `loop` held back
+  */
+static void edgeAfter (unsigned long ms, int level) {
+	hostAdvanceMillis (ms);
+	hostSetPinInput (BUTTON_PIN, level);
+}
+
+static void checkBounce (ButtonCapture& capture) {
+	buttonEvents.clear ();
+	edgeAfter (0, LOW);
+	edgeAfter (1, HIGH);
+	edgeAfter (2, LOW);
+	runCapture (capture, 100);
+	edgeAfter (0, HIGH);
+	edgeAfter (1, LOW);
+	edgeAfter (3, HIGH);
+	runCapture (capture, REPEAT_TIME);
+	CHECK_EQUAL (buttonEvents.size (), 2);
+	CHECK_EQUAL (buttonEvents[0].event, EVENT_PRESSED);
+	CHECK_EQUAL (buttonEvents[0].count, 1);
+	CHECK_EQUAL (buttonEvents[1].event, EVENT_RELEASED);
+	CHECK_EQUAL (buttonEvents[1].count, 1);
+	CHECK_EQUAL (buttonEvents[1].length, 103);
+	CHECK (!capture.active ());
+
+	// Level left by bounce is read again when debounce time ends
+	buttonEvents.clear ();
+	edgeAfter (0, LOW);
+	edgeAfter (10, HIGH);
+	runCapture (capture, DEBOUNCE_TIME + REPEAT_TIME);
+	CHECK_EQUAL (eventsOf (EVENT_PRESSED), 1);
+	CHECK_EQUAL (eventsOf (EVENT_RELEASED), 1);
+	CHECK_EQUAL (buttonEvents.back ().length, DEBOUNCE_TIME);
+	CHECK (!capture.active ());
+}
+
+static void checkDoublePress (ButtonCapture& capture) {
+	buttonEvents.clear ();
+	edgeAfter (0, LOW);
+	runCapture (capture, 60);
+	edgeAfter (0, HIGH);
+	runCapture (capture, 60);
+	edgeAfter (0, LOW);
+	runCapture (capture, 70);
+	edgeAfter (0, HIGH);
+	runCapture (capture, REPEAT_TIME);
+	CHECK_EQUAL (buttonEvents.size (), 3);
+	CHECK_EQUAL (buttonEvents[0].event, EVENT_PRESSED);
+	CHECK_EQUAL (buttonEvents[0].count, 1);
+	CHECK_EQUAL (buttonEvents[1].event, EVENT_PRESSED);
+	CHECK_EQUAL (buttonEvents[1].count, 2);
+	CHECK_EQUAL (buttonEvents[2].event, EVENT_RELEASED);
+	CHECK_EQUAL (buttonEvents[2].count, 2);
+	CHECK_EQUAL (buttonEvents[2].length, 70);
+}
+
+static void checkSlowLoop (ButtonCapture& capture) {
+	// Two presses while loop is busy are neither merged nor measured from loop time
+	buttonEvents.clear ();
+	edgeAfter (0, LOW);
+	edgeAfter (100, HIGH);
+	edgeAfter (60, LOW);
+	edgeAfter (80, HIGH);
+	hostAdvanceMillis (1000);
+	CHECK (capture.active ());
+	runCapture (capture, 1);
+	CHECK_EQUAL (buttonEvents.size (), 3);
+	CHECK_EQUAL (buttonEvents[1].event, EVENT_PRESSED);
+	CHECK_EQUAL (buttonEvents[1].count, 2);
+	CHECK_EQUAL (buttonEvents[2].event, EVENT_RELEASED);
+	CHECK_EQUAL (buttonEvents[2].length, 80);
+	CHECK (!capture.active ());
+}
+
+static void checkOverflow (ButtonCapture& capture) {
+	// Queue keeps BUTTON_EDGE_QUEUE_SIZE - 1 edges. Last stored one is a press, but button ends released
+	buttonEvents.clear ();
+	for (int edge = 0; edge < BUTTON_EDGE_QUEUE_SIZE + 10; edge++) {
+		edgeAfter (DEBOUNCE_TIME + 10, edge % 2 ? HIGH : LOW);
+	}
+	CHECK_EQUAL (hostPinLevel (BUTTON_PIN), HIGH);
+	CHECK (capture.active ());
+	runCapture (capture, 1);
+	CHECK_EQUAL (eventsOf (EVENT_PRESSED), BUTTON_EDGE_QUEUE_SIZE / 2);
+	runCapture (capture, REPEAT_TIME);
+	CHECK_EQUAL (eventsOf (EVENT_RELEASED), 1);
+	CHECK (!capture.active ());
+
+	// Edges are captured again
+	buttonEvents.clear ();
+	edgeAfter (0, LOW);
+	runCapture (capture, 100);
+	edgeAfter (0, HIGH);
+	runCapture (capture, REPEAT_TIME + 1);
+	CHECK_EQUAL (buttonEvents.size (), 2);
+	CHECK_EQUAL (buttonEvents[0].count, 1);
+	CHECK_EQUAL (buttonEvents[1].length, 100);
+}
+
+#if BLIND_BUTTON_ISR
+static void checkController () {
+	// Double press while loop is busy starts a full roll up
+	CheckController<1>* controller = new CheckController<1> ();
+	controller->setSendData (recordUplink);
+	blindControlerHw_t hw = checkHardware ();
+	hw.upButton = BUTTON_PIN;
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, &hw);
+	controller->run (100);
+	relayWrites.clear ();
+	edgeAfter (0, LOW);
+	edgeAfter (60, HIGH);
+	edgeAfter (60, LOW);
+	edgeAfter (60, HIGH);
+	hostAdvanceMillis (500);
+	controller->run (1);
+	CHECK_EQUAL (lastRelayWrite (UP_RELAY, HIGH), millis ());
+	CHECK_EQUAL (controller->getState (), rollingUp);
+	controller->run (REPEAT_TIME);
+	CHECK_EQUAL (hostPinLevel (UP_RELAY), HIGH); // Release does not stop a full movement
+	CHECK (uplinkContains ("\"but\":\"up\",\"num\":2"));
+	delete controller;
+}
+#endif
+
+int main () {
+	SPIFFS.begin ();
+	hostSetMillis (1000);
+	hostOnDigitalWrite (recordRelayWrite);
+
+	buttonInput_t inputs[1];
+	ButtonCapture* capture = new ButtonCapture (inputs, 1);
+	capture->begin (0, BUTTON_PIN, recordButtonEvent, DEBOUNCE_TIME, REPEAT_TIME);
+	runCapture (*capture, 10);
+	CHECK (buttonEvents.empty ());
+	checkBounce (*capture);
+	checkDoublePress (*capture);
+	checkSlowLoop (*capture);
+	checkOverflow (*capture);
+	delete capture;
+
+#if BLIND_BUTTON_ISR
+	checkController ();
+#endif
+
+	return checkResult ("button capture");
+}
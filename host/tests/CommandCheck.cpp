@@ -0,0 +1,226 @@
+/**
+  * @brief Checks relay writes and responses of every command added after the original `uu`, `dd`, `go`, `stop`
+  * and `time` ones
+  *
+  * @file CommandCheck.cpp
+  */
+
+#include "HostCheck.h"
+
+constexpr auto UP_RELAY = 12;
+constexpr auto DOWN_RELAY = 13;
+constexpr auto TRAVEL_TIME = 30000;
+constexpr auto FULL_MOVEMENT = TRAVEL_TIME * 11 / 10 + 1000; ///< @brief Full movements run 10 % longer
+constexpr int64_t MONDAY_0729 = 1704067200000LL + (7 * 60 + 29) * 60000LL; ///< @brief 2024-01-01 07:29 UTC
+
+static CheckController<1>* controller;
+
+static void clearRecords () {
+	relayWrites.clear ();
+	uplinkMessages.clear ();
+}
+
+static size_t relayWritesOf (uint16_t pin, uint8_t level) {
+	size_t count = 0;
+	for (const relayWrite_t& write : relayWrites) {
+		if (write.pin == pin && write.level == level) {
+			count++;
+		}
+	}
+	return count;
+}
+
+static bool lastUplinkIs (const char* text) {
+	return !uplinkMessages.empty () && uplinkMessages.back ().find (text) != std::string::npos;
+}
+
+static void checkSequence () {
+	clearRecords ();
+	unsigned long sent = millis ();
+	CHECK (controller->set ("{\"cmd\":\"seq\",\"steps\":[{\"pos\":30},{\"wait\":2000},{\"pos\":60}]}"));
+	CHECK (uplinkContains ("\"cmd\":\"seq\",\"res\":1"));
+	controller->run (TRAVEL_TIME);
+	CHECK_EQUAL (relayWritesOf (UP_RELAY, HIGH), 2);
+	CHECK_EQUAL (relayWritesOf (DOWN_RELAY, HIGH), 0);
+	unsigned long firstOn = firstRelayWrite (UP_RELAY, HIGH, sent);
+	unsigned long firstOff = firstRelayWrite (UP_RELAY, LOW, firstOn + 1); // Relay is also set off just before going on
+	CHECK_EQUAL (firstOff - firstOn, TRAVEL_TIME * 30 / 100 + CUTOFF_DELAY);
+	unsigned long secondOn = lastRelayWrite (UP_RELAY, HIGH);
+	CHECK (secondOn >= firstOff + 2000);
+	CHECK_EQUAL (firstRelayWrite (UP_RELAY, LOW, secondOn + 1) - secondOn, TRAVEL_TIME * 30 / 100 + CUTOFF_DELAY);
+	CHECK_EQUAL (controller->getAngle (), 60);
+	CHECK (lastUplinkIs ("\"state\":4,\"pos\":60"));
+}
+
+static void checkStartTime () {
+	clearRecords ();
+	EnigmaIOTNode.hostSetClockOffset (MONDAY_0729 - millis ());
+	unsigned long sent = millis ();
+	char command[64];
+	snprintf (command, sizeof (command), "{\"cmd\":\"go\",\"pos\":80,\"at\":%lld}", (long long)EnigmaIOTNode.clock () + 5000);
+	CHECK (controller->set (command));
+	CHECK (uplinkContains ("\"cmd\":\"go\",\"res\":1"));
+	controller->run (4000);
+	CHECK_EQUAL (relayWritesOf (UP_RELAY, HIGH), 0);
+	controller->run (TRAVEL_TIME);
+	CHECK_EQUAL (firstRelayWrite (UP_RELAY, HIGH, sent) - sent, 5000);
+	CHECK_EQUAL (controller->getAngle (), 80);
+
+	// Too far ahead
+	clearRecords ();
+	snprintf (command, sizeof (command), "{\"cmd\":\"go\",\"pos\":20,\"at\":%lld}", (long long)EnigmaIOTNode.clock () + 7200000);
+	controller->set (command);
+	CHECK (uplinkContains ("\"cmd\":\"go\",\"res\":0"));
+	controller->run (1000);
+	CHECK (relayWrites.empty ());
+}
+
+static void checkGroups () {
+	clearRecords ();
+	CHECK (controller->set ("{\"cmd\":\"groups\",\"groups\":[2,5]}"));
+	CHECK (uplinkContains ("\"cmd\":\"groups\",\"groups\":[2,5]"));
+
+	// Other group. Nothing moves
+	clearRecords ();
+	controller->set ("{\"cmd\":\"dd\",\"grp\":3}");
+	controller->run (1000);
+	CHECK (relayWrites.empty ());
+	CHECK (uplinkMessages.empty ());
+
+	// Own group. Blind moves without command response
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":50,\"grp\":5}"));
+	controller->run (TRAVEL_TIME);
+	CHECK_EQUAL (relayWritesOf (DOWN_RELAY, HIGH), 1);
+	CHECK (!uplinkContains ("\"cmd\""));
+	CHECK_EQUAL (controller->getAngle (), 50);
+	CHECK (lastUplinkIs ("\"state\":4,\"pos\":50"));
+}
+
+static void checkPresets () {
+	clearRecords ();
+	CHECK (controller->set ("{\"cmd\":\"save\",\"id\":1,\"pos\":40}"));
+	CHECK (controller->set ("{\"cmd\":\"save\",\"id\":2,\"pos\":70}"));
+	CHECK (lastUplinkIs ("\"cmd\":\"preset\",\"presets\":[40,70,-1,-1],\"up\":[0,0,0],\"down\":[0,0,0]"));
+	CHECK (relayWrites.empty ());
+
+	clearRecords ();
+	CHECK (controller->set ("{\"cmd\":\"preset\",\"id\":1}"));
+	CHECK (uplinkContains ("\"cmd\":\"preset\",\"res\":1"));
+	controller->run (TRAVEL_TIME);
+	CHECK_EQUAL (relayWritesOf (DOWN_RELAY, HIGH), 1);
+	CHECK_EQUAL (controller->getAngle (), 40);
+
+	// Preset that is not set
+	clearRecords ();
+	CHECK (!controller->set ("{\"cmd\":\"preset\",\"id\":3}"));
+	CHECK (uplinkContains ("\"cmd\":\"preset\",\"res\":0"));
+	controller->run (1000);
+	CHECK (relayWrites.empty ());
+
+	// One byte recall of preset 2 on blind 0
+	clearRecords ();
+	uint8_t recall[] = { 0x02 };
+	CHECK (controller->processRxCommand (NULL, recall, sizeof (recall), nodeMessageType_t::DOWNSTREAM_DATA_SET, MSG_PACK));
+	CHECK (uplinkContains ("\"cmd\":\"preset\",\"res\":1"));
+	controller->run (TRAVEL_TIME);
+	CHECK_EQUAL (relayWritesOf (UP_RELAY, HIGH), 1);
+	CHECK_EQUAL (controller->getAngle (), 70);
+
+	clearRecords ();
+	CHECK (controller->get ("{\"cmd\":\"preset\"}"));
+	CHECK (uplinkContains ("\"presets\":[40,70,-1,-1]"));
+}
+
+static void checkSchedule () {
+	clearRecords ();
+	EnigmaIOTNode.hostSetClockOffset (MONDAY_0729 - millis ());
+	unsigned long sent = millis ();
+	CHECK (controller->set ("{\"cmd\":\"sched\",\"id\":1,\"hhmm\":730,\"days\":1,\"do\":\"dd\"}"));
+	CHECK (lastUplinkIs ("\"cmd\":\"sched\",\"tz\":0,\"sched\":[[1,730,1,\"dd\",0,0,0,0]]"));
+	controller->run (59000);
+	CHECK (relayWrites.empty ());
+	controller->run (1000 + FULL_MOVEMENT);
+	CHECK_EQUAL (firstRelayWrite (DOWN_RELAY, HIGH, sent) - sent, 60000);
+	CHECK_EQUAL (controller->getAngle (), 0);
+
+	// Entry is removed
+	clearRecords ();
+	CHECK (controller->set ("{\"cmd\":\"sched\",\"id\":1}"));
+	CHECK (lastUplinkIs ("\"sched\":[]"));
+	CHECK (controller->get ("{\"cmd\":\"sched\"}"));
+	CHECK (lastUplinkIs ("\"sched\":[]"));
+}
+
+static void checkGet () {
+	clearRecords ();
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":30}"));
+	controller->run (1 + TRAVEL_TIME * 10 / 100); // Relay goes on on first loop after command
+	CHECK (controller->get ("{\"cmd\":\"get\",\"keys\":[\"state\",\"pos\",\"to\",\"eta\"]}"));
+	CHECK (lastUplinkIs ("\"cmd\":\"get\",\"state\":1,\"pos\":10,\"to\":30,\"eta\":6000"));
+	controller->run (TRAVEL_TIME);
+	CHECK (controller->get ("{\"cmd\":\"get\",\"keys\":[\"pos\",\"groups\"]}"));
+	CHECK (lastUplinkIs ("\"cmd\":\"get\",\"pos\":30,\"groups\":[2,5]"));
+	CHECK (controller->get ("{\"cmd\":\"get\"}"));
+	CHECK (lastUplinkIs ("\"cmd\":\"get\",\"state\":4,\"pos\":30,\"to\":30,\"eta\":0,\"time\":30000"));
+	size_t sent = uplinkMessages.size ();
+	CHECK (!controller->get ("{\"cmd\":\"get\",\"keys\":[\"speed\"]}"));
+	CHECK_EQUAL (uplinkMessages.size (), sent);
+}
+
+static void checkStats () {
+	clearRecords ();
+	CHECK (controller->get ("{\"cmd\":\"stats\"}"));
+	CHECK_EQUAL (uplinkMessages.size (), 1);
+	CHECK (uplinkContains ("\"cmd\":\"stats\",\"loop\":["));
+	CHECK (uplinkContains ("\"relay\":["));
+	CHECK (uplinkContains ("\"fail\":0,\"drop\":0"));
+	CHECK (relayWrites.empty ());
+}
+
+static void checkMergedResponses () {
+	controller->config.mergedResponse = true;
+	clearRecords ();
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":60}"));
+	CHECK_EQUAL (uplinkMessages.size (), 1);
+	CHECK (lastUplinkIs ("\"cmd\":\"go\",\"res\":1,\"state\":1,\"pos\":30,\"to\":60,\"eta\":9000"));
+	controller->run (TRAVEL_TIME / 10);
+	CHECK_EQUAL (uplinkMessages.size (), 1); // Start notification is not sent
+
+	clearRecords ();
+	CHECK (controller->set ("{\"cmd\":\"stop\"}"));
+	CHECK_EQUAL (relayWritesOf (UP_RELAY, LOW), 1);
+	CHECK_EQUAL (uplinkMessages.size (), 1);
+	CHECK (lastUplinkIs ("\"cmd\":\"stop\",\"res\":1,\"state\":4,\"pos\":40,\"to\":40,\"eta\":0"));
+	controller->run (1000);
+	CHECK_EQUAL (uplinkMessages.size (), 1); // Stop notification is not sent
+	controller->config.mergedResponse = false;
+}
+
+int main () {
+	SPIFFS.begin ();
+	hostSetMillis (1000);
+	hostClearRtcMemory ();
+	hostOnDigitalWrite (recordRelayWrite);
+	controller = new CheckController<1> ();
+	controller->setSendData (recordUplink);
+	blindControlerHw_t hw = checkHardware ();
+	hw.clockSync = true;
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, &hw);
+	controller->run (100);
+	CHECK (controller->set ("{\"cmd\":\"dd\"}"));
+	controller->run (FULL_MOVEMENT);
+	CHECK_EQUAL (controller->getAngle (), 0);
+
+	checkSequence ();
+	checkStartTime ();
+	checkGroups ();
+	checkPresets ();
+	checkSchedule ();
+	checkGet ();
+	checkStats ();
+	checkMergedResponses ();
+
+	delete controller;
+	return checkResult ("commands");
+}
@@ -0,0 +1,111 @@
+/**
+  * @brief Checks that configuration records written by every older version are loaded, and that fields added
+  * by later versions keep their defaults
+  *
+  * Older firmware stored `sizeof` of its record, padding included. Records are rebuilt here the same way.
+  *
+  * @file ConfigRecordCheck.cpp
+  */
+
+#include "HostCheck.h"
+#include <RecordFile.h>
+#include <FS.h>
+
+constexpr auto CONFIG_FILE = "/blindconf.bin";
+constexpr auto CONFIG_MAGIC = 0x46434C42;
+constexpr auto LAST_OLD_VERSION = 8;
+
+#define RECORD_END(field) (offsetof (blindConfigRecord_t, field) + sizeof (blindConfigRecord_t::field))
+static const size_t recordEnd[LAST_OLD_VERSION] = {
+	RECORD_END (curvePoints),
+	RECORD_END (channelTravellingTime),
+	RECORD_END (runOnTime),
+	RECORD_END (groups),
+	RECORD_END (clockSync),
+	RECORD_END (relayDeadTime),
+	RECORD_END (downPressPreset),
+	RECORD_END (utcOffset),
+};
+
+/**
+  * @brief Record with every field set to a value that is not its default
+  */
+static void fillRecord (blindConfigRecord_t& record) {
+	memset (&record, 0, sizeof (record));
+	record.fullTravellingTime = 45000;
+	record.reportMinInterval = 3000;
+	record.reportMaxInterval = 900000;
+	record.reportStep = 10;
+	record.curveProfile = CURVE_LINEAR;
+	record.upTravellingTime[0] = 40000;
+	record.startDelay[0] = 300;
+	record.runOnTime[0] = 200;
+	record.groups[0] = 0x05;
+	record.clockSync = 1;
+	record.relayDeadTime[0] = 800;
+	memset (record.presets, -1, sizeof (record.presets));
+	record.presets[0][0] = 40;
+	record.upPressPreset[0][0] = 1;
+	record.schedule[0] = { 510, 30, 0x1F, 0, ACTION_FULL_UP, 0, 0 };
+	record.utcOffset = 60;
+	record.mergedResponse = 1;
+}
+
+static void checkVersion (uint16_t version) {
+	blindConfigRecord_t record;
+	fillRecord (record);
+	// Old writers cleared the record, so fields they did not know and padding after last one were stored as 0
+	size_t end = recordEnd[version - 1];
+	size_t size = (end + alignof (blindConfigRecord_t) - 1) / alignof (blindConfigRecord_t) * alignof (blindConfigRecord_t);
+	memset ((uint8_t*)&record + end, 0, sizeof (record) - end);
+	SPIFFS.remove (CONFIG_FILE);
+	CHECK (RecordFile::write (CONFIG_FILE, CONFIG_MAGIC, version, &record, size));
+
+	CheckController<1>* controller = new CheckController<1> ();
+	CHECK (controller->loadConfig ());
+	const blindChannelHw_t& channel = controller->channelConfig[0];
+	const blindConfig_t& config = controller->config;
+	printf ("Version %u. %u bytes\n", version, (unsigned)size);
+
+	CHECK_EQUAL (channel.fullTravellingTime, 45000);
+	CHECK_EQUAL (config.reportStep, 10);
+	CHECK_EQUAL (channel.upTravellingTime, version >= 3 ? 40000 : 0);
+	CHECK_EQUAL (channel.startDelay, version >= 3 ? 300 : 0);
+	CHECK_EQUAL (channel.groups, version >= 4 ? 0x05 : 0);
+	CHECK_EQUAL (config.clockSync, version >= 5);
+	CHECK_EQUAL (channel.relayDeadTime, version >= 6 ? 800 : 500);
+	for (int preset = 0; preset < BLIND_PRESETS; preset++) {
+		CHECK_EQUAL (channel.presets[preset], version >= 7 && preset == 0 ? 40 : -1);
+	}
+	CHECK_EQUAL (channel.upPressPreset[0], version >= 7 ? 1 : 0);
+	CHECK_EQUAL (config.schedule[0].days, version >= 8 ? 0x1F : 0);
+	CHECK_EQUAL (config.utcOffset, version >= 8 ? 60 : 0);
+	CHECK_EQUAL (config.mergedResponse, false);
+	delete controller;
+}
+
+int main () {
+	SPIFFS.begin ();
+	for (uint16_t version = 1; version <= LAST_OLD_VERSION; version++) {
+		checkVersion (version);
+	}
+
+	// Current version is read back as it was saved
+	SPIFFS.remove (CONFIG_FILE);
+	CheckController<1>* controller = new CheckController<1> ();
+	controller->loadConfig ();
+	controller->channelConfig[0].relayDeadTime = 700;
+	controller->channelConfig[0].presets[3] = 20;
+	controller->config.mergedResponse = true;
+	CHECK (controller->saveConfig ());
+	delete controller;
+	controller = new CheckController<1> ();
+	CHECK (controller->loadConfig ());
+	CHECK_EQUAL (controller->channelConfig[0].relayDeadTime, 700);
+	CHECK_EQUAL (controller->channelConfig[0].presets[3], 20);
+	CHECK_EQUAL (controller->channelConfig[0].presets[0], -1);
+	CHECK_EQUAL (controller->config.mergedResponse, true);
+	delete controller;
+
+	return checkResult ("config record");
+}
@@ -0,0 +1,187 @@
+/**
+  * @brief Helpers shared by host checks
+  *
+  * Every check program builds controllers on the simulated board, drives them with commands and simulated time
+  * and compares relay writes and uplink messages with expected ones. `CHECK` failures are counted and printed,
+  * and `checkResult` gives process exit code, so checks run as ctest cases.
+  *
+  * @file HostCheck.h
+  */
+
+#ifndef _HOST_CHECK_h
+#define _HOST_CHECK_h
+
+#include <BlindController.h>
+#include <string>
+#include <vector>
+
+#define CHECK(condition) hostCheck ((condition), #condition, __FILE__, __LINE__)
+#define CHECK_EQUAL(actual, expected) hostCheckEqual ((long long)(actual), (long long)(expected), #actual, __FILE__, __LINE__)
+
+#if BLIND_RELAY_TIMER
+constexpr unsigned long CUTOFF_DELAY = 0; ///< @brief Relay goes off on movement deadline from cutoff timer
+#else
+constexpr unsigned long CUTOFF_DELAY = 2; ///< @brief Relay goes off from `loop`. First pass after deadline stops movement and next one switches relay off
+#endif
+
+static int checkFailures = 0;
+
+static inline bool hostCheck (bool condition, const char* text, const char* file, int line) {
+	if (!condition) {
+		printf ("%s:%d: check failed: %s\n", file, line, text);
+		checkFailures++;
+	}
+	return condition;
+}
+
+static inline bool hostCheckEqual (long long actual, long long expected, const char* text, const char* file, int line) {
+	if (actual != expected) {
+		printf ("%s:%d: check failed: %s is %lld, expected %lld\n", file, line, text, actual, expected);
+		checkFailures++;
+	}
+	return actual == expected;
+}
+
+static inline int checkResult (const char* name) {
+	printf ("%s: %s\n", name, checkFailures ? "FAILED" : "passed");
+	return checkFailures ? 1 : 0;
+}
+
+/**
+  * @brief Relay write seen on a pin
+  */
+struct relayWrite_t {
+	unsigned long time;
+	uint16_t pin;
+	uint8_t level;
+};
+
+static std::vector<relayWrite_t> relayWrites;
+static std::vector<std::string> uplinkMessages; ///< @brief Every uplink message as JSON text
+static bool uplinkFails = false; ///< @brief Radio rejects every send while set
+
+static inline void recordRelayWrite (uint16_t pin, uint8_t val) {
+	relayWrites.push_back ({ millis (), pin, val });
+}
+
+static inline bool recordUplink (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding) {
+	if (uplinkFails) {
+		return false;
+	}
+	std::string text;
+	if (encoding == MSG_PACK) {
+		DynamicJsonDocument json (8192); // Full schedule takes around 80 slots
+		deserializeMsgPack (json, data, length);
+		char buffer[512];
+		serializeJson (json, buffer, sizeof (buffer));
+		text = buffer;
+	} else {
+		text.assign ((const char*)data, length);
+	}
+	uplinkMessages.push_back (text);
+	return true;
+}
+
+/**
+  * @brief Gets time of last write of `level` to `pin`. 0 if there is none
+  */
+static inline unsigned long lastRelayWrite (uint16_t pin, uint8_t level) {
+	for (auto write = relayWrites.rbegin (); write != relayWrites.rend (); write++) {
+		if (write->pin == pin && write->level == level) {
+			return write->time;
+		}
+	}
+	return 0;
+}
+
+/**
+  * @brief Gets time of first write of `level` to `pin` not before `after`. 0 if there is none
+  */
+static inline unsigned long firstRelayWrite (uint16_t pin, uint8_t level, unsigned long after) {
+	for (const relayWrite_t& write : relayWrites) {
+		if (write.pin == pin && write.level == level && write.time >= after) {
+			return write.time;
+		}
+	}
+	return 0;
+}
+
+/**
+  * @brief Checks if a message containing `text` was sent
+  */
+static inline bool uplinkContains (const char* text) {
+	for (const std::string& message : uplinkMessages) {
+		if (message.find (text) != std::string::npos) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <uint8_t CHANNELS>
+class CheckController : public MultiBlindController<CHANNELS> {
+public:
+	typedef MultiBlindController<CHANNELS> Base;
+	using Base::loadConfig;
+	using Base::saveConfig;
+	using Base::getState;
+	using Base::getAngle;
+	using Base::idleTime;
+	using Base::config;
+	using Base::channelConfig;
+
+	void setSendData (sendData_cb cb) {
+		((::EnigmaIOTjsonController*)this)->sendDataCallback (cb);
+	}
+
+	/**
+	  * @brief Sends a JSON command encoded as MsgPack
+	  * @return Result of `processRxCommand`
+	  */
+	bool command (nodeMessageType_t type, const char* text) {
+		DynamicJsonDocument json (2048);
+		uint8_t buffer[128];
+		deserializeJson (json, text);
+		size_t length = serializeMsgPack (json, buffer, sizeof (buffer));
+		return this->processRxCommand (NULL, buffer, length, type, MSG_PACK);
+	}
+
+	bool set (const char* text) {
+		return command (nodeMessageType_t::DOWNSTREAM_DATA_SET, text);
+	}
+
+	bool get (const char* text) {
+		return command (nodeMessageType_t::DOWNSTREAM_DATA_GET, text);
+	}
+
+	/**
+	  * @brief Runs loop every ms for `ms` ms
+	  */
+	void run (unsigned long ms) {
+		for (unsigned long i = 0; i < ms; i++) {
+			hostAdvanceMillis (1);
+			this->loop ();
+		}
+	}
+};
+
+/**
+  * @brief Default single blind hardware: relays on pins 12 and 13, no buttons, 30 s travel time
+  */
+static inline blindControlerHw_t checkHardware () {
+	blindControlerHw_t hw;
+	memset (&hw, 0, sizeof (hw));
+	hw.upRelayPin = 12;
+	hw.downRelayPin = 13;
+	hw.upButton = NO_BUTTON;
+	hw.downButton = NO_BUTTON;
+	hw.fullTravellingTime = 30000;
+	hw.ON_STATE = HIGH;
+	hw.curveProfile = CURVE_LINEAR;
+	hw.reportStep = 20;
+	hw.reportMinInterval = 2000;
+	hw.reportMaxInterval = 600000;
+	return hw;
+}
+
+#endif
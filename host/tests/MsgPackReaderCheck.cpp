@@ -0,0 +1,71 @@
+/**
+  * @brief Checks `MsgPackReader` against malformed and hostile radio payloads
+  *
+  * @file MsgPackReaderCheck.cpp
+  */
+
+#include "HostCheck.h"
+#include <MsgPackReader.h>
+#include <cmath>
+
+static bool readFloat32 (float number, int64_t& value) {
+	uint32_t bits;
+	memcpy (&bits, &number, sizeof (bits));
+	uint8_t buffer[] = { 0xCA, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+	MsgPackReader reader (buffer, sizeof (buffer));
+	return reader.readInt64 (value);
+}
+
+static bool readFloat64 (double number, int64_t& value) {
+	uint64_t bits;
+	memcpy (&bits, &number, sizeof (bits));
+	uint8_t buffer[9] = { 0xCB };
+	for (int i = 0; i < 8; i++) {
+		buffer[1 + i] = bits >> (56 - 8 * i);
+	}
+	MsgPackReader reader (buffer, sizeof (buffer));
+	return reader.readInt64 (value);
+}
+
+int main () {
+	// Received strings are not null terminated and may hold null characters
+	const char received[] = { 'g', 'o', '\0', 'x', 'y', 'z' };
+	CHECK (!MsgPackReader::equals (received, sizeof (received), "go"));
+	CHECK (MsgPackReader::equals (received, 2, "go"));
+	CHECK (!MsgPackReader::equals (received, 1, "go"));
+	CHECK (!MsgPackReader::equals ("stop", 4, "st"));
+	CHECK (MsgPackReader::equals ("", 0, ""));
+
+	int64_t value = 0;
+	CHECK (readFloat32 (42.7f, value));
+	CHECK_EQUAL (value, 42);
+	CHECK (readFloat64 (-17.2, value));
+	CHECK_EQUAL (value, -17);
+	CHECK (!readFloat32 (NAN, value));
+	CHECK (!readFloat64 (NAN, value));
+	CHECK (readFloat32 (INFINITY, value));
+	CHECK (value == INT64_MAX);
+	CHECK (readFloat64 (-1e300, value));
+	CHECK (value == INT64_MIN);
+	CHECK (readFloat64 (1e19, value));
+	CHECK (value == INT64_MAX);
+
+	// Rejected value is left on buffer
+	uint8_t nan[] = { 0xCB, 0x7F, 0xF8, 0, 0, 0, 0, 0, 0 };
+	MsgPackReader reader (nan, sizeof (nan));
+	int32_t number;
+	CHECK (!reader.readInt (number));
+	CHECK (reader.skip ());
+	CHECK (reader.atEnd ());
+
+	// Commands with a NaN position are rejected
+	CheckController<1>* controller = new CheckController<1> ();
+	blindControlerHw_t hw = checkHardware ();
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, &hw);
+	uint8_t go[] = { 0x82, 0xA3, 'c', 'm', 'd', 0xA2, 'g', 'o', 0xA3, 'p', 'o', 's', 0xCB, 0x7F, 0xF8, 0, 0, 0, 0, 0, 0 };
+	CHECK (!controller->processRxCommand (NULL, go, sizeof (go), nodeMessageType_t::DOWNSTREAM_DATA_SET, MSG_PACK));
+	delete controller;
+
+	return checkResult ("msgpack reader");
+}
@@ -0,0 +1,78 @@
+/**
+  * @brief Checks position restored after a reboot, both from a stopped blind and from one that was moving,
+  * after a reset and after a power cut
+  *
+  * @file PositionRestoreCheck.cpp
+  */
+
+#include "HostCheck.h"
+
+constexpr auto TRAVEL_TIME = 30000;
+
+static CheckController<1>* boot () {
+	CheckController<1>* controller = new CheckController<1> ();
+	controller->setSendData (recordUplink);
+	blindControlerHw_t hw = checkHardware ();
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, &hw);
+	controller->run (100);
+	return controller;
+}
+
+int main () {
+	SPIFFS.begin ();
+	hostSetMillis (1000);
+	hostClearRtcMemory ();
+	CheckController<1>* controller = boot ();
+	CHECK_EQUAL (controller->getAngle (), -1);
+	CHECK (controller->set ("{\"cmd\":\"dd\"}"));
+	controller->run (TRAVEL_TIME * 11 / 10 + 1000);
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":40}"));
+	controller->run (TRAVEL_TIME);
+	CHECK_EQUAL (controller->getState (), stopped);
+	CHECK_EQUAL (controller->getAngle (), 40);
+
+	// Reset while stopped. Position comes from RTC memory
+	delete controller;
+	controller = boot ();
+	CHECK_EQUAL (controller->getAngle (), 40);
+
+	// Power cut while stopped. Position comes from journal
+	delete controller;
+	hostClearRtcMemory ();
+	controller = boot ();
+	CHECK_EQUAL (controller->getAngle (), 40);
+
+	// Reset while moving. Blind has to be calibrated again
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":80}"));
+	controller->run (TRAVEL_TIME / 5);
+	CHECK_EQUAL (controller->getState (), rollingUp);
+	delete controller;
+	controller = boot ();
+	CHECK_EQUAL (controller->getAngle (), -1);
+	CHECK_EQUAL (controller->getState (), stopped);
+
+	// Still unknown after another reset, until it is calibrated
+	delete controller;
+	controller = boot ();
+	CHECK_EQUAL (controller->getAngle (), -1);
+	CHECK (controller->set ("{\"cmd\":\"uu\"}"));
+	controller->run (TRAVEL_TIME * 11 / 10 + 1000);
+	CHECK_EQUAL (controller->getAngle (), 100);
+	delete controller;
+	controller = boot ();
+	CHECK_EQUAL (controller->getAngle (), 100);
+
+	// Power cut while moving. Journal holds a moving record, not the previous stopped one
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":60}"));
+	controller->run (TRAVEL_TIME / 5);
+	CHECK_EQUAL (controller->getState (), rollingDown);
+	delete controller;
+	hostClearRtcMemory ();
+	controller = boot ();
+	CHECK_EQUAL (controller->getAngle (), -1);
+	CHECK_EQUAL (controller->getState (), stopped);
+
+	delete controller;
+	return checkResult ("position restore");
+}
@@ -0,0 +1,77 @@
+/**
+  * @brief Checks that relay cutoff timer ends movements on their deadline when main loop is late
+  *
+  * Simulated Ticker fires on its exact deadline while time is advanced, so `loop` may be held back for any time.
+  * Built with `BLIND_RELAY_TIMER=0` it checks that relays are switched off from `loop` instead, as soon as it runs.
+  *
+  * @file RelayCutoffCheck.cpp
+  */
+
+#include "HostCheck.h"
+
+constexpr auto UP_RELAY = 12;
+constexpr auto TRAVEL_TIME = 30000;
+
+static bool lastUplinkIs (const char* text) {
+	return !uplinkMessages.empty () && uplinkMessages.back ().find (text) != std::string::npos;
+}
+
+int main () {
+	SPIFFS.begin ();
+	hostSetMillis (1000);
+	hostOnDigitalWrite (recordRelayWrite);
+	CheckController<1>* controller = new CheckController<1> ();
+	controller->setSendData (recordUplink);
+	blindControlerHw_t hw = checkHardware ();
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, &hw);
+	controller->run (100);
+	CHECK (controller->set ("{\"cmd\":\"dd\"}"));
+	controller->run (TRAVEL_TIME * 11 / 10 + 1000); // Full movements run 10 % longer
+	CHECK_EQUAL (controller->getAngle (), 0);
+
+	// Loop is late. Relay goes off on deadline and position is exact
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":50}"));
+	controller->run (1);
+	unsigned long on = lastRelayWrite (UP_RELAY, HIGH);
+	CHECK (on != 0);
+	hostAdvanceMillis (20000);
+#if BLIND_RELAY_TIMER
+	CHECK_EQUAL (hostPinLevel (UP_RELAY), LOW);
+	CHECK_EQUAL (firstRelayWrite (UP_RELAY, LOW, on), on + TRAVEL_TIME / 2);
+#else
+	CHECK_EQUAL (hostPinLevel (UP_RELAY), HIGH); // Relay waits for loop
+#endif
+	controller->run (1 + CUTOFF_DELAY);
+	CHECK_EQUAL (hostPinLevel (UP_RELAY), LOW);
+	CHECK_EQUAL (controller->getState (), stopped);
+	CHECK_EQUAL (controller->getAngle (), 50);
+	CHECK (lastUplinkIs ("\"state\":4,\"pos\":50"));
+
+	// Retarget comes after timer switched relay off but before loop sees the deadline
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":80}"));
+	controller->run (1);
+	on = lastRelayWrite (UP_RELAY, HIGH);
+	unsigned long deadline = on + TRAVEL_TIME * 30 / 100;
+	hostAdvanceMillis (deadline - millis ());
+#if BLIND_RELAY_TIMER
+	CHECK_EQUAL (hostPinLevel (UP_RELAY), LOW);
+#endif
+	CHECK (controller->set ("{\"cmd\":\"go\",\"pos\":90}"));
+	controller->run (5000);
+	unsigned long restart = lastRelayWrite (UP_RELAY, HIGH);
+#if BLIND_RELAY_TIMER
+	CHECK (restart >= deadline); // Motor runs again for the rest of the movement
+	CHECK_EQUAL (firstRelayWrite (UP_RELAY, LOW, restart), restart + TRAVEL_TIME / 10);
+#else
+	CHECK_EQUAL (restart, on); // Relay was still on, so movement is extended
+	CHECK_EQUAL (firstRelayWrite (UP_RELAY, LOW, on + 1), on + TRAVEL_TIME * 40 / 100 + CUTOFF_DELAY);
+#endif
+	CHECK_EQUAL (hostPinLevel (UP_RELAY), LOW);
+	CHECK_EQUAL (controller->getState (), stopped);
+	CHECK_EQUAL (controller->getAngle (), 90);
+	CHECK (lastUplinkIs ("\"state\":4,\"pos\":90"));
+
+	delete controller;
+	return checkResult ("relay cutoff");
+}
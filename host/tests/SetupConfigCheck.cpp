@@ -0,0 +1,62 @@
+/**
+  * @brief Checks that hardware passed to `setup` only sets pins once a configuration is stored
+  *
+  * @file SetupConfigCheck.cpp
+  */
+
+#include "HostCheck.h"
+
+static void twoBlindHardware (blindControlerHw_t (&hw)[2]) {
+	hw[0] = checkHardware ();
+	hw[1] = checkHardware ();
+	hw[1].upRelayPin = 14;
+	hw[1].downRelayPin = 15;
+}
+
+static CheckController<2>* boot (blindControlerHw_t (&hw)[2]) {
+	CheckController<2>* controller = new CheckController<2> ();
+	controller->setSendData (recordUplink);
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, hw);
+	return controller;
+}
+
+int main () {
+	SPIFFS.begin ();
+	hostSetMillis (1000);
+	blindControlerHw_t hw[2];
+	twoBlindHardware (hw);
+
+	// Nothing stored. Every setting comes from parameter
+	CheckController<2>* controller = boot (hw);
+	CHECK_EQUAL (controller->config.curveProfile, CURVE_LINEAR);
+	CHECK_EQUAL (controller->config.reportStep, 20);
+	CHECK_EQUAL (controller->channelConfig[1].upRelayPin, 14);
+	CHECK_EQUAL (controller->channelConfig[1].fullTravellingTime, 30000);
+
+	controller->config.curveProfile = CURVE_ROLLER;
+	controller->config.reportStep = 5;
+	controller->config.reportMaxInterval = 120000;
+	CHECK (controller->set ("{\"cmd\":\"time\",\"ch\":1,\"time\":45000}"));
+	CHECK (controller->saveConfig ());
+	delete controller;
+
+	// Stored settings survive a reboot. Pins still come from parameter
+	hw[1].upRelayPin = 16;
+	controller = boot (hw);
+	CHECK_EQUAL (controller->config.curveProfile, CURVE_ROLLER);
+	CHECK_EQUAL (controller->config.reportStep, 5);
+	CHECK_EQUAL (controller->config.reportMaxInterval, 120000);
+	CHECK_EQUAL (controller->channelConfig[0].fullTravellingTime, 30000);
+	CHECK_EQUAL (controller->channelConfig[1].fullTravellingTime, 45000);
+	CHECK_EQUAL (controller->channelConfig[1].upRelayPin, 16);
+	CHECK_EQUAL (controller->channelConfig[1].downRelayPin, 15);
+
+	// Also when setup runs again on the same controller
+	controller->setup (&EnigmaIOTNode, hw);
+	CHECK_EQUAL (controller->config.curveProfile, CURVE_ROLLER);
+	CHECK_EQUAL (controller->config.reportStep, 5);
+	delete controller;
+
+	return checkResult ("setup config");
+}
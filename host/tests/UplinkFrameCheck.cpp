@@ -0,0 +1,84 @@
+/**
+  * @brief Checks that long command responses go through uplink queue as a single frame, are retried and keep their order
+  *
+  * @file UplinkFrameCheck.cpp
+  */
+
+#include "HostCheck.h"
+
+static size_t lastUplinkLength = 0;
+
+static bool measureUplink (const uint8_t* data, size_t length, nodePayloadEncoding_t encoding) {
+	lastUplinkLength = length;
+	return recordUplink (data, length, encoding);
+}
+
+int main () {
+	SPIFFS.begin ();
+	hostSetMillis (1000);
+	CheckController<1>* controller = new CheckController<1> ();
+	controller->setSendData (measureUplink);
+	blindControlerHw_t hw = checkHardware ();
+	controller->loadConfig ();
+	controller->setup (&EnigmaIOTNode, &hw);
+	controller->run (100);
+
+	// Full schedule with longest values
+	for (int id = 1; id <= BLIND_SCHEDULE_SIZE; id++) {
+		char command[128];
+		snprintf (command, sizeof (command), "{\"cmd\":\"sched\",\"id\":%d,\"hhmm\":2359,\"days\":127,\"do\":\"preset\",\"preset\":4,\"jit\":3600,\"prio\":1,\"tz\":-720}", id);
+		CHECK (controller->set (command));
+	}
+	CHECK (uplinkContains ("[8,2359,127,\"preset\",4,3600,0,1]"));
+	printf ("Schedule response: %u bytes\n", (unsigned)lastUplinkLength);
+
+	// Preset response
+	uplinkMessages.clear ();
+	CHECK (controller->set ("{\"cmd\":\"save\",\"id\":4,\"pos\":100}"));
+	CHECK (uplinkContains ("\"presets\":[-1,-1,-1,100]"));
+
+	// Stats with radio busy. Response waits on queue and is retried
+	uplinkMessages.clear ();
+	uplinkFails = true;
+	CHECK (controller->get ("{\"cmd\":\"stats\"}"));
+	CHECK (uplinkMessages.empty ());
+	uplinkFails = false;
+	controller->run (UPLINK_RETRY_PERIOD + 10);
+	CHECK_EQUAL (uplinkMessages.size (), 1);
+	CHECK (uplinkContains ("\"cmd\":\"stats\""));
+	CHECK (uplinkContains ("\"minBlock\""));
+	printf ("Stats response: %u bytes\n", (unsigned)lastUplinkLength);
+
+	// Counters are kept if response could not be sent
+	uplinkFails = true;
+	CHECK (controller->get ("{\"cmd\":\"state\"}"));
+	uplinkFails = false;
+	controller->run (UPLINK_RETRY_PERIOD + 10);
+	controller->setSendData (sendData_cb ());
+	CHECK (!controller->get ("{\"cmd\":\"stats\"}"));
+	controller->setSendData (measureUplink);
+	uplinkMessages.clear ();
+	CHECK (controller->get ("{\"cmd\":\"stats\"}"));
+	CHECK (uplinkContains ("\"fail\":1"));
+	uplinkMessages.clear ();
+	CHECK (controller->get ("{\"cmd\":\"stats\"}"));
+	CHECK (uplinkContains ("\"fail\":0"));
+
+	// Only one long response waits at a time. Short ones keep their place after it
+	uplinkMessages.clear ();
+	uplinkFails = true;
+	CHECK (controller->get ("{\"cmd\":\"sched\"}"));
+	CHECK (!controller->get ("{\"cmd\":\"sched\"}"));
+	CHECK (controller->get ("{\"cmd\":\"state\"}"));
+	uplinkFails = false;
+	controller->run (UPLINK_RETRY_PERIOD + 10);
+	CHECK_EQUAL (uplinkMessages.size (), 2);
+	CHECK (uplinkMessages[0].find ("[8,2359,127,\"preset\",4,3600,0,1]") != std::string::npos);
+	CHECK (uplinkMessages[1].find ("\"state\"") != std::string::npos);
+	CHECK (controller->get ("{\"cmd\":\"stats\"}"));
+	CHECK (uplinkContains ("\"drop\":1"));
+	printf ("Uplink queue: %u bytes\n", (unsigned)sizeof (UplinkQueue));
+
+	delete controller;
+	return checkResult ("uplink frame");
+}
@@ -0,0 +1,304 @@
+/**
+  * @brief Decodes binary debug records sent by a node built with `DEBUG_BINARY_LOG`
+  *
+  * Format strings are not stored on the device, so they are taken from source files. Every `DEBUG_*` call found
+  * on given files or folders is hashed the same way `DebugLog::hash` does on compile time. Text that is not part
+  * of a record, as debug output of other libraries, is copied unchanged.
+  *
+  * Usage: blind_logdecode [--input <capture file>] <source files or folders>...
+  * Input is read from standard input when no capture file is given, so serial port output may be decoded live.
+  *
+  * @file LogDecoder.cpp
+  */
+
+#include <DebugLog.h>
+#include <dirent.h>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct format_t {
+	std::string text;
+	std::string file;
+};
+
+static std::map<uint32_t, format_t> formats;
+
+static std::string baseName (const std::string& path) {
+	size_t slash = path.find_last_of ('/');
+	return slash == std::string::npos ? path : path.substr (slash + 1);
+}
+
+// Reads a C string literal starting at opening quote. Returns its characters as compiler stores them
+static bool readLiteral (const std::string& source, size_t& pos, std::string& text) {
+	if (pos >= source.size () || source[pos] != '"') {
+		return false;
+	}
+	for (pos++; pos < source.size () && source[pos] != '"'; pos++) {
+		char c = source[pos];
+		if (c == '\\' && pos + 1 < source.size ()) {
+			c = source[++pos];
+			switch (c) {
+			case 'n': c = '\n'; break;
+			case 't': c = '\t'; break;
+			case 'r': c = '\r'; break;
+			case '0': c = '\0'; break;
+			default: break; // \\, \", \'
+			}
+		}
+		text += c;
+	}
+	pos++;
+	return true;
+}
+
+static void scanSource (const std::string& path) {
+	static const char* const macros[] = { "DEBUG_VERBOSE", "DEBUG_DBG", "DEBUG_INFO", "DEBUG_WARN", "DEBUG_ERROR" };
+	std::ifstream file (path);
+	std::stringstream content;
+	content << file.rdbuf ();
+	std::string source = content.str ();
+
+	for (const char* macro : macros) {
+		size_t length = strlen (macro);
+		for (size_t pos = source.find (macro); pos != std::string::npos; pos = source.find (macro, pos + length)) {
+			size_t next = source.find_first_not_of (" \t", pos + length);
+			if (next == std::string::npos || source[next] != '(') {
+				continue;
+			}
+			next = source.find_first_not_of (" \t\r\n", next + 1);
+			std::string text;
+			bool found = false;
+			// Adjacent literals are joined by compiler
+			while (next != std::string::npos && readLiteral (source, next, text)) {
+				found = true;
+				next = source.find_first_not_of (" \t\r\n", next);
+			}
+			if (found) {
+				formats[DebugLog::hash (text.c_str ())] = { text, baseName (path) };
+			}
+		}
+	}
+}
+
+static void scanPath (const std::string& path) {
+	DIR* dir = opendir (path.c_str ());
+	if (!dir) {
+		scanSource (path);
+		return;
+	}
+	while (struct dirent* entry = readdir (dir)) {
+		std::string name = entry->d_name;
+		size_t dot = name.find_last_of ('.');
+		std::string extension = dot == std::string::npos ? "" : name.substr (dot);
+		if (extension == ".cpp" || extension == ".h" || extension == ".ino") {
+			scanSource (path + "/" + name);
+		}
+	}
+	closedir (dir);
+}
+
+// Formats one conversion. `spec` holds flags, width and precision without length modifier
+static std::string formatArg (const std::string& spec, char conversion, const uint8_t*& arg, const uint8_t* end) {
+	char output[128];
+	if (arg >= end) {
+		return "<?>";
+	}
+	uint8_t type = *arg++;
+	int64_t integer = 0;
+	double real = 0;
+	std::string text;
+
+	switch (type) {
+	case LOG_ARG_INT32:
+	case LOG_ARG_INT64: {
+		size_t size = type == LOG_ARG_INT32 ? 4 : 8;
+		if (arg + size > end) {
+			return "<?>";
+		}
+		if (size == 4) {
+			int32_t value;
+			memcpy (&value, arg, 4);
+			// Signedness is given by conversion
+			integer = strchr ("di", conversion) ? (int64_t)value : (int64_t)(uint32_t)value;
+		} else {
+			memcpy (&integer, arg, 8);
+		}
+		arg += size;
+		real = integer;
+		break;
+	}
+	case LOG_ARG_FLOAT: {
+		if (arg + 4 > end) {
+			return "<?>";
+		}
+		float value;
+		memcpy (&value, arg, 4);
+		arg += 4;
+		real = value;
+		integer = value;
+		break;
+	}
+	case LOG_ARG_STRING: {
+		if (arg >= end || arg + 1 + *arg > end) {
+			return "<?>";
+		}
+		text.assign ((const char*)arg + 1, *arg);
+		arg += 1 + *arg;
+		break;
+	}
+	default:
+		arg = end; // Unknown type. Rest of arguments cannot be found
+		return "<?>";
+	}
+
+	if (conversion == 's') {
+		if (type != LOG_ARG_STRING) {
+			return "<?>";
+		}
+		snprintf (output, sizeof (output), (spec + "s").c_str (), text.c_str ());
+	} else if (type == LOG_ARG_STRING) {
+		return "<?>";
+	} else if (strchr ("fFeEgGaA", conversion)) {
+		snprintf (output, sizeof (output), (spec + conversion).c_str (), real);
+	} else if (conversion == 'c') {
+		snprintf (output, sizeof (output), (spec + "c").c_str (), (int)integer);
+	} else if (conversion == 'p') {
+		snprintf (output, sizeof (output), "0x%llx", (unsigned long long)integer);
+	} else if (strchr ("di", conversion)) {
+		snprintf (output, sizeof (output), (spec + "ll" + conversion).c_str (), (long long)integer);
+	} else {
+		snprintf (output, sizeof (output), (spec + "ll" + conversion).c_str (), (unsigned long long)integer);
+	}
+	return output;
+}
+
+static std::string formatMessage (const std::string& format, const uint8_t* arg, const uint8_t* end) {
+	std::string message;
+	for (size_t pos = 0; pos < format.size (); pos++) {
+		if (format[pos] != '%') {
+			message += format[pos];
+			continue;
+		}
+		if (pos + 1 < format.size () && format[pos + 1] == '%') {
+			message += '%';
+			pos++;
+			continue;
+		}
+		size_t specEnd = format.find_first_not_of ("-+ #0123456789.*", pos + 1);
+		std::string spec = format.substr (pos, specEnd - pos);
+		size_t conversion = format.find_first_not_of ("hlLqjzt", specEnd);
+		if (conversion == std::string::npos) {
+			break;
+		}
+		message += formatArg (spec, format[conversion], arg, end);
+		pos = conversion;
+	}
+	return message;
+}
+
+// Byte source that lets bytes of a rejected record be read again as text
+class Input {
+public:
+	explicit Input (FILE* file) : file (file) {}
+
+	int get () {
+		if (!pushedBack.empty ()) {
+			int c = pushedBack.front ();
+			pushedBack.pop_front ();
+			return c;
+		}
+		return getc (file);
+	}
+
+	void unget (const std::vector<uint8_t>& bytes) {
+		pushedBack.insert (pushedBack.begin (), bytes.begin (), bytes.end ());
+	}
+
+protected:
+	FILE* file;
+	std::deque<int> pushedBack;
+};
+
+static void printRecord (const std::vector<uint8_t>& record) {
+	uint32_t timestamp, id;
+	uint16_t line;
+	memcpy (&timestamp, record.data () + 1, 4);
+	memcpy (&id, record.data () + 5, 4);
+	memcpy (&line, record.data () + 9, 2);
+	const uint8_t* args = record.data () + 11;
+	const uint8_t* end = record.data () + record.size ();
+
+	if (id == DEBUG_LOG_LOST_ID) {
+		printf ("%c [%u] %s records lost\n", record[0], timestamp, formatMessage ("%u", args, end).c_str ());
+		return;
+	}
+	auto format = formats.find (id);
+	if (format == formats.end ()) {
+		printf ("%c [%u] (line %u) <unknown message %08x>\n", record[0], timestamp, line, id);
+	} else {
+		printf ("%c [%u] (%s:%u) %s\n", record[0], timestamp, format->second.file.c_str (), line, formatMessage (format->second.text, args, end).c_str ());
+	}
+}
+
+int main (int argc, char** argv) {
+	FILE* inputFile = stdin;
+	int sources = 0;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp (argv[i], "--input") && i + 1 < argc) {
+			inputFile = fopen (argv[++i], "rb");
+			if (!inputFile) {
+				fprintf (stderr, "Cannot open %s\n", argv[i]);
+				return 1;
+			}
+		} else {
+			scanPath (argv[i]);
+			sources++;
+		}
+	}
+	if (!sources) {
+		fprintf (stderr, "Usage: %s [--input <capture file>] <source files or folders>...\n", argv[0]);
+		return 2;
+	}
+	fprintf (stderr, "%zu debug messages found\n", formats.size ());
+
+	Input input (inputFile);
+	bool lineStart = true;
+	int c;
+	while ((c = input.get ()) != EOF) {
+		if (c != DEBUG_LOG_START) {
+			putchar (c);
+			lineStart = c == '\n';
+			continue;
+		}
+		int length = input.get ();
+		if (length == EOF) {
+			break;
+		}
+		std::vector<uint8_t> record;
+		for (int i = 0; i <= length && (c = input.get ()) != EOF; i++) {
+			record.push_back (c);
+		}
+		uint8_t checksum = 0;
+		for (int i = 0; i < length && i < (int)record.size (); i++) {
+			checksum += record[i];
+		}
+		if (length < 11 || (int)record.size () != length + 1 || checksum != record.back ()) {
+			// Not a record. Start byte is dropped and following bytes are read again
+			record.insert (record.begin (), (uint8_t)length);
+			input.unget (record);
+			continue;
+		}
+		record.pop_back ();
+		if (!lineStart) {
+			putchar ('\n');
+		}
+		printRecord (record);
+		lineStart = true;
+		fflush (stdout);
+	}
+	return 0;
+}